@@ -15,11 +15,13 @@
 #include <QMessageBox>
 
 #include <cstring>
+#include <atomic>
 
 #include "config.h"
 
 #include <json.h>
 #include <bson.h>
+#include <threadpool.h>
 
 #include <editor/assetconverter.h>
 #include <editor/codebuilder.h>
@@ -27,6 +29,8 @@
 #include <components/scene.h>
 #include <components/actor.h>
 
+#include <resources/material.h>
+
 #include <systems/resourcesystem.h>
 
 #include "animconverter.h"
@@ -41,8 +45,11 @@
 #include "translatorconverter.h"
 #include "mapconverter.h"
 
+#include "importcache.h"
+
 #include "projectmanager.h"
 #include <editor/pluginmanager.h>
+#include <editor/settingsmanager.h>
 
 #include "log.h"
 
@@ -60,6 +67,12 @@ const char *gEntry(".entry");
 const char *gCompany(".company");
 const char *gProject(".project");
 
+const char *gShaderLibrary("ShaderLibrary");
+const char *gShaderLibraryUUID("{00000000-0201-0000-0000-000000000000}");
+
+const char *gImportCache("General/Import/Shared_Cache");
+const char *gImportCacheEnv("THUNDER_IMPORT_CACHE");
+
 AssetManager *AssetManager::m_pInstance = nullptr;
 
 Q_DECLARE_METATYPE(AssetConverterSettings *)
@@ -68,10 +81,79 @@ bool typeLessThan(AssetConverterSettings *left, AssetConverterSettings *right) {
     return left->type() < right->type();
 }
 
+class ImportTask : public Object {
+public:
+    ImportTask(ImportCache *cache, AssetConverter *converter, AssetConverterSettings *settings) :
+            m_pCache(cache),
+            m_pConverter(converter),
+            m_pSettings(settings),
+            m_Result(1),
+            m_Finished(false) {
+
+    }
+
+    void processEvents() override {
+        m_Result = m_pCache->convertFile(m_pConverter, m_pSettings);
+        m_Finished = true;
+    }
+
+    AssetConverterSettings *settings() const {
+        return m_pSettings;
+    }
+
+    uint8_t result() const {
+        return m_Result;
+    }
+
+    bool isFinished() const {
+        return m_Finished;
+    }
+
+protected:
+    ImportCache *m_pCache;
+
+    AssetConverter *m_pConverter;
+
+    AssetConverterSettings *m_pSettings;
+
+    uint8_t m_Result;
+
+    atomic<bool> m_Finished;
+};
+
+class HashTask : public Object {
+public:
+    HashTask(const QList<AssetConverterSettings *> &settings, vector<uint8_t> &result, atomic<int32_t> &index) :
+            m_Settings(settings),
+            m_Result(result),
+            m_Index(index) {
+
+    }
+
+    void processEvents() override {
+        int32_t i;
+        while((i = m_Index++) < m_Settings.size()) {
+            m_Result[i] = AssetManager::isOutdated(m_Settings[i]);
+        }
+    }
+
+protected:
+    const QList<AssetConverterSettings *> &m_Settings;
+
+    vector<uint8_t> &m_Result;
+
+    atomic<int32_t> &m_Index;
+};
+
 AssetManager::AssetManager() :
         m_Indices(static_cast<ResourceSystem *>(Engine::resourceSystem())->indices()),
         m_pDirWatcher(new QFileSystemWatcher(this)),
         m_pFileWatcher(new QFileSystemWatcher(this)),
+        m_pPool(new ThreadPool),
+        m_pCache(new ImportCache),
+        m_ImportStage(0),
+        m_ImportCount(0),
+        m_ImportProcessed(0),
         m_pProjectManager(ProjectManager::instance()),
         m_pTimer(new QTimer(this)),
         m_pEngine(nullptr) {
@@ -101,6 +183,14 @@ AssetManager::AssetManager() :
 }
 
 AssetManager::~AssetManager() {
+    m_ImportQueue.clear();
+    m_pPool->waitForDone();
+    for(auto it : m_ImportTasks) {
+        delete it;
+    }
+    delete m_pPool;
+    delete m_pCache;
+
     delete m_pDirWatcher;
     delete m_pFileWatcher;
 
@@ -143,6 +233,8 @@ void AssetManager::init(Engine *engine) {
     for(auto &it : m_Converters) {
         it->init();
     }
+
+    SettingsManager::instance()->registerProperty(gImportCache, QString());
 }
 
 void AssetManager::checkImportSettings(AssetConverterSettings *settings) {
@@ -234,9 +326,37 @@ bool AssetManager::pushToImport(AssetConverterSettings *settings) {
 
 void AssetManager::reimport() {
     std::sort(m_ImportQueue.begin(), m_ImportQueue.end(), typeLessThan);
-    emit importStarted(m_ImportQueue.size(), tr("Importing resources"));
+    if(!m_pTimer->isActive()) {
+        m_ImportProcessed = 0;
+
+        // Environment variable has the priority to configure the build machines
+        QString cache = qEnvironmentVariable(gImportCacheEnv);
+        if(cache.isEmpty()) {
+            cache = SettingsManager::instance()->property(gImportCache).toString();
+        }
+        m_pCache->setPath(cache);
+        m_pCache->resetStatistics();
+    }
+    m_ImportCount = m_ImportProcessed + m_ImportTasks.size() + m_ImportQueue.size();
+
+    emit importStarted(m_ImportCount, tr("Importing resources"));
+    emit importProgress(m_ImportProcessed, m_ImportCount);
     m_pTimer->start(10);
 }
+/*!
+    Removes all assets which are not started yet from the import queue.
+    Conversions which are already running on the worker threads will be finished.
+*/
+void AssetManager::cancelImport() {
+    for(auto it : m_ImportQueue) {
+        // Forces the asset to be detected as outdated during the next scan
+        it->setHash(QString());
+    }
+    m_ImportQueue.clear();
+    m_ImportCount = m_ImportProcessed + m_ImportTasks.size();
+
+    emit importProgress(m_ImportProcessed, m_ImportCount);
+}
 
 void AssetManager::onBuildSuccessful() {
     CodeBuilder *builder = dynamic_cast<CodeBuilder *>(sender());
@@ -279,6 +399,26 @@ bool AssetManager::isOutdated(AssetConverterSettings *settings) {
     }
     return result;
 }
+/*!
+    Calculates the outdated state for the each item of \a settings in parallel and writes it to \a result.
+*/
+void AssetManager::checkOutdated(const QList<AssetConverterSettings *> &settings, vector<uint8_t> &result) {
+    ThreadPool pool;
+    atomic<int32_t> index(0);
+
+    list<HashTask *> tasks;
+    uint32_t count = MIN(pool.maxThreads(), static_cast<uint32_t>(settings.size()));
+    for(uint32_t i = 0; i < count; i++) {
+        HashTask *task = new HashTask(settings, result, index);
+        tasks.push_back(task);
+        pool.start(*task);
+    }
+    pool.waitForDone();
+
+    for(auto it : tasks) {
+        delete it;
+    }
+}
 
 void AssetManager::removeResource(const QFileInfo &source) {
     QFileInfo src(m_pProjectManager->contentPath() + "/" + source.filePath());
@@ -660,17 +800,105 @@ void AssetManager::dumpBundle() {
     }
 }
 
-void AssetManager::onPerform() {
-    QDir dir(m_pProjectManager->contentPath());
+/*!
+    Collects all shader variants of the imported materials into the single shader library.
+    Vertex variants (Static, Instanced, Skinned, Particle) are combined with the fragment variants (Default, Simple).
+    The identical sources are stored only once, the library is used by the render to warm up programs before the first use.
+*/
+void AssetManager::buildShaderLibrary() {
+    static const list<string> vertices = {"Static", "StaticInst", "Skinned", "Particle"};
+    static const list<string> fragments = {"Shader", "Simple"};
+
+    VariantList shaders;
+    VariantList programs;
+    QHash<QByteArray, int32_t> unique;
+
+    auto source = [&](const Variant &value) {
+        string data = value.toString();
+        if(data.empty()) {
+            return -1;
+        }
+        QByteArray key = QCryptographicHash::hash(QByteArray(data.c_str(), data.size()), QCryptographicHash::Md5);
+        auto it = unique.find(key);
+        if(it != unique.end()) {
+            return it.value();
+        }
+        int32_t index = shaders.size();
+        shaders.push_back(data);
+        unique[key] = index;
+        return index;
+    };
 
-    if(!m_ImportQueue.isEmpty()) {
-        AssetConverterSettings *settings = m_ImportQueue.takeFirst();
+    const string type = Material::metaClass()->name();
+    for(auto &it : m_Indices) {
+        if(it.second.first != type) {
+            continue;
+        }
+        QFile file(m_pProjectManager->importPath() + "/" + it.second.second.c_str());
+        if(!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QByteArray raw = file.readAll();
+        file.close();
 
-        if(!convert(settings)) {
-            QString dst = m_pProjectManager->importPath() + "/" + settings->destination();
-            dir.mkpath(QFileInfo(dst).absoluteDir().absolutePath());
-            QFile::copy(settings->source(), dst);
+        VariantList objects = Bson::load(ByteArray(raw.begin(), raw.end())).toList();
+        if(objects.empty()) {
+            continue;
         }
+        // Material artifact is a single object, the user data is the last field
+        VariantList fields = objects.front().toList();
+        if(fields.size() < 7) {
+            continue;
+        }
+        VariantMap user = fields.back().toMap();
+        for(auto &f : fragments) {
+            auto fragment = user.find(f);
+            if(fragment == user.end()) {
+                continue;
+            }
+            for(auto &v : vertices) {
+                auto vertex = user.find(v);
+                if(vertex == user.end()) {
+                    continue;
+                }
+                int32_t vs = source(vertex->second);
+                int32_t fs = source(fragment->second);
+                if(vs > -1 && fs > -1) {
+                    VariantList program;
+                    program.push_back(it.first);
+                    program.push_back(v);
+                    program.push_back(f);
+                    program.push_back(vs);
+                    program.push_back(fs);
+                    programs.push_back(program);
+                }
+            }
+        }
+    }
+
+    if(programs.empty()) {
+        return;
+    }
+
+    VariantMap library;
+    library[gVersion] = 1;
+    library["Shaders"] = shaders;
+    library["Programs"] = programs;
+
+    ByteArray data = Bson::save(library);
+    QFile file(m_pProjectManager->importPath() + "/" + gShaderLibraryUUID);
+    if(file.open(QIODevice::WriteOnly)) {
+        file.write(reinterpret_cast<const char *>(&data[0]), data.size());
+        file.close();
+
+        m_Indices[gShaderLibrary] = pair<string, string>("", gShaderLibraryUUID);
+        m_Paths[gShaderLibraryUUID] = gShaderLibrary;
+    }
+}
+
+void AssetManager::onPerform() {
+    if(!m_ImportQueue.isEmpty() || !m_ImportTasks.isEmpty()) {
+        performImport();
     } else {
         foreach(CodeBuilder *it, m_Builders) {
             it->rescanSources(ProjectManager::instance()->contentPath());
@@ -682,6 +910,8 @@ void AssetManager::onPerform() {
             }
         }
 
+        buildShaderLibrary();
+
         cleanupBundle();
 
         if(isOutdated()) {
@@ -697,32 +927,112 @@ void AssetManager::onPerform() {
 
         m_pDirWatcher->addPath(m_pProjectManager->contentPath());
         m_Labels.removeDuplicates();
+
+        if(m_pCache->isEnabled() && (m_pCache->hits() + m_pCache->misses()) > 0) {
+            Log(Log::INF) << "Import cache:" << m_pCache->hits() << "hits," << m_pCache->misses() << "misses";
+            m_pCache->resetStatistics();
+        }
+
         emit importFinished();
     }
 }
 
+/*!
+    Imports the assets from the queue.
+    The queue is sorted by the asset type, so the assets are imported by stages in the order of dependencies (textures before materials before prefabs).
+    Assets of the current stage with thread safe converters are converted in parallel on the worker threads,
+    the rest are converted on the main thread one per timer tick. The next stage is started only when the current one is completed.
+*/
+void AssetManager::performImport() {
+    for(auto it = m_ImportTasks.begin(); it != m_ImportTasks.end(); ) {
+        ImportTask *task = *it;
+        if(task->isFinished()) {
+            finishImport(task->settings(), commit(task->settings(), task->result()));
+            delete task;
+            it = m_ImportTasks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if(m_ImportTasks.isEmpty() && !m_ImportQueue.isEmpty()) {
+        m_ImportStage = m_ImportQueue.first()->type();
+    }
+
+    int32_t limit = m_pPool->maxThreads();
+    auto it = m_ImportQueue.begin();
+    while(it != m_ImportQueue.end() && (*it)->type() == m_ImportStage && m_ImportTasks.size() < limit) {
+        AssetConverter *converter = getConverter(*it);
+        if(converter && converter->isThreadSafe()) {
+            Log(Log::INF) << "Converting:" << qPrintable((*it)->source());
+
+            ImportTask *task = new ImportTask(m_pCache, converter, *it);
+            m_ImportTasks.push_back(task);
+            m_pPool->start(*task);
+
+            it = m_ImportQueue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for(it = m_ImportQueue.begin(); it != m_ImportQueue.end() && (*it)->type() == m_ImportStage; ++it) {
+        AssetConverter *converter = getConverter(*it);
+        if(converter == nullptr || !converter->isThreadSafe()) {
+            AssetConverterSettings *settings = *it;
+            m_ImportQueue.erase(it);
+
+            finishImport(settings, convert(settings));
+            break;
+        }
+    }
+}
+/*!
+    Copies the source of asset with \a settings as is in case of it wasn't \a converted and reports the import progress.
+*/
+void AssetManager::finishImport(AssetConverterSettings *settings, bool converted) {
+    if(!converted) {
+        QDir dir(m_pProjectManager->contentPath());
+        QString dst = m_pProjectManager->importPath() + "/" + settings->destination();
+        dir.mkpath(QFileInfo(dst).absoluteDir().absolutePath());
+        QFile::copy(settings->source(), dst);
+    }
+
+    m_ImportProcessed++;
+    emit importProgress(m_ImportProcessed, m_ImportCount);
+}
+
 void AssetManager::onFileChanged(const QString &path, bool force) {
     QFileInfo info(path);
     if(info.exists() && (QString(".") + info.suffix()) != gMetaExt) {
         AssetConverterSettings *settings = fetchSettings(info);
 
-        if(force || isOutdated(settings)) {
-            pushToImport(settings);
-        } else {
-            if(settings->typeName() != gCode) {
-                QString guid = settings->destination();
-                registerAsset(info, guid, settings->typeName());
-                for(const QString &it : settings->subKeys()) {
-                    QString value = settings->subItem(it);
-                    QString path = info.absoluteFilePath() + "/" + it;
-                    registerAsset(path, value, settings->subTypeName(it));
-                }
+        updateFile(info, settings, force || isOutdated(settings));
+    }
+}
+/*!
+    Pushes the asset \a info with \a settings to the import queue if it's \a outdated; otherwise registers the already imported asset.
+*/
+void AssetManager::updateFile(const QFileInfo &info, AssetConverterSettings *settings, bool outdated) {
+    if(outdated) {
+        pushToImport(settings);
+    } else {
+        if(settings->typeName() != gCode) {
+            QString guid = settings->destination();
+            registerAsset(info, guid, settings->typeName());
+            for(const QString &it : settings->subKeys()) {
+                QString value = settings->subItem(it);
+                QString path = info.absoluteFilePath() + "/" + it;
+                registerAsset(path, value, settings->subTypeName(it));
             }
         }
     }
 }
 
 void AssetManager::onDirectoryChanged(const QString &path, bool force) {
+    QList<QFileInfo> files;
+    QList<AssetConverterSettings *> settings;
+
     QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
     while(it.hasNext()) {
         QString item = it.next();
@@ -735,7 +1045,18 @@ void AssetManager::onDirectoryChanged(const QString &path, bool force) {
         }
         m_pFileWatcher->addPath(info.absoluteFilePath());
 
-        onFileChanged(item, force);
+        files.push_back(info);
+        settings.push_back(fetchSettings(info));
+    }
+
+    // Hashing of the sources is the most expensive part of the scan
+    vector<uint8_t> outdated(settings.size(), force);
+    if(!force) {
+        checkOutdated(settings, outdated);
+    }
+
+    for(int32_t i = 0; i < files.size(); i++) {
+        updateFile(files[i], settings[i], outdated[i]);
     }
 }
 
@@ -752,41 +1073,47 @@ AssetConverter *AssetManager::getConverter(AssetConverterSettings *settings) {
 
 
 bool AssetManager::convert(AssetConverterSettings *settings) {
-    QFileInfo info(settings->source());
-    QString format = info.completeSuffix().toLower();
-
-    auto it = m_Converters.find(format);
-    if(it != m_Converters.end()) {
+    AssetConverter *converter = getConverter(settings);
+    if(converter) {
         Log(Log::INF) << "Converting:" << qPrintable(settings->source());
 
-        if(it.value()->convertFile(settings) == 0) {
-            QString guid = settings->destination();
-            QString type = settings->typeName();
-            QString source = settings->source();
-            registerAsset(source, guid, type);
-
-            for(const QString &it : settings->subKeys()) {
-                QString value = settings->subItem(it);
-                QString type = settings->subTypeName(it);
-                QString path = source + "/" + it;
-
-                registerAsset(path, value, settings->subTypeName(it));
+        return commit(settings, m_pCache->convertFile(converter, settings));
+    }
 
-                if(QFileInfo::exists(m_pProjectManager->importPath() + "/" + value)) {
-                    Object *res = Engine::loadResource(value.toStdString());
-                    static_cast<ResourceSystem *>(m_pEngine->resourceSystem())->reloadResource(static_cast<Resource *>(res), true);
-                    emit imported(path, type);
-                }
+    return false;
+}
+/*!
+    Registers the asset with \a settings and reloads the related resources in case of successful conversion \a result.
+    Must be called from the main thread.
+*/
+bool AssetManager::commit(AssetConverterSettings *settings, uint8_t result) {
+    if(result == 0) {
+        QString guid = settings->destination();
+        QString type = settings->typeName();
+        QString source = settings->source();
+        registerAsset(source, guid, type);
+
+        for(const QString &it : settings->subKeys()) {
+            QString value = settings->subItem(it);
+            QString type = settings->subTypeName(it);
+            QString path = source + "/" + it;
+
+            registerAsset(path, value, settings->subTypeName(it));
+
+            if(QFileInfo::exists(m_pProjectManager->importPath() + "/" + value)) {
+                Object *res = Engine::loadResource(value.toStdString());
+                static_cast<ResourceSystem *>(m_pEngine->resourceSystem())->reloadResource(static_cast<Resource *>(res), true);
+                emit imported(path, type);
             }
+        }
 
-            Object *res = Engine::loadResource(guid.toStdString());
-            static_cast<ResourceSystem *>(m_pEngine->resourceSystem())->reloadResource(static_cast<Resource *>(res), true);
-            emit imported(source, type);
+        Object *res = Engine::loadResource(guid.toStdString());
+        static_cast<ResourceSystem *>(m_pEngine->resourceSystem())->reloadResource(static_cast<Resource *>(res), true);
+        emit imported(source, type);
 
-            settings->saveSettings();
+        settings->saveSettings();
 
-            return true;
-        }
+        return true;
     }
 
     return false;
@@ -21,6 +21,10 @@ class ProjectManager;
 
 class CodeBuilder;
 
+class ThreadPool;
+class ImportTask;
+class ImportCache;
+
 struct Template {
     Template() :
         type(MetaType::INVALID) {
@@ -96,6 +100,8 @@ public:
 public slots:
     void reimport();
 
+    void cancelImport();
+
     void onBuildSuccessful();
 
     void checkImportSettings(AssetConverterSettings *settings);
@@ -108,6 +114,7 @@ signals:
 
     void imported(const QString &path, const QString &type);
     void importStarted(int count, const QString &stage);
+    void importProgress(int processed, int count);
     void importFinished();
 
     void prefabCreated(uint32_t uuid, uint32_t clone);
@@ -122,6 +129,8 @@ protected slots:
     void onDirectoryChanged(const QString &path, bool force = false);
 
 private:
+    friend class HashTask;
+
     AssetManager();
     ~AssetManager();
 
@@ -140,6 +149,18 @@ protected:
 
     QList<AssetConverterSettings *> m_ImportQueue;
 
+    QList<ImportTask *> m_ImportTasks;
+
+    ThreadPool *m_pPool;
+
+    ImportCache *m_pCache;
+
+    uint32_t m_ImportStage;
+
+    int m_ImportCount;
+
+    int m_ImportProcessed;
+
     ProjectManager *m_pProjectManager;
 
     QTimer *m_pTimer;
@@ -159,9 +180,18 @@ protected:
     void cleanupBundle();
     void dumpBundle();
 
-    bool isOutdated(AssetConverterSettings *settings);
+    void buildShaderLibrary();
+
+    static bool isOutdated(AssetConverterSettings *settings);
+    void checkOutdated(const QList<AssetConverterSettings *> &settings, vector<uint8_t> &result);
+
+    void updateFile(const QFileInfo &info, AssetConverterSettings *settings, bool outdated);
+
+    void performImport();
+    void finishImport(AssetConverterSettings *settings, bool converted);
 
     bool convert(AssetConverterSettings *settings);
+    bool commit(AssetConverterSettings *settings, uint8_t result);
 
     QString pathToLocal(const QFileInfo &source);
 
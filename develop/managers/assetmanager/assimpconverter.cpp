@@ -33,7 +33,7 @@
 #define HEADER  "Header"
 #define DATA    "Data"
 
-#define FORMAT_VERSION 3
+#define FORMAT_VERSION 4
 
 int32_t indexOf(const aiBone *item, const BonesList &list) {
     int i = 0;
@@ -66,10 +66,8 @@ AssimpImportSettings::AssimpImportSettings() :
         m_Colors(true),
         m_Normals(true),
         m_Animation(true),
-        m_Filter(Keyframe_Reduction),
-        m_PositionError(0.5f),
-        m_RotationError(0.5f),
-        m_ScaleError(0.5f) {
+        m_Filter(Keyframe_Reduction_Quantization),
+        m_ErrorTolerance(0.001f) {
 
     setType(MetaType::type<Prefab *>());
     setVersion(FORMAT_VERSION);
@@ -135,32 +133,12 @@ void AssimpImportSettings::setCustomScale(float value) {
     }
 }
 
-float AssimpImportSettings::positionError() const {
-    return m_PositionError;
+float AssimpImportSettings::errorTolerance() const {
+    return m_ErrorTolerance;
 }
-void AssimpImportSettings::setPositionError(float value) {
-    if(m_PositionError != value) {
-        m_PositionError = value;
-        emit updated();
-    }
-}
-
-float AssimpImportSettings::rotationError() const {
-    return m_RotationError;
-}
-void AssimpImportSettings::setRotationError(float value) {
-    if(m_RotationError != value) {
-        m_RotationError = value;
-        emit updated();
-    }
-}
-
-float AssimpImportSettings::scaleError() const {
-    return m_ScaleError;
-}
-void AssimpImportSettings::setScaleError(float value) {
-    if(m_ScaleError != value) {
-        m_ScaleError = value;
+void AssimpImportSettings::setErrorTolerance(float value) {
+    if(m_ErrorTolerance != value) {
+        m_ErrorTolerance = value;
         emit updated();
     }
 }
@@ -509,115 +487,133 @@ static bool compare(const AnimationTrack &left, const AnimationTrack &right) {
     return left.path() > right.path();
 }
 
-void optimizeVectorTrack(AnimationTrack &track, float threshold) {
-    auto &curves = track.curves();
-    for(uint32_t i = 1; i < curves[0].m_Keys.size() - 1; i++) {
-        Vector3 k0( curves[0].m_Keys[i - 1].m_Value,
-                    curves[1].m_Keys[i - 1].m_Value,
-                    curves[2].m_Keys[i - 1].m_Value);
-
-        Vector3 k1( curves[0].m_Keys[i].m_Value,
-                    curves[1].m_Keys[i].m_Value,
-                    curves[2].m_Keys[i].m_Value);
-
-        Vector3 k2( curves[0].m_Keys[i + 1].m_Value,
-                    curves[1].m_Keys[i + 1].m_Value,
-                    curves[2].m_Keys[i + 1].m_Value);
-
-        Vector3 pd = (k2 - k0);
-        float d0 = pd.dot(k0);
-        float d1 = pd.dot(k1);
-        float d2 = pd.dot(k2);
-        if (d1 < d0 || d1 > d2) {
-            continue;
-        }
-
-        float d = distanceToSegment<Vector3>(k0, k2, k1);
-        if(d > pd.length() * threshold) {
-            continue;
+static Vector4 keyValue(AnimationTrack &track, uint32_t index) {
+    Vector4 result;
+    for(auto &it : track.curves()) {
+        if(it.first < 4) {
+            result[it.first] = it.second.m_Keys[index].m_Value;
         }
+    }
+    return result;
+}
 
-        AnimationCurve::Keys &curve0 = curves[0].m_Keys;
-        curve0.erase(curve0.begin() + i);
-        AnimationCurve::Keys &curve1 = curves[1].m_Keys;
-        curve1.erase(curve1.begin() + i);
-        AnimationCurve::Keys &curve2 = curves[2].m_Keys;
-        curve2.erase(curve2.begin() + i);
-
-        i--;
+static float keyError(const Vector4 &value, const Vector4 &origin, bool quaternion, float extent, float scale) {
+    if(quaternion) {
+        Quaternion q(value.x, value.y, value.z, value.w);
+        q.normalize();
+        float dot = fabsf(q.dot(Quaternion(origin.x, origin.y, origin.z, origin.w)));
+        float angle = 2.0f * acosf(MIN(dot, 1.0f));
+        // Displacement of a virtual vertex on the distance of the bone extent
+        return 2.0f * sinf(angle * 0.5f) * extent * scale;
     }
+    Vector3 delta(value.x - origin.x, value.y - origin.y, value.z - origin.z);
+    return delta.length() * scale;
 }
 
-void optimizeQuaternionTrack(AnimationTrack &track, float threshold) {
+static Vector4 interpolate(const Vector4 &a, const Vector4 &b, float factor, bool quaternion) {
+    float sign = 1.0f;
+    if(quaternion && a.dot(b) < 0.0f) {
+        sign = -1.0f;
+    }
+    return MIX(a, b * sign, factor);
+}
+/*
+    Removes keys which can be restored by interpolation with the error less than tolerance.
+    The error is measured in the world space, rotation and scale errors are measured as displacement of a virtual vertex
+    on the distance of bone \a extent. Parent world scale is taken into account using the \a scale factor.
+*/
+static void reduceTrack(AnimationTrack &track, bool quaternion, float extent, float scale, float tolerance) {
     auto &curves = track.curves();
-    for(uint32_t i = 1; i < curves[0].m_Keys.size() - 1; i++) {
-        Quaternion k0( curves[0].m_Keys[i - 1].m_Value,
-                       curves[1].m_Keys[i - 1].m_Value,
-                       curves[2].m_Keys[i - 1].m_Value,
-                       curves[3].m_Keys[i - 1].m_Value);
-
-        Quaternion k1( curves[0].m_Keys[i].m_Value,
-                       curves[1].m_Keys[i].m_Value,
-                       curves[2].m_Keys[i].m_Value,
-                       curves[3].m_Keys[i].m_Value);
-
-        Quaternion k2( curves[0].m_Keys[i + 1].m_Value,
-                       curves[1].m_Keys[i + 1].m_Value,
-                       curves[2].m_Keys[i + 1].m_Value,
-                       curves[3].m_Keys[i + 1].m_Value);
-
-        if(k0.equal(k2) && !k0.equal(k1)) {
-            continue;
-        }
-
-        Quaternion r1 = (k0.inverse() * k1);
-        Quaternion r0 = (k0.inverse() * k2);
-
-        r1.normalize();
-        r0.normalize();
-
-        Vector3 v0, v1;
-        float a0, a1;
+    if(curves.empty()) {
+        return;
+    }
+    const AnimationCurve::Keys &reference = curves.begin()->second.m_Keys;
+    uint32_t count = reference.size();
+    if(count < 3) {
+        return;
+    }
 
-        r0.axisAngle(v0, a0);
-        r1.axisAngle(v1, a1);
+    vector<Vector4> values(count);
+    vector<float> positions(count);
+    for(uint32_t i = 0; i < count; i++) {
+        values[i] = keyValue(track, i);
+        positions[i] = reference[i].m_Position;
+    }
 
-        if(abs(a0) > threshold) {
-            continue;
+    vector<uint32_t> kept;
+    kept.push_back(0);
+    for(uint32_t i = 1; i < count - 1; i++) {
+        uint32_t prev = kept.back();
+        uint32_t next = i + 1;
+
+        bool removable = true;
+        for(uint32_t j = prev + 1; j < next && removable; j++) {
+            float factor = (positions[j] - positions[prev]) / (positions[next] - positions[prev]);
+            Vector4 v = interpolate(values[prev], values[next], factor, quaternion);
+            removable = keyError(v, values[j], quaternion, extent, scale) <= tolerance;
         }
 
-        if(v1.dot(v0) < 0) {
-            v0 = -v0;
-            a0 = -a0;
+        if(!removable) {
+            kept.push_back(i);
         }
+    }
+    kept.push_back(count - 1);
 
-        v0.normalize();
-        v1.normalize();
-
-        float err01 = acos(v1.dot(v0)) / PI;
-        if (err01 > threshold) { // Not the same axis
-            continue;
+    for(auto &it : curves) {
+        AnimationCurve::Keys keys;
+        keys.reserve(kept.size());
+        for(auto k : kept) {
+            keys.push_back(it.second.m_Keys[k]);
         }
+        it.second.m_Keys = keys;
+    }
+}
+/*
+    Collapses the track to a single key in case of all keys are equal within tolerance.
+    The constant tracks are kept even if they match the bind pose, otherwise the bone animated by the previous clip
+    would keep its pose after the switch.
+*/
+static void collapseConstantTrack(AnimationTrack &track, bool quaternion, float extent, float scale, float tolerance) {
+    auto &curves = track.curves();
+    if(curves.empty() || curves.begin()->second.m_Keys.empty()) {
+        return;
+    }
+    uint32_t count = curves.begin()->second.m_Keys.size();
 
-        if(a1 * a0 < 0) { // Not the same direction
-            continue;
+    Vector4 first = keyValue(track, 0);
+    for(uint32_t i = 1; i < count; i++) {
+        if(keyError(keyValue(track, i), first, quaternion, extent, scale) > tolerance) {
+            return;
         }
+    }
 
-        float tr = a1 / a0;
-        if (tr < 0 || tr > 1) { // Rotating too much or too less
-            continue;
+    for(auto &it : curves) {
+        it.second.m_Keys.resize(1);
+        it.second.m_Keys[0].m_Position = 0.0f;
+    }
+}
+/*
+    Returns the distance from the \a actor to the farthest child in the hierarchy.
+*/
+static float boneExtent(Actor *actor) {
+    float result = 0.0f;
+    Vector3 origin = actor->transform()->worldPosition();
+    for(auto it : actor->findChildren<Actor *>(true)) {
+        Transform *t = it->transform();
+        if(t) {
+            result = MAX(result, (t->worldPosition() - origin).length());
         }
+    }
+    return result;
+}
 
-        AnimationCurve::Keys &curve0 = curves[0].m_Keys;
-        curve0.erase(curve0.begin() + i);
-        AnimationCurve::Keys &curve1 = curves[1].m_Keys;
-        curve1.erase(curve1.begin() + i);
-        AnimationCurve::Keys &curve2 = curves[2].m_Keys;
-        curve2.erase(curve2.begin() + i);
-        AnimationCurve::Keys &curve3 = curves[3].m_Keys;
-        curve3.erase(curve3.begin() + i);
-        i--;
+static float parentScale(Actor *actor) {
+    Transform *parent = actor->transform()->parentTransform();
+    if(parent) {
+        Vector3 scale = parent->worldScale();
+        return MAX(MAX(fabsf(scale.x), fabsf(scale.y)), fabsf(scale.z));
     }
+    return 1.0f;
 }
 
 void AssimpConverter::importAnimation(const aiScene *scene, AssimpImportSettings *fbxSettings) {
@@ -637,6 +633,10 @@ void AssimpConverter::importAnimation(const aiScene *scene, AssimpImportSettings
                 Actor *actor = it->second;
                 string path = pathTo(fbxSettings->m_pRootActor, actor->transform());
 
+                float tolerance = fbxSettings->errorTolerance();
+                float scale = parentScale(actor);
+                float extent = MAX(boneExtent(actor), tolerance);
+
                 if(channel->mNumPositionKeys > 1) {
                     AnimationTrack track;
 
@@ -676,7 +676,8 @@ void AssimpConverter::importAnimation(const aiScene *scene, AssimpImportSettings
                     curves[2] = z;
 
                     if(fbxSettings->filter()) {
-                        optimizeVectorTrack(track, fbxSettings->positionError());
+                        reduceTrack(track, false, extent, scale, tolerance);
+                        collapseConstantTrack(track, false, extent, scale, tolerance);
                     }
 
                     clip.m_Tracks.push_back(track);
@@ -720,7 +721,8 @@ void AssimpConverter::importAnimation(const aiScene *scene, AssimpImportSettings
                     curves[3] = w;
 
                     if(fbxSettings->filter()) {
-                        optimizeQuaternionTrack(track, fbxSettings->rotationError());
+                        reduceTrack(track, true, extent, scale, tolerance);
+                        collapseConstantTrack(track, true, extent, scale, tolerance);
                     }
 
                     clip.m_Tracks.push_back(track);
@@ -761,7 +763,8 @@ void AssimpConverter::importAnimation(const aiScene *scene, AssimpImportSettings
                     curves[2] = z;
 
                     if(fbxSettings->filter()) {
-                        optimizeVectorTrack(track, fbxSettings->scaleError());
+                        reduceTrack(track, false, extent, extent * scale, tolerance);
+                        collapseConstantTrack(track, false, extent, extent * scale, tolerance);
                     }
 
                     clip.m_Tracks.push_back(track);
@@ -771,6 +774,10 @@ void AssimpConverter::importAnimation(const aiScene *scene, AssimpImportSettings
 
         clip.m_Tracks.sort(compare);
 
+        if(fbxSettings->filter() == AssimpImportSettings::Keyframe_Reduction_Quantization) {
+            clip.compress();
+        }
+
         int32_t type = MetaType::type<AnimationClip *>();
         saveData(Bson::save(Engine::toVariant(&clip)), clip.name().c_str(), type, fbxSettings);
     }
@@ -27,15 +27,14 @@ class AssimpImportSettings : public AssetConverterSettings {
 
     Q_PROPERTY(bool Import_Animation READ animation WRITE setAnimation DESIGNABLE true USER true)
     Q_PROPERTY(Compression Compress_Animation READ filter WRITE setFilter DESIGNABLE true USER true)
-    Q_PROPERTY(float Position_Error READ positionError WRITE setPositionError DESIGNABLE true USER true)
-    Q_PROPERTY(float Rotation_Error READ rotationError WRITE setRotationError DESIGNABLE true USER true)
-    Q_PROPERTY(float Scale_Error READ scaleError WRITE setScaleError DESIGNABLE true USER true)
+    Q_PROPERTY(float Error_Tolerance READ errorTolerance WRITE setErrorTolerance DESIGNABLE true USER true)
 
 public:
 
     enum Compression {
         Off = 0,
-        Keyframe_Reduction
+        Keyframe_Reduction,
+        Keyframe_Reduction_Quantization
     };
     Q_ENUM(Compression)
 
@@ -59,14 +58,8 @@ public:
     float customScale() const;
     void setCustomScale(float value);
 
-    float positionError() const;
-    void setPositionError(float value);
-
-    float rotationError() const;
-    void setRotationError(float value);
-
-    float scaleError() const;
-    void setScaleError(float value);
+    float errorTolerance() const;
+    void setErrorTolerance(float value);
 
     Object::ObjectList m_Renders;
 
@@ -91,9 +84,7 @@ protected:
     bool m_Animation;
     Compression m_Filter;
 
-    float m_PositionError;
-    float m_RotationError;
-    float m_ScaleError;
+    float m_ErrorTolerance;
 
 };
 
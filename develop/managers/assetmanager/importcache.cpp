@@ -0,0 +1,251 @@
+#include "importcache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QUuid>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QMetaProperty>
+#include <QCryptographicHash>
+
+#include <editor/assetconverter.h>
+
+#include "projectmanager.h"
+#include "platforms/platform.h"
+
+#define MANIFEST "manifest.json"
+
+namespace {
+    const char *gVersion("version");
+    const char *gFiles("files");
+    const char *gSubItems("subitems");
+}
+
+/*!
+    \class ImportCache
+    \brief Content addressed storage of the converted assets.
+    \internal
+
+    Each entry is keyed by the hash of the source content, import settings, converter version and target platform.
+    The entry contains copies of all produced artifacts and the manifest with the sub items created by the converter.
+    The cache directory can be shared between projects branches and machines (for example over network file system),
+    so the assets which were converted once anywhere are fetched instead of the conversion.
+    Entries are published with directory rename to be safe for concurrent writers.
+*/
+
+ImportCache::ImportCache() :
+        m_Hits(0),
+        m_Misses(0) {
+
+}
+/*!
+    Returns the root directory of the cache.
+*/
+QString ImportCache::path() const {
+    return m_Path;
+}
+/*!
+    Sets the root directory of the cache to \a path. Empty \a path disables the cache.
+*/
+void ImportCache::setPath(const QString &path) {
+    m_Path = path;
+    if(!m_Path.isEmpty()) {
+        QDir().mkpath(m_Path);
+    }
+}
+/*!
+    Returns true if the cache directory is set.
+*/
+bool ImportCache::isEnabled() const {
+    return !m_Path.isEmpty();
+}
+/*!
+    Fetches the artifacts of the asset with \a settings from the cache or converts it with \a converter and stores the result.
+    Returns the \a converter result code; 0 means success.
+    \note This method is thread safe in case of thread safe \a converter.
+*/
+uint8_t ImportCache::convertFile(AssetConverter *converter, AssetConverterSettings *settings) {
+    if(!isEnabled()) {
+        return converter->convertFile(settings);
+    }
+
+    QString hash = key(settings);
+    if(!hash.isEmpty() && fetch(hash, settings)) {
+        m_Hits++;
+        return 0;
+    }
+    m_Misses++;
+
+    uint8_t result = converter->convertFile(settings);
+    if(result == 0 && !hash.isEmpty()) {
+        store(hash, settings);
+    }
+    return result;
+}
+/*!
+    Returns the cache key for the asset with \a settings or empty string if the source can't be read.
+*/
+QString ImportCache::key(AssetConverterSettings *settings) const {
+    QFile file(settings->source());
+    if(!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    file.close();
+
+    QJsonObject set;
+    QObject *object = dynamic_cast<QObject *>(settings);
+    if(object) {
+        const QMetaObject *meta = object->metaObject();
+        for(int i = 0; i < meta->propertyCount(); i++) {
+            QMetaProperty property = meta->property(i);
+            if(QString(property.name()) != "objectName") {
+                set.insert(property.name(), QJsonValue::fromVariant(property.read(object)));
+            }
+        }
+    }
+    hash.addData(QJsonDocument(set).toJson(QJsonDocument::Compact));
+
+    hash.addData(QByteArray::number(settings->type()));
+    hash.addData(QByteArray::number(settings->version()));
+    // Artifacts are named by the asset GUID
+    hash.addData(settings->destination().toUtf8());
+
+    Platform *platform = ProjectManager::instance()->currentPlatform();
+    if(platform) {
+        hash.addData(platform->name().toUtf8());
+    }
+
+    return hash.result().toHex();
+}
+/*!
+    Copies the artifacts for \a key to the import directory and updates \a settings with the cached sub items.
+    Returns true if the entry exists and all artifacts were restored.
+*/
+bool ImportCache::fetch(const QString &key, AssetConverterSettings *settings) {
+    QString entry = entryPath(key);
+
+    QFile manifest(entry + "/" + MANIFEST);
+    if(!manifest.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonObject object = QJsonDocument::fromJson(manifest.readAll()).object();
+    manifest.close();
+
+    QString import = ProjectManager::instance()->importPath();
+    QDir dir(import);
+    for(auto it : object.value(gFiles).toArray()) {
+        QString name = it.toString();
+        QString target = import + "/" + name;
+        dir.mkpath(QFileInfo(target).absolutePath());
+
+        QFile::remove(target);
+        if(!QFile::copy(entry + "/" + name, target)) {
+            return false;
+        }
+    }
+
+    QJsonObject sub = object.value(gSubItems).toObject();
+    for(auto &it : sub.keys()) {
+        QJsonArray array = sub.value(it).toArray();
+        settings->setSubItem(it, array.at(0).toString(), array.at(1).toInt());
+        if(array.size() > 2) {
+            settings->setSubItemData(it, array.at(2).toObject());
+        }
+    }
+    settings->setCurrentVersion(uint32_t(object.value(gVersion).toInt()));
+
+    return true;
+}
+/*!
+    Publishes the artifacts produced for the asset with \a settings to the cache entry with \a key.
+*/
+void ImportCache::store(const QString &key, AssetConverterSettings *settings) {
+    QString entry = entryPath(key);
+    if(QFileInfo::exists(entry + "/" + MANIFEST)) {
+        return;
+    }
+
+    QStringList names = { settings->destination() };
+    for(auto &it : settings->subKeys()) {
+        names.push_back(settings->subItem(it));
+    }
+
+    // The entry is written to the temporary directory first, so readers never see the incomplete entry
+    QString temp = entry + "." + QUuid::createUuid().toString();
+    QDir dir(temp);
+    dir.mkpath(temp);
+
+    QString import = ProjectManager::instance()->importPath();
+    QJsonArray files;
+    for(auto &it : names) {
+        QString source = import + "/" + it;
+        if(!it.isEmpty() && QFileInfo::exists(source)) {
+            QString target = temp + "/" + it;
+            dir.mkpath(QFileInfo(target).absolutePath());
+            if(!QFile::copy(source, target)) {
+                dir.removeRecursively();
+                return;
+            }
+            files.push_back(it);
+        }
+    }
+
+    QJsonObject sub;
+    for(auto &it : settings->subKeys()) {
+        QJsonArray array;
+        array.push_back(settings->subItem(it));
+        array.push_back(settings->subType(it));
+
+        QJsonObject data = settings->subItemData(it);
+        if(!data.isEmpty()) {
+            array.push_back(data);
+        }
+        sub[it] = array;
+    }
+
+    QJsonObject object;
+    object.insert(gVersion, int(settings->currentVersion()));
+    object.insert(gFiles, files);
+    object.insert(gSubItems, sub);
+
+    QFile manifest(temp + "/" + MANIFEST);
+    if(manifest.open(QIODevice::WriteOnly)) {
+        manifest.write(QJsonDocument(object).toJson(QJsonDocument::Indented));
+        manifest.close();
+    }
+
+    if(!QDir().rename(temp, entry)) {
+        // Other writer has published the same entry already
+        dir.removeRecursively();
+    }
+}
+/*!
+    Returns the number of assets which were fetched from the cache since the last resetStatistics() call.
+*/
+int32_t ImportCache::hits() const {
+    return m_Hits;
+}
+/*!
+    Returns the number of assets which were converted since the last resetStatistics() call.
+*/
+int32_t ImportCache::misses() const {
+    return m_Misses;
+}
+/*!
+    Resets the hit and miss counters.
+*/
+void ImportCache::resetStatistics() {
+    m_Hits = 0;
+    m_Misses = 0;
+}
+/*!
+    Returns the directory of the entry with \a key. Entries are distributed by the first two symbols of the key.
+*/
+QString ImportCache::entryPath(const QString &key) const {
+    return m_Path + "/" + key.left(2) + "/" + key;
+}
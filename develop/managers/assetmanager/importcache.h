@@ -0,0 +1,44 @@
+#ifndef IMPORTCACHE_H
+#define IMPORTCACHE_H
+
+#include <QString>
+
+#include <atomic>
+
+class AssetConverter;
+class AssetConverterSettings;
+
+class ImportCache {
+public:
+    ImportCache();
+
+    QString path() const;
+    void setPath(const QString &path);
+
+    bool isEnabled() const;
+
+    uint8_t convertFile(AssetConverter *converter, AssetConverterSettings *settings);
+
+    QString key(AssetConverterSettings *settings) const;
+
+    bool fetch(const QString &key, AssetConverterSettings *settings);
+    void store(const QString &key, AssetConverterSettings *settings);
+
+    int32_t hits() const;
+    int32_t misses() const;
+
+    void resetStatistics();
+
+protected:
+    QString entryPath(const QString &key) const;
+
+private:
+    QString m_Path;
+
+    std::atomic<int32_t> m_Hits;
+
+    std::atomic<int32_t> m_Misses;
+
+};
+
+#endif // IMPORTCACHE_H
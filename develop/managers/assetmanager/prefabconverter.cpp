@@ -5,7 +5,6 @@
 #include <QFile>
 #include <QDebug>
 
-#include <bson.h>
 #include <json.h>
 
 #include <editor/pluginmanager.h>
@@ -57,7 +56,7 @@ uint8_t PrefabConverter::convertFile(AssetConverterSettings *settings) {
 
         QFile file(settings->absoluteDestination());
         if(file.open(QIODevice::WriteOnly)) {
-            ByteArray data = Bson::save(actor);
+            ByteArray data = Engine::toBinary(actor);
             file.write((const char *)&data[0], data.size());
             file.close();
 
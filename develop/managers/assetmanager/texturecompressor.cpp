@@ -0,0 +1,448 @@
+#include "texturecompressor.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    const int32_t etcModifiers[8][4] = {
+        {  2,   8,  -2,   -8 },
+        {  5,  17,  -5,  -17 },
+        {  9,  29,  -9,  -29 },
+        { 13,  42, -13,  -42 },
+        { 18,  60, -18,  -60 },
+        { 24,  80, -24,  -80 },
+        { 33, 106, -33, -106 },
+        { 47, 183, -47, -183 }
+    };
+
+    const int32_t eacModifiers[16][8] = {
+        { -3, -6,  -9, -15, 2, 5, 8, 14 },
+        { -3, -7, -10, -13, 2, 6, 9, 12 },
+        { -2, -5,  -8, -13, 1, 4, 7, 12 },
+        { -2, -4,  -6, -13, 1, 3, 5, 12 },
+        { -3, -6,  -8, -12, 2, 5, 7, 11 },
+        { -3, -7,  -9, -11, 2, 6, 8, 10 },
+        { -4, -7,  -8, -11, 3, 6, 7, 10 },
+        { -3, -5,  -8, -11, 2, 4, 7, 10 },
+        { -2, -6,  -8, -10, 1, 5, 7,  9 },
+        { -2, -5,  -8, -10, 1, 4, 7,  9 },
+        { -2, -4,  -8, -10, 1, 3, 7,  9 },
+        { -2, -5,  -7, -10, 1, 4, 6,  9 },
+        { -3, -4,  -7, -10, 2, 3, 6,  9 },
+        { -1, -2,  -3, -10, 0, 1, 2,  9 },
+        { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+        { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+    };
+}
+
+inline int32_t clampByte(int32_t value) {
+    return CLAMP(value, 0, 255);
+}
+
+inline void writeBigEndian(uint64_t value, uint8_t *result) {
+    for(int32_t i = 0; i < 8; i++) {
+        result[i] = static_cast<uint8_t>(value >> (56 - i * 8));
+    }
+}
+
+inline uint16_t to565(const float color[3]) {
+    int32_t r = CLAMP(static_cast<int32_t>(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int32_t g = CLAMP(static_cast<int32_t>(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int32_t b = CLAMP(static_cast<int32_t>(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+inline void from565(uint16_t color, int32_t result[3]) {
+    int32_t r = (color >> 11) & 31;
+    int32_t g = (color >> 5) & 63;
+    int32_t b = color & 31;
+    result[0] = (r << 3) | (r >> 2);
+    result[1] = (g << 2) | (g >> 4);
+    result[2] = (b << 3) | (b >> 2);
+}
+
+inline int32_t colorError(const uint8_t *pixel, const int32_t color[3]) {
+    int32_t r = pixel[0] - color[0];
+    int32_t g = pixel[1] - color[1];
+    int32_t b = pixel[2] - color[2];
+    return r * r + g * g + b * b;
+}
+
+/*!
+    \class TextureCompressor
+    \brief Block compression of the texture data.
+    \internal
+
+    Encodes RGBA8 images to the formats described by Texture::CompressionType.
+    BC1 and BC3 color endpoints are found along the principal axis of the block colors.
+    ETC2 blocks are encoded using the individual and differential modes, EAC alpha parameters are searched around the block alpha range.
+*/
+
+/*!
+    Compresses the \a rgba image with \a width and \a height dimensions to the \a result using the compression \a method.
+    Edge blocks of images which dimensions are not multiple of four are padded with the border pixels.
+*/
+void TextureCompressor::compress(const uint8_t *rgba, int32_t width, int32_t height, int32_t method, ByteArray &result) {
+    int32_t blocksX = (width + 3) / 4;
+    int32_t blocksY = (height + 3) / 4;
+    int32_t blockSize = (method == Texture::DXT1) ? 8 : 16;
+
+    result.resize(blocksX * blocksY * blockSize);
+
+    uint8_t block[64];
+    for(int32_t by = 0; by < blocksY; by++) {
+        for(int32_t bx = 0; bx < blocksX; bx++) {
+            for(int32_t y = 0; y < 4; y++) {
+                int32_t sy = MIN(by * 4 + y, height - 1);
+                for(int32_t x = 0; x < 4; x++) {
+                    int32_t sx = MIN(bx * 4 + x, width - 1);
+                    const uint8_t *src = &rgba[(sy * width + sx) * 4];
+                    uint8_t *dst = &block[(y * 4 + x) * 4];
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                    dst[3] = src[3];
+                }
+            }
+
+            uint8_t *dst = reinterpret_cast<uint8_t *>(&result[(by * blocksX + bx) * blockSize]);
+            switch(method) {
+                case Texture::DXT1: compressBC1(block, dst); break;
+                case Texture::DXT5: compressBC3(block, dst); break;
+                case Texture::ETC2: compressETC2(block, dst); break;
+                default: break;
+            }
+        }
+    }
+}
+/*!
+    Compresses the 4x4 RGBA \a block to the 8 bytes BC1 \a result. Alpha channel is ignored.
+*/
+void TextureCompressor::compressBC1(const uint8_t *block, uint8_t *result) {
+    compressColorBC(block, result);
+}
+/*!
+    Compresses the 4x4 RGBA \a block to the 16 bytes BC3 \a result.
+*/
+void TextureCompressor::compressBC3(const uint8_t *block, uint8_t *result) {
+    compressAlphaBC(block, result);
+    compressColorBC(block, result + 8);
+}
+/*!
+    Compresses the 4x4 RGBA \a block to the 16 bytes ETC2 RGBA8 (EAC alpha) \a result.
+*/
+void TextureCompressor::compressETC2(const uint8_t *block, uint8_t *result) {
+    compressAlphaEAC(block, result);
+    compressColorETC(block, result + 8);
+}
+
+void TextureCompressor::compressColorBC(const uint8_t *block, uint8_t *result) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for(int32_t i = 0; i < 16; i++) {
+        for(int32_t c = 0; c < 3; c++) {
+            mean[c] += block[i * 4 + c];
+        }
+    }
+    for(int32_t c = 0; c < 3; c++) {
+        mean[c] /= 16.0f;
+    }
+
+    float cov[3][3] = {};
+    for(int32_t i = 0; i < 16; i++) {
+        float d[3];
+        for(int32_t c = 0; c < 3; c++) {
+            d[c] = block[i * 4 + c] - mean[c];
+        }
+        for(int32_t a = 0; a < 3; a++) {
+            for(int32_t b = 0; b < 3; b++) {
+                cov[a][b] += d[a] * d[b];
+            }
+        }
+    }
+    // Principal axis of the colors using the power iteration
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for(int32_t it = 0; it < 8; it++) {
+        float v[3];
+        for(int32_t a = 0; a < 3; a++) {
+            v[a] = cov[a][0] * axis[0] + cov[a][1] * axis[1] + cov[a][2] * axis[2];
+        }
+        float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if(length < FLT_EPSILON) {
+            break;
+        }
+        for(int32_t a = 0; a < 3; a++) {
+            axis[a] = v[a] / length;
+        }
+    }
+
+    float minT = FLT_MAX;
+    float maxT = -FLT_MAX;
+    for(int32_t i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for(int32_t c = 0; c < 3; c++) {
+            t += (block[i * 4 + c] - mean[c]) * axis[c];
+        }
+        minT = MIN(minT, t);
+        maxT = MAX(maxT, t);
+    }
+
+    float c0[3];
+    float c1[3];
+    for(int32_t c = 0; c < 3; c++) {
+        c0[c] = mean[c] + axis[c] * maxT;
+        c1[c] = mean[c] + axis[c] * minT;
+    }
+
+    uint16_t e0 = to565(c0);
+    uint16_t e1 = to565(c1);
+    if(e0 < e1) {
+        std::swap(e0, e1);
+    }
+
+    uint32_t indices = 0;
+    if(e0 != e1) {
+        int32_t palette[4][3];
+        from565(e0, palette[0]);
+        from565(e1, palette[1]);
+        for(int32_t c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for(int32_t i = 0; i < 16; i++) {
+            int32_t best = 0;
+            int32_t error = INT32_MAX;
+            for(int32_t p = 0; p < 4; p++) {
+                int32_t e = colorError(&block[i * 4], palette[p]);
+                if(e < error) {
+                    error = e;
+                    best = p;
+                }
+            }
+            indices |= (best << (i * 2));
+        }
+    }
+
+    result[0] = e0 & 0xff;
+    result[1] = e0 >> 8;
+    result[2] = e1 & 0xff;
+    result[3] = e1 >> 8;
+    for(int32_t i = 0; i < 4; i++) {
+        result[4 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+void TextureCompressor::compressAlphaBC(const uint8_t *block, uint8_t *result) {
+    int32_t a0 = 0;
+    int32_t a1 = 255;
+    for(int32_t i = 0; i < 16; i++) {
+        a0 = MAX(a0, block[i * 4 + 3]);
+        a1 = MIN(a1, block[i * 4 + 3]);
+    }
+
+    uint64_t indices = 0;
+    if(a0 != a1) {
+        int32_t palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        for(int32_t p = 2; p < 8; p++) {
+            palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+        }
+
+        for(int32_t i = 0; i < 16; i++) {
+            int32_t alpha = block[i * 4 + 3];
+            uint64_t best = 0;
+            int32_t error = INT32_MAX;
+            for(int32_t p = 0; p < 8; p++) {
+                int32_t e = abs(alpha - palette[p]);
+                if(e < error) {
+                    error = e;
+                    best = p;
+                }
+            }
+            indices |= (best << (i * 3));
+        }
+    }
+
+    result[0] = a0;
+    result[1] = a1;
+    for(int32_t i = 0; i < 6; i++) {
+        result[2 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+void TextureCompressor::compressAlphaEAC(const uint8_t *block, uint8_t *result) {
+    int32_t amin = 255;
+    int32_t amax = 0;
+    for(int32_t i = 0; i < 16; i++) {
+        amin = MIN(amin, block[i * 4 + 3]);
+        amax = MAX(amax, block[i * 4 + 3]);
+    }
+
+    // Uniform alpha is encoded exactly with the zero modifier of the table 13
+    int32_t bestBase = amin;
+    int32_t bestMultiplier = 1;
+    int32_t bestTable = 13;
+    if(amin != amax) {
+        int32_t bestError = INT32_MAX;
+        for(int32_t t = 0; t < 16; t++) {
+            const int32_t *mods = eacModifiers[t];
+            int32_t low = mods[3];
+            int32_t high = mods[7];
+            int32_t m0 = MAX((amax - amin + (high - low) / 2) / (high - low), 1);
+            for(int32_t m = MAX(m0 - 1, 1); m <= MIN(m0 + 1, 15); m++) {
+                int32_t bases[3] = { amin - low * m, amax - high * m, (amin + amax) / 2 };
+                for(int32_t b = 0; b < 3; b++) {
+                    int32_t base = clampByte(bases[b]);
+                    int32_t error = 0;
+                    for(int32_t i = 0; i < 16 && error < bestError; i++) {
+                        int32_t alpha = block[i * 4 + 3];
+                        int32_t e = INT32_MAX;
+                        for(int32_t p = 0; p < 8; p++) {
+                            int32_t d = alpha - clampByte(base + mods[p] * m);
+                            e = MIN(e, d * d);
+                        }
+                        error += e;
+                    }
+                    if(error < bestError) {
+                        bestError = error;
+                        bestBase = base;
+                        bestMultiplier = m;
+                        bestTable = t;
+                    }
+                }
+            }
+        }
+    }
+
+    uint64_t value = (static_cast<uint64_t>(bestBase) << 56) |
+                     (static_cast<uint64_t>(bestMultiplier) << 52) |
+                     (static_cast<uint64_t>(bestTable) << 48);
+
+    const int32_t *mods = eacModifiers[bestTable];
+    for(int32_t x = 0; x < 4; x++) {
+        for(int32_t y = 0; y < 4; y++) {
+            int32_t alpha = block[(y * 4 + x) * 4 + 3];
+            uint64_t best = 0;
+            int32_t error = INT32_MAX;
+            for(int32_t p = 0; p < 8; p++) {
+                int32_t e = abs(alpha - clampByte(bestBase + mods[p] * bestMultiplier));
+                if(e < error) {
+                    error = e;
+                    best = p;
+                }
+            }
+            value |= best << (45 - (x * 4 + y) * 3);
+        }
+    }
+
+    writeBigEndian(value, result);
+}
+
+void TextureCompressor::compressColorETC(const uint8_t *block, uint8_t *result) {
+    uint64_t bestValue = 0;
+    int32_t bestError = INT32_MAX;
+
+    for(int32_t flip = 0; flip < 2; flip++) {
+        // Sub block pixels, for flip == 0 the block is split vertically (2x4), otherwise horizontally (4x2)
+        int32_t pixels[2][8];
+        int32_t count[2] = {0, 0};
+        float average[2][3] = {};
+        for(int32_t y = 0; y < 4; y++) {
+            for(int32_t x = 0; x < 4; x++) {
+                int32_t sub = (flip) ? (y >= 2) : (x >= 2);
+                int32_t index = y * 4 + x;
+                pixels[sub][count[sub]++] = index;
+                for(int32_t c = 0; c < 3; c++) {
+                    average[sub][c] += block[index * 4 + c];
+                }
+            }
+        }
+
+        int32_t quant[2][3];
+        int32_t base[2][3];
+        bool differential = true;
+        for(int32_t s = 0; s < 2; s++) {
+            for(int32_t c = 0; c < 3; c++) {
+                average[s][c] /= 8.0f;
+                quant[s][c] = CLAMP(static_cast<int32_t>(average[s][c] * 31.0f / 255.0f + 0.5f), 0, 31);
+            }
+        }
+        for(int32_t c = 0; c < 3; c++) {
+            int32_t d = quant[1][c] - quant[0][c];
+            if(d < -4 || d > 3) {
+                differential = false;
+            }
+        }
+
+        uint64_t value = 0;
+        if(differential) {
+            for(int32_t s = 0; s < 2; s++) {
+                for(int32_t c = 0; c < 3; c++) {
+                    base[s][c] = (quant[s][c] << 3) | (quant[s][c] >> 2);
+                }
+            }
+            for(int32_t c = 0; c < 3; c++) {
+                uint64_t d = static_cast<uint64_t>(quant[1][c] - quant[0][c]) & 7;
+                value |= static_cast<uint64_t>(quant[0][c]) << (59 - c * 8);
+                value |= d << (56 - c * 8);
+            }
+            value |= static_cast<uint64_t>(1) << 33;
+        } else {
+            for(int32_t s = 0; s < 2; s++) {
+                for(int32_t c = 0; c < 3; c++) {
+                    int32_t q = CLAMP(static_cast<int32_t>(average[s][c] * 15.0f / 255.0f + 0.5f), 0, 15);
+                    base[s][c] = (q << 4) | q;
+                    value |= static_cast<uint64_t>(q) << (60 - c * 8 - s * 4);
+                }
+            }
+        }
+        value |= static_cast<uint64_t>(flip) << 32;
+
+        int32_t total = 0;
+        for(int32_t s = 0; s < 2; s++) {
+            int32_t subError = INT32_MAX;
+            int32_t subTable = 0;
+            uint32_t subIndices = 0;
+            for(int32_t t = 0; t < 8; t++) {
+                int32_t error = 0;
+                uint32_t indices = 0;
+                for(int32_t i = 0; i < 8; i++) {
+                    int32_t index = pixels[s][i];
+                    int32_t best = 0;
+                    int32_t e = INT32_MAX;
+                    for(int32_t p = 0; p < 4; p++) {
+                        int32_t color[3];
+                        for(int32_t c = 0; c < 3; c++) {
+                            color[c] = clampByte(base[s][c] + etcModifiers[t][p]);
+                        }
+                        int32_t d = colorError(&block[index * 4], color);
+                        if(d < e) {
+                            e = d;
+                            best = p;
+                        }
+                    }
+                    error += e;
+
+                    int32_t bit = (index % 4) * 4 + (index / 4);
+                    indices |= ((best >> 1) << (16 + bit)) | ((best & 1) << bit);
+                }
+                if(error < subError) {
+                    subError = error;
+                    subTable = t;
+                    subIndices = indices;
+                }
+            }
+            total += subError;
+            value |= static_cast<uint64_t>(subTable) << (37 - s * 3);
+            value |= subIndices;
+        }
+
+        if(total < bestError) {
+            bestError = total;
+            bestValue = value;
+        }
+    }
+
+    writeBigEndian(bestValue, result);
+}
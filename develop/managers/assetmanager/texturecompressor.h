@@ -0,0 +1,22 @@
+#ifndef TEXTURECOMPRESSOR_H
+#define TEXTURECOMPRESSOR_H
+
+#include <resources/texture.h>
+
+class TextureCompressor {
+public:
+    static void compress(const uint8_t *rgba, int32_t width, int32_t height, int32_t method, ByteArray &result);
+
+    static void compressBC1(const uint8_t *block, uint8_t *result);
+    static void compressBC3(const uint8_t *block, uint8_t *result);
+    static void compressETC2(const uint8_t *block, uint8_t *result);
+
+private:
+    static void compressColorBC(const uint8_t *block, uint8_t *result);
+    static void compressAlphaBC(const uint8_t *block, uint8_t *result);
+    static void compressAlphaEAC(const uint8_t *block, uint8_t *result);
+    static void compressColorETC(const uint8_t *block, uint8_t *result);
+
+};
+
+#endif // TEXTURECOMPRESSOR_H
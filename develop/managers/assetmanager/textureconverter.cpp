@@ -8,15 +8,22 @@
 #include <QDebug>
 
 #include <cstring>
+#include <cmath>
 
 #include <bson.h>
 #include <engine.h>
+#include <threadpool.h>
 #include <components/actor.h>
 #include <components/spriterender.h>
 #include <resources/resource.h>
 #include <resources/material.h>
 
-#define FORMAT_VERSION 3
+#include "texturecompressor.h"
+
+#include "projectmanager.h"
+#include "platforms/platform.h"
+
+#define FORMAT_VERSION 4
 
 static hash<string> hash_str;
 
@@ -36,6 +43,87 @@ void copyData(int8_t *dst, const uchar *src, uint32_t size, uint8_t channels) {
     }
 }
 
+class CompressTask : public Object {
+public:
+    CompressTask(ByteArray &data, int32_t width, int32_t height, int32_t method) :
+            m_Data(data),
+            m_Width(width),
+            m_Height(height),
+            m_Method(method) {
+
+    }
+
+    void processEvents() override {
+        ByteArray result;
+        TextureCompressor::compress(reinterpret_cast<const uint8_t *>(m_Data.data()), m_Width, m_Height, m_Method, result);
+        m_Data.swap(result);
+    }
+
+protected:
+    ByteArray &m_Data;
+
+    int32_t m_Width;
+
+    int32_t m_Height;
+
+    int32_t m_Method;
+};
+
+struct LinearTable {
+    LinearTable() {
+        for(int32_t i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            values[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+
+    float values[256];
+};
+
+inline float toLinear(uint8_t value) {
+    // Function local static is initialized once even if textures are converted from the several threads
+    static const LinearTable table;
+    return table.values[value];
+}
+
+inline uint8_t toGamma(float value) {
+    float c = (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(CLAMP(c * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+/*!
+    Downsamples the \a src image with \a width and \a height dimensions to the \a dst image with \a dw and \a dh dimensions.
+    Color channels are averaged by the box filter in the linear space, alpha channel is averaged as is.
+*/
+void downsample(const ByteArray &src, int32_t width, int32_t height, uint8_t channels, ByteArray &dst, int32_t dw, int32_t dh) {
+    dst.resize(dw * dh * channels);
+
+    const uint8_t *s = reinterpret_cast<const uint8_t *>(src.data());
+    for(int32_t y = 0; y < dh; y++) {
+        int32_t y0 = y * height / dh;
+        int32_t y1 = MAX((y + 1) * height / dh, y0 + 1);
+        for(int32_t x = 0; x < dw; x++) {
+            int32_t x0 = x * width / dw;
+            int32_t x1 = MAX((x + 1) * width / dw, x0 + 1);
+
+            float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for(int32_t sy = y0; sy < y1; sy++) {
+                for(int32_t sx = x0; sx < x1; sx++) {
+                    const uint8_t *pixel = &s[(sy * width + sx) * channels];
+                    for(uint8_t c = 0; c < channels; c++) {
+                        sum[c] += (c < 3) ? toLinear(pixel[c]) : pixel[c];
+                    }
+                }
+            }
+
+            float count = (x1 - x0) * (y1 - y0);
+            uint8_t *pixel = reinterpret_cast<uint8_t *>(&dst[(y * dw + x) * channels]);
+            for(uint8_t c = 0; c < channels; c++) {
+                pixel[c] = (c < 3) ? toGamma(sum[c] / count) : static_cast<uint8_t>(sum[c] / count + 0.5f);
+            }
+        }
+    }
+}
+
 TextureImportSettings::TextureImportSettings() :
         m_TextureType(TextureType::Texture2D),
         m_FormType(FormatType::Uncompressed_R8G8B8),
@@ -225,9 +313,21 @@ uint8_t TextureConverter::convertFile(AssetConverterSettings *settings) {
 
 void TextureConverter::convertTexture(TextureImportSettings *settings, Texture *texture) {
     uint8_t channels;
+    int32_t compress = Texture::Uncompressed;
     QImage src(settings->source());
     QImage img;
     switch(settings->formatType()) {
+        case TextureImportSettings::FormatType::Compressed: {
+            img = src.convertToFormat(QImage::Format_RGBA8888);
+            channels = 4;
+
+            Platform *platform = ProjectManager::instance()->currentPlatform();
+            if(platform && platform->isEmbedded()) {
+                compress = Texture::ETC2;
+            } else {
+                compress = (src.hasAlphaChannel()) ? Texture::DXT5 : Texture::DXT1;
+            }
+        } break;
         case TextureImportSettings::FormatType::Uncompressed_R8G8B8: {
             img = src.convertToFormat(QImage::Format_RGB32).rgbSwapped();
             channels = 3;
@@ -241,6 +341,7 @@ void TextureConverter::convertTexture(TextureImportSettings *settings, Texture *
     texture->clear();
 
     texture->setFormat((channels == 3) ? Texture::RGB8 : Texture::RGBA8);
+    texture->setCompress(compress);
     texture->setFiltering(Texture::FilteringType(settings->filtering()));
     texture->setWrap(Texture::WrapType(settings->wrap()));
 
@@ -296,12 +397,10 @@ void TextureConverter::convertTexture(TextureImportSettings *settings, Texture *
         sides.push_back(img.mirrored());
     }
 
-    int i = 0;
+    QList<Texture::Surface> surfaces;
     foreach(const QImage &it, sides) {
         Texture::Surface surface;
 
-        VariantList lods;
-
         ByteArray data;
         uint32_t size = it.width() * it.height() * channels;
         if(size) {
@@ -314,23 +413,46 @@ void TextureConverter::convertTexture(TextureImportSettings *settings, Texture *
             /// \todo Specular convolution for cubemaps
             int w = texture->width();
             int h = texture->height();
-            QImage mip = it;
             while(w > 1 || h > 1 ) {
+                int32_t mw = MAX(w / 2, 1);
+                int32_t mh = MAX(h / 2, 1);
+
+                ByteArray mip;
+                downsample(surface.back(), w, h, channels, mip, mw, mh);
+                surface.push_back(mip);
+
+                w = mw;
+                h = mh;
+            }
+        }
+        surfaces.push_back(surface);
+    }
+
+    if(compress != Texture::Uncompressed) {
+        // All sides and mip levels are compressed in parallel
+        ThreadPool pool;
+        list<CompressTask *> tasks;
+        for(auto &surface : surfaces) {
+            int w = texture->width();
+            int h = texture->height();
+            for(auto &level : surface) {
+                CompressTask *task = new CompressTask(level, w, h, compress);
+                tasks.push_back(task);
+                pool.start(*task);
+
                 w = MAX(w / 2, 1);
                 h = MAX(h / 2, 1);
-
-                mip = mip.scaled(w, h, Qt::IgnoreAspectRatio);
-                size = w * h * channels;
-                if(size) {
-                    data.resize(size);
-                    copyData(&data[0], mip.constBits(), size, channels);
-                }
-                surface.push_back(data);
             }
         }
-        texture->addSurface(surface);
+        pool.waitForDone();
+
+        for(auto it : tasks) {
+            delete it;
+        }
+    }
 
-        i++;
+    foreach(const Texture::Surface &it, surfaces) {
+        texture->addSurface(it);
     }
 
     texture->setDirty();
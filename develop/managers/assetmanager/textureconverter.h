@@ -23,6 +23,7 @@ public:
     enum class FormatType {
         Uncompressed_R8G8B8     = Texture::RGB8,
         Uncompressed_R8G8B8A8   = Texture::RGBA8,
+        Compressed              = 0x100
     };
 
     enum class TextureType {
@@ -118,6 +119,8 @@ private:
 
     AssetConverterSettings *createSettings() const Q_DECL_OVERRIDE;
 
+    bool isThreadSafe() const Q_DECL_OVERRIDE { return true; }
+
     Actor *createActor(const QString &guid) const Q_DECL_OVERRIDE;
 };
 
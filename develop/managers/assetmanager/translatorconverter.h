@@ -10,6 +10,7 @@ public:
     QStringList suffixes() const Q_DECL_OVERRIDE { return {"loc"}; }
     uint8_t convertFile(AssetConverterSettings *s) Q_DECL_OVERRIDE;
     AssetConverterSettings *createSettings() const Q_DECL_OVERRIDE;
+    bool isThreadSafe() const Q_DECL_OVERRIDE { return true; }
 };
 
 #endif // TRANSLATORCONVERTER_H
@@ -56,6 +56,10 @@ public:
 
     void                        syncConfiguration           (VariantMap &map) const;
 
+    bool                        makeContextCurrent          (bool current);
+
+    void                        swapBuffers                 ();
+
 protected:
     static void                 keyCallback                 (GLFWwindow *, int, int, int, int);
 
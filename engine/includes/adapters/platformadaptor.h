@@ -65,6 +65,10 @@ public:
 
     virtual void                        syncConfiguration           (VariantMap &map) const { A_UNUSED(map); }
 
+    virtual bool                        makeContextCurrent          (bool current) { A_UNUSED(current); return false; }
+
+    virtual void                        swapBuffers                 () {}
+
 };
 
 #endif // PLATFORMADAPTER_H
@@ -0,0 +1,43 @@
+#ifndef CHUNKSTREAMER_H
+#define CHUNKSTREAMER_H
+
+#include "engine.h"
+
+class Scene;
+class Chunk;
+
+class ChunkStreamerPrivate;
+
+class NEXT_LIBRARY_EXPORT ChunkStreamer {
+public:
+    enum ChunkState {
+        Invalid,
+        Loading,
+        Attaching,
+        Ready,
+        Unloading
+    };
+
+public:
+    explicit ChunkStreamer(Scene *scene);
+    ~ChunkStreamer();
+
+    void load(const string &path, bool additive = true);
+    void unload(Chunk *chunk);
+
+    ChunkState state(const string &path) const;
+    Chunk *chunk(const string &path) const;
+
+    bool isIdle() const;
+
+    float budget() const;
+    void setBudget(float milliseconds);
+
+    void update();
+
+private:
+    ChunkStreamerPrivate *p_ptr;
+
+};
+
+#endif // CHUNKSTREAMER_H
@@ -9,6 +9,7 @@ class Mesh;
 
 class Camera;
 class MaterialInstance;
+class FramePacket;
 
 class NEXT_LIBRARY_EXPORT CommandBuffer: public Object {
     A_REGISTER(CommandBuffer, Object, System)
@@ -50,6 +51,8 @@ public:
 
     virtual void disableScissor();
 
+    virtual void executePacket(const FramePacket &packet);
+
     virtual Matrix4 projection() const;
 
     virtual Matrix4 view() const;
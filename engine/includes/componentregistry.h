@@ -0,0 +1,93 @@
+#ifndef COMPONENTREGISTRY_H
+#define COMPONENTREGISTRY_H
+
+#include <unordered_map>
+
+#include "engine.h"
+
+class Scene;
+class Component;
+
+class NEXT_LIBRARY_EXPORT ComponentRegistry {
+public:
+    class NEXT_LIBRARY_EXPORT Pool {
+    public:
+        uint32_t size() const { return static_cast<uint32_t>(m_Components.size()); }
+
+        Component *at(uint32_t index) const { return m_Components[index]; }
+
+        Scene *scene(uint32_t index) const { return m_Scenes[index]; }
+
+        ObjectSystem *system(uint32_t index) const { return m_Systems[index]; }
+
+        bool isEnabled(uint32_t index) const { return m_Enabled[index]; }
+
+        bool isVisible(uint32_t index) const { return m_Visible[index]; }
+
+        bool isActive(uint32_t index) const { return m_Enabled[index] && m_Visible[index]; }
+
+    private:
+        friend class ComponentRegistry;
+
+        void insert(Component *component, ObjectSystem *system);
+        void remove(Component *component);
+        void update(Component *component, Scene *scene, bool enabled, bool visible);
+
+        vector<Component *> m_Components;
+
+        vector<Scene *> m_Scenes;
+
+        vector<ObjectSystem *> m_Systems;
+
+        vector<bool> m_Enabled;
+
+        vector<bool> m_Visible;
+
+        unordered_map<Component *, uint32_t> m_Indices;
+
+    };
+
+    class NEXT_LIBRARY_EXPORT Deferred {
+    public:
+        Deferred();
+        ~Deferred();
+
+        void begin();
+        void end();
+
+        bool commit(uint32_t count);
+
+        void clear();
+
+        uint32_t size() const { return static_cast<uint32_t>(m_Components.size()); }
+
+    private:
+        friend class ComponentRegistry;
+
+        void capture(Component *component, ObjectSystem *system);
+        bool release(Component *component);
+
+        vector<pair<Component *, ObjectSystem *>> m_Components;
+
+        unordered_map<Component *, uint32_t> m_Indices;
+
+        Deferred *m_pPrevious;
+
+    };
+
+public:
+    static Pool &pool(const MetaObject *meta);
+
+    template<typename T>
+    static Pool &pool() {
+        return pool(T::metaClass());
+    }
+
+    static void registerComponent(Component *component, ObjectSystem *system);
+    static void unregisterComponent(Component *component);
+
+    static void updateComponent(Component *component);
+
+};
+
+#endif // COMPONENTREGISTRY_H
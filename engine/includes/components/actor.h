@@ -75,9 +75,15 @@ private:
 
     void setHierarchyEnabled(bool enabled);
 
+    void resetToPrefab();
+
+    void updateScene();
+
 private:
     friend class ActorPrivate;
     friend class ActorTest;
+    friend class PrefabPool;
+    friend class Chunk;
 
     ActorPrivate *p_ptr;
 
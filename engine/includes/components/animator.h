@@ -12,7 +12,8 @@ class NEXT_LIBRARY_EXPORT Animator : public NativeBehaviour {
     A_REGISTER(Animator, NativeBehaviour, Components/Animation)
 
     A_PROPERTIES(
-        A_PROPERTYEX(AnimationStateMachine *, stateMachine, Animator::stateMachine, Animator::setStateMachine, "editor=Template")
+        A_PROPERTYEX(AnimationStateMachine *, stateMachine, Animator::stateMachine, Animator::setStateMachine, "editor=Template"),
+        A_PROPERTY(bool, lod, Animator::isLodEnabled, Animator::setLodEnabled)
     )
 
     A_METHODS(
@@ -29,6 +30,15 @@ class NEXT_LIBRARY_EXPORT Animator : public NativeBehaviour {
         A_METHOD(int, Animator::duration)
     )
 
+public:
+    enum LodLevel {
+        Full = 0,
+        Reduced,
+        Minimal,
+        Culled,
+        LodCount
+    };
+
 public:
     Animator();
     ~Animator();
@@ -36,6 +46,9 @@ public:
     AnimationStateMachine *stateMachine() const;
     void setStateMachine(AnimationStateMachine *resource);
 
+    bool isLodEnabled() const;
+    void setLodEnabled(bool enabled);
+
     uint32_t position() const;
     void setPosition(uint32_t position);
 
@@ -60,6 +73,10 @@ public:
 
     void rebind();
 
+    static void processBatch();
+
+    static uint32_t lodStatistics(int32_t lod);
+
 private:
     void start() override;
     void update() override;
@@ -67,6 +84,8 @@ private:
     void loadUserData(const VariantMap &data) override;
     VariantMap saveUserData() const override;
 
+    void onReferenceDestroyed() override;
+
 private:
     AnimatorPrivate *p_ptr;
 
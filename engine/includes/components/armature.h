@@ -11,7 +11,8 @@ class NEXT_LIBRARY_EXPORT Armature : public Renderable {
     A_REGISTER(Armature, NativeBehaviour, Components/Animation);
 
     A_PROPERTIES(
-        A_PROPERTYEX(Pose *, bindPose, Armature::bindPose, Armature::setBindPose, "editor=Template")
+        A_PROPERTYEX(Pose *, bindPose, Armature::bindPose, Armature::setBindPose, "editor=Template"),
+        A_PROPERTY(bool, dualQuaternion, Armature::dualQuaternion, Armature::setDualQuaternion)
     )
     A_NOMETHODS()
 
@@ -22,6 +23,9 @@ public:
     Pose *bindPose() const;
     void setBindPose(Pose *pose);
 
+    bool dualQuaternion() const;
+    void setDualQuaternion(bool enabled);
+
 private:
     void update() override;
 
@@ -30,6 +34,8 @@ private:
 
     Texture *texture() const;
 
+    const Vector4 &params() const;
+
     AABBox recalcBounds(const AABBox &aabb) const;
 
 #ifdef NEXT_SHARED
@@ -18,6 +18,8 @@ public:
     Resource *resource() const;
     void setResource(Resource *resource);
 
+    void setParent(Object *parent, int32_t position = -1, bool force = false) override;
+
 private:
     Resource *m_resource;
 
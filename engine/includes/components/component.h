@@ -44,6 +44,8 @@ public:
 
     virtual bool isPostProcessVolume() const;
 
+    void setParent(Object *parent, int32_t position = -1, bool force = false) override;
+
 private:
     bool isSerializable() const override;
 
@@ -3,10 +3,25 @@
 
 #include <propertyanimation.h>
 
+#include "resources/animationclip.h"
+
+class Transform;
+
 class BaseAnimationBlender : public PropertyAnimation {
+public:
+    enum Channel {
+        Generic,
+        Position,
+        Rotation,
+        Orientation,
+        Scale
+    };
+
 public:
     BaseAnimationBlender();
 
+    void setTarget(Object *object, const char *property);
+
     void setOffset(float offset);
 
     void setTransitionTime(float time);
@@ -21,13 +36,47 @@ public:
 
     void setPreviousDuration(int32_t duration);
 
+    void setTrack(const AnimationClip *clip, const AnimationClip::CompiledTrack *track);
+
+    void setPreviousTrack(const AnimationClip *clip, const AnimationClip::CompiledTrack *track);
+
+    bool isDirect() const;
+
+    bool isLeaf() const;
+
+    void apply();
+
+    void evaluate();
+
+    void interpolate(float factor);
+
 private:
     float mix(float value, int32_t component, float position);
 
     Quaternion mix(Quaternion &value, float position);
 
+    void sample(const AnimationClip *clip, const AnimationClip::CompiledTrack *track, float position, float *result) const;
+
     unordered_map<int32_t, AnimationCurve *> m_PrevCurve;
 
+    const AnimationClip *m_pClip;
+    const AnimationClip::CompiledTrack *m_pTrack;
+
+    const AnimationClip *m_pPrevClip;
+    const AnimationClip::CompiledTrack *m_pPrevTrack;
+
+    Transform *m_pTransform;
+
+    Channel m_Channel;
+
+    float m_Default[4];
+
+    float m_Source[4];
+
+    float m_Target[4];
+
+    float m_Time;
+
     float m_Factor;
     float m_Offset;
     float m_TransitionTime;
@@ -35,6 +84,10 @@ private:
     uint32_t m_PrevDuration;
 
     uint32_t m_PreviousTime;
+
+    bool m_Leaf;
+
+    bool m_Sampled;
 };
 
 #endif //BASEANIMATIONBLENDER_H
@@ -93,6 +93,8 @@ public:
     virtual uint8_t convertFile(AssetConverterSettings *settings) = 0;
     virtual AssetConverterSettings *createSettings() const = 0;
 
+    virtual bool isThreadSafe() const;
+
     virtual QString templatePath() const;
     virtual QString iconPath() const;
 
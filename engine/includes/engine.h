@@ -15,6 +15,8 @@ class EnginePrivate;
 class Actor;
 class Scene;
 class Chunk;
+class ChunkStreamer;
+class SystemScheduler;
 class System;
 class PlatformAdaptor;
 
@@ -71,6 +73,8 @@ public:
 
     static void                 unloadSceneChunk            (Chunk *chunk);
 
+    static ChunkStreamer       *chunkStreamer               ();
+
 /*
     Misc
 */
@@ -90,12 +94,15 @@ public:
 
     static void                 addModule                   (Module *module);
 
+    static SystemScheduler     *scheduler                   ();
+
     static string               applicationName             ();
 
     static string               organizationName            ();
 
     static void                 setResource                 (Object *object, const string &uuid);
 
+    static PlatformAdaptor     *platformAdaptor             ();
     static void                 setPlatformAdaptor          (PlatformAdaptor *platform);
 
     static Actor               *composeActor                (const string &component, const string &name, Object *parent = nullptr);
@@ -0,0 +1,84 @@
+#ifndef FRAMEPACKET_H
+#define FRAMEPACKET_H
+
+#include "commandbuffer.h"
+
+class FramePacketPrivate;
+
+class NEXT_LIBRARY_EXPORT FramePacket {
+public:
+    FramePacket();
+    ~FramePacket();
+
+    void clear();
+
+    uint32_t size() const;
+
+    void replay(CommandBuffer &buffer) const;
+
+private:
+    friend class FrameRecorder;
+
+    FramePacketPrivate *p_ptr;
+
+};
+
+class NEXT_LIBRARY_EXPORT FrameRecorder : public CommandBuffer {
+public:
+    explicit FrameRecorder(CommandBuffer *target);
+
+    CommandBuffer *target() const;
+
+    FramePacket *packet() const;
+    void setPacket(FramePacket *packet);
+
+    void clearRenderTarget(bool clearColor = true, const Vector4 &color = Vector4(0.0f), bool clearDepth = true, float depth = 1.0f) override;
+
+    void drawMesh(const Matrix4 &model, Mesh *mesh, uint32_t sub, uint32_t layer = CommandBuffer::DEFAULT, MaterialInstance *material = nullptr) override;
+
+    void drawMeshInstanced(const Matrix4 *models, uint32_t count, Mesh *mesh, uint32_t sub, uint32_t layer = CommandBuffer::DEFAULT, MaterialInstance *material = nullptr) override;
+
+    void setRenderTarget(RenderTarget *target, uint32_t level = 0) override;
+
+    void setColor(const Vector4 &color) override;
+
+    void resetViewProjection() override;
+
+    void setViewProjection(const Matrix4 &view, const Matrix4 &projection) override;
+
+    void setGlobalValue(const char *name, const Variant &value) override;
+
+    void setGlobalTexture(const char *name, Texture *value) override;
+
+    void setViewport(int32_t x, int32_t y, int32_t width, int32_t height) override;
+
+    void enableScissor(int32_t x, int32_t y, int32_t width, int32_t height) override;
+
+    void disableScissor() override;
+
+    void executePacket(const FramePacket &packet) override;
+
+    Matrix4 projection() const override;
+
+    Matrix4 view() const override;
+
+    Texture *texture(const char *name) const override;
+
+private:
+    CommandBuffer *m_pTarget;
+
+    FramePacket *m_pPacket;
+
+    Matrix4 m_View;
+
+    Matrix4 m_Projection;
+
+    Matrix4 m_SaveView;
+
+    Matrix4 m_SaveProjection;
+
+    unordered_map<string, Texture *> m_Textures;
+
+};
+
+#endif // FRAMEPACKET_H
@@ -0,0 +1,32 @@
+#ifndef PREFABPOOL_H
+#define PREFABPOOL_H
+
+#include "engine.h"
+
+class Actor;
+class Prefab;
+
+class PrefabPoolPrivate;
+
+class NEXT_LIBRARY_EXPORT PrefabPool {
+public:
+    explicit PrefabPool(Prefab *prefab, uint32_t capacity = 0);
+    ~PrefabPool();
+
+    Prefab *prefab() const;
+
+    void reserve(uint32_t count);
+
+    Actor *acquire(Object *parent = nullptr);
+    void release(Actor *actor);
+
+    uint32_t size() const;
+    uint32_t available() const;
+    uint32_t active() const;
+
+private:
+    PrefabPoolPrivate *p_ptr;
+
+};
+
+#endif // PREFABPOOL_H
@@ -58,14 +58,74 @@ class NEXT_LIBRARY_EXPORT AnimationClip : public Resource {
     )
 
 public:
+    enum TrackFormat {
+        Sampled,
+        Quantized,
+        SmallestThree
+    };
+
+    struct CompiledTrack {
+        int32_t hash;
+
+        int32_t format;
+
+        int32_t components;
+
+        int32_t frames;
+
+        int32_t duration;
+
+        uint32_t offset;
+
+        uint32_t times;
+
+        float min[4];
+
+        float range[4];
+    };
+    typedef vector<CompiledTrack> CompiledTracks;
+
+public:
+    AnimationClip();
+
     int duration() const;
 
+    void compile();
+
+    bool isCompressed() const;
+    void compress();
+
+    const CompiledTracks &compiledTracks() const;
+
+    const CompiledTrack *compiledTrack(int32_t hash) const;
+
+    void sample(const CompiledTrack &track, float position, float *result) const;
+
 public:
     AnimationTrackList m_Tracks;
 
     void loadUserData(const VariantMap &data) override;
     VariantMap saveUserData() const override;
 
+private:
+    void loadCompressed(const VariantList &data);
+    VariantList saveCompressed() const;
+
+    void compileTrack(AnimationTrack &track);
+
+    void keyRange(const CompiledTrack &track, float position, int32_t &a, int32_t &b, float &factor) const;
+
+private:
+    CompiledTracks m_Compiled;
+
+    vector<float> m_Samples;
+
+    vector<uint16_t> m_Data;
+
+    vector<uint16_t> m_Times;
+
+    bool m_Compressed;
+
 };
 
 #endif // ANIMATIONCLIP_H
@@ -13,6 +13,7 @@ class NEXT_LIBRARY_EXPORT Font : public Sprite {
         A_METHOD(int, Font::atlasIndex),
         A_METHOD(int, Font::requestKerning),
         A_METHOD(void, Font::requestCharacters),
+        A_METHOD(bool, Font::commitGlyphs),
         A_METHOD(int, Font::length),
         A_METHOD(float, Font::spaceWidth),
         A_METHOD(float, Font::lineHeight)
@@ -26,8 +27,12 @@ public:
 
     int requestKerning(int glyph, int previous) const;
 
+    uint32_t revision() const;
+
     void requestCharacters(const string &characters);
 
+    bool commitGlyphs();
+
     int length(const string &characters) const;
 
     float spaceWidth() const;
@@ -50,6 +50,7 @@ public:
     RenderTarget *defaultTarget();
 
     CommandBuffer *buffer() const;
+    void setBuffer(CommandBuffer *buffer);
 
     RenderTarget *requestShadowTiles(uint32_t id, uint32_t lod, int32_t *x, int32_t *y, int32_t *w, int32_t *h, uint32_t count);
 
@@ -69,7 +70,7 @@ protected:
     void cleanShadowCache();
     void updateShadows(Camera &camera);
 
-    void combineComponents(Object *object, bool update);
+    void combineComponents(Scene *scene, bool update);
 
 protected:
     typedef map<string, Texture *> BuffersMap;
@@ -2,6 +2,7 @@
 #define SYSTEM_H
 
 #include <string>
+#include <list>
 #include <stdint.h>
 
 #include <objectsystem.h>
@@ -16,6 +17,13 @@ public:
         Pool
     };
 
+    enum Stage {
+        Simulation = 0,
+        Presentation
+    };
+
+    typedef list<const MetaObject *> TypeList;
+
 public:
     System();
 
@@ -27,6 +35,12 @@ public:
 
     virtual int threadPolicy() const = 0;
 
+    virtual int stage() const;
+
+    const TypeList &reads() const;
+
+    const TypeList &writes() const;
+
     virtual void syncSettings() const;
 
     virtual void composeComponent(Component *component) const;
@@ -35,9 +49,25 @@ public:
 
     void processEvents() override;
 
+protected:
+    template<typename T>
+    void addRead() {
+        m_Reads.push_back(T::metaClass());
+    }
+
+    template<typename T>
+    void addWrite() {
+        m_Writes.push_back(T::metaClass());
+    }
+
 protected:
     Scene *m_pScene;
 
+private:
+    TypeList m_Reads;
+
+    TypeList m_Writes;
+
 };
 
 #endif // SYSTEM_H
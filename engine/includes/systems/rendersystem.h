@@ -7,6 +7,7 @@ class RenderSystemPrivate;
 
 class Renderable;
 class PostProcessSettings;
+class Pipeline;
 
 #if defined(NEXT_SHARED)
 class QWindow;
@@ -23,10 +24,21 @@ public:
 
     int threadPolicy() const override;
 
+    int stage() const override;
+
     const char *name() const override;
 
     void composeComponent(Component *component) const override;
 
+    void syncSettings() const override;
+
+    bool isThreaded() const;
+    void setThreaded(bool threaded);
+
+    static void synchronize();
+
+    static uint32_t frameIndex();
+
 #if defined(NEXT_SHARED)
     virtual QWindow *createRhiWindow() const;
 
@@ -38,7 +50,13 @@ public:
 protected:
     static void setAtlasPageSize(int32_t width, int32_t height);
 
+    virtual void beginFrame(Pipeline *pipeline);
+
+    virtual void endFrame(Pipeline *pipeline);
+
 private:
+    friend class RenderSystemPrivate;
+
     RenderSystemPrivate *p_ptr;
 
 };
@@ -0,0 +1,34 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+#include "engine.h"
+
+class System;
+
+class SystemSchedulerPrivate;
+
+class NEXT_LIBRARY_EXPORT SystemScheduler {
+public:
+    SystemScheduler();
+    ~SystemScheduler();
+
+    void addSystem(System *system);
+
+    const list<System *> &systems() const;
+
+    bool dependsOn(System *system, System *dependency) const;
+
+    bool isPipelined() const;
+    void setPipelined(bool pipelined);
+
+    uint32_t maxThreads() const;
+    void setMaxThreads(uint32_t value);
+
+    void execute(Scene *scene);
+
+private:
+    SystemSchedulerPrivate *p_ptr;
+
+};
+
+#endif // SYSTEMSCHEDULER_H
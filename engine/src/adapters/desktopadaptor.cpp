@@ -92,7 +92,10 @@ bool DesktopAdaptor::init() {
 }
 
 void DesktopAdaptor::update() {
-    glfwSwapBuffers(m_pWindow);
+    // The render thread presents the frames when it owns the context
+    if(glfwGetCurrentContext() == m_pWindow) {
+        glfwSwapBuffers(m_pWindow);
+    }
 
     s_inputString.clear();
 
@@ -201,6 +204,18 @@ void DesktopAdaptor::stop() {
     glfwTerminate();
 }
 
+bool DesktopAdaptor::makeContextCurrent(bool current) {
+    glfwMakeContextCurrent((current) ? m_pWindow : nullptr);
+    if(current) {
+        glfwSwapInterval(s_vSync);
+    }
+    return true;
+}
+
+void DesktopAdaptor::swapBuffers() {
+    glfwSwapBuffers(m_pWindow);
+}
+
 void DesktopAdaptor::destroy() {
 
 }
@@ -372,7 +387,9 @@ void DesktopAdaptor::syncConfiguration(VariantMap &map) const {
     glfwGetWindowPos(m_pWindow, &x, &y);
     glfwSetWindowMonitor(m_pWindow, (s_Windowed) ? nullptr : m_pMonitor, x, y, s_Width, s_Height, GLFW_DONT_CARE);
 
-    glfwSwapInterval(s_vSync);
+    if(glfwGetCurrentContext() == m_pWindow) {
+        glfwSwapInterval(s_vSync);
+    }
 
     _FILE *fp = g_pFile->fopen(CONFIG_NAME, "w");
     if(fp) {
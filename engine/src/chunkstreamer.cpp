@@ -0,0 +1,374 @@
+#include "chunkstreamer.h"
+
+#include "components/scene.h"
+#include "components/chunk.h"
+
+#include "resources/map.h"
+
+#include "componentregistry.h"
+#include "timer.h"
+
+#include <threadpool.h>
+#include <log.h>
+
+#define DEFAULT_BUDGET  2.0f
+#define COMMIT_BATCH    64
+
+class ChunkStreamerPrivate : public Object {
+public:
+    struct Request {
+        string path;
+
+        ChunkStreamer::ChunkState state;
+
+        bool additive;
+
+        Map *map;
+
+        Chunk *chunk;
+
+        Object::ObjectList pending;
+
+        ComponentRegistry::Deferred components;
+    };
+
+    explicit ChunkStreamerPrivate(Scene *scene) :
+            m_pScene(scene),
+            m_Budget(DEFAULT_BUDGET),
+            m_Running(false) {
+
+        m_Pool.setMaxThreads(1);
+    }
+    /*!
+        Loads the requested maps on the worker thread into the detached hierarchies.
+    */
+    void processEvents() override {
+        PROFILE_FUNCTION();
+        while(true) {
+            Request *request = nullptr;
+            {
+                unique_lock<mutex> locker(m_Mutex);
+                if(m_Queue.empty()) {
+                    m_Running = false;
+                    return;
+                }
+                request = m_Queue.front();
+                m_Queue.pop_front();
+            }
+
+            // Components of the new hierarchy must not appear in the pools until the main thread attaches them
+            request->components.begin();
+
+            Map *map = Engine::loadResource<Map>(request->path);
+            Chunk *chunk = (map) ? map->chunk() : nullptr;
+            if(chunk && chunk->parent() == map) {
+                request->pending = chunk->getChildren();
+                for(auto it : request->pending) {
+                    it->setParent(nullptr);
+                }
+            }
+
+            request->components.end();
+
+            request->map = map;
+            request->chunk = chunk;
+            {
+                unique_lock<mutex> locker(m_Mutex);
+                m_Loaded.push_back(request);
+            }
+        }
+    }
+    /*!
+        Makes one step of the attachment for the \a request. Returns true when the chunk is completely attached.
+    */
+    bool attach(Request *request) {
+        if(!request->components.commit(COMMIT_BATCH)) {
+            return false;
+        }
+        if(request->chunk->parent() != m_pScene) {
+            request->chunk->setParent(m_pScene);
+        }
+        if(!request->pending.empty()) {
+            Object *object = request->pending.front();
+            request->pending.pop_front();
+            object->setParent(request->chunk);
+            return false;
+        }
+        request->state = ChunkStreamer::Ready;
+        return true;
+    }
+    /*!
+        Makes one step of the unloading for the \a request. Returns true when the chunk is completely unloaded.
+    */
+    bool detach(Request *request) {
+        const Object::ObjectList &children = request->chunk->getChildren();
+        if(!children.empty()) {
+            delete children.front();
+            return false;
+        }
+
+        Chunk *chunk = request->chunk;
+        Map *map = dynamic_cast<Map *>(chunk->resource());
+        Engine::unloadSceneChunk(chunk);
+        if(map) {
+            map->setChunk(nullptr);
+        }
+        delete chunk;
+
+        request->chunk = nullptr;
+        request->state = ChunkStreamer::Invalid;
+        return true;
+    }
+    /*!
+        Drops the objects of the \a request which are not attached to the scene yet.
+    */
+    void discard(Request *request) {
+        request->components.clear();
+        for(auto it : request->pending) {
+            delete it;
+        }
+        request->pending.clear();
+    }
+
+    Request *find(const string &path) const {
+        // The latest request wins, the chunk can be requested again while its previous copy is unloading
+        for(auto it = m_Requests.rbegin(); it != m_Requests.rend(); ++it) {
+            if((*it)->path == path) {
+                return *it;
+            }
+        }
+        return nullptr;
+    }
+
+    Request *find(Chunk *chunk) const {
+        for(auto it : m_Requests) {
+            if(it->chunk == chunk) {
+                return it;
+            }
+        }
+        return nullptr;
+    }
+
+    Scene *m_pScene;
+
+    list<Request *> m_Requests;
+
+    list<Request *> m_Queue;
+
+    list<Request *> m_Loaded;
+
+    list<Request *> m_Attaching;
+
+    list<Request *> m_Unloading;
+
+    mutex m_Mutex;
+
+    float m_Budget;
+
+    bool m_Running;
+
+    ThreadPool m_Pool;
+};
+
+/*!
+    \class ChunkStreamer
+    \brief Loads and unloads the scene chunks in the background.
+    \inmodule Engine
+
+    Unlike Engine::loadSceneChunk() the streamer doesn't block the game cycle.
+    The Map file is deserialized on the worker thread together with its resource dependencies and components into the
+    hierarchy detached from the Scene. Then the chunk is attached to the Scene by small steps in update() within the
+    per frame budget, registration of the components and attaching of each top level object are separate steps.
+    Unloading is time sliced in the same way: one top level object of the chunk is destroyed per step.
+
+    The Engine owns a streamer for its scene, see Engine::chunkStreamer().
+*/
+/*!
+    \enum ChunkStreamer::ChunkState
+
+    State of the streamed chunk.
+
+    \value Invalid \c The chunk isn't requested or unable to load.
+    \value Loading \c The chunk is loading in the background.
+    \value Attaching \c The chunk is attaching to the scene.
+    \value Ready \c The chunk is completely attached to the scene.
+    \value Unloading \c The chunk is unloading.
+*/
+/*!
+    Constructs a streamer which attaches the chunks to the \a scene.
+*/
+ChunkStreamer::ChunkStreamer(Scene *scene) :
+        p_ptr(new ChunkStreamerPrivate(scene)) {
+
+}
+/*!
+    Destroys the streamer. The chunks which are not attached completely are discarded.
+*/
+ChunkStreamer::~ChunkStreamer() {
+    p_ptr->m_Pool.waitForDone();
+
+    for(auto it : p_ptr->m_Requests) {
+        p_ptr->discard(it);
+        delete it;
+    }
+
+    delete p_ptr;
+}
+/*!
+    Requests the Map by \a path to be loaded in the background and attached to the scene.
+    Other chunks of the scene will be unloaded when the new chunk is loaded unless the \a additive flag is true.
+*/
+void ChunkStreamer::load(const string &path, bool additive) {
+    PROFILE_FUNCTION();
+    ChunkStreamerPrivate::Request *request = p_ptr->find(path);
+    // The chunk which failed to load can be requested again
+    if(request && request->state != Unloading && request->state != Invalid) {
+        return;
+    }
+
+    request = new ChunkStreamerPrivate::Request;
+    request->path = path;
+    request->state = Loading;
+    request->additive = additive;
+    request->map = nullptr;
+    request->chunk = nullptr;
+    p_ptr->m_Requests.push_back(request);
+
+    bool start = false;
+    {
+        unique_lock<mutex> locker(p_ptr->m_Mutex);
+        p_ptr->m_Queue.push_back(request);
+        if(!p_ptr->m_Running) {
+            p_ptr->m_Running = true;
+            start = true;
+        }
+    }
+    if(start) {
+        p_ptr->m_Pool.start(*p_ptr);
+    }
+}
+/*!
+    Requests the \a chunk to be unloaded from the scene.
+    The chunk which is attaching at the moment stops the attachment.
+*/
+void ChunkStreamer::unload(Chunk *chunk) {
+    PROFILE_FUNCTION();
+    if(chunk == nullptr) {
+        return;
+    }
+
+    ChunkStreamerPrivate::Request *request = p_ptr->find(chunk);
+    if(request) {
+        if(request->state == Unloading) {
+            return;
+        }
+        if(request->state == Attaching) {
+            p_ptr->m_Attaching.remove(request);
+            p_ptr->discard(request);
+        }
+    } else {
+        request = new ChunkStreamerPrivate::Request;
+        request->additive = true;
+        request->map = dynamic_cast<Map *>(chunk->resource());
+        request->chunk = chunk;
+        if(request->map) {
+            request->path = Engine::reference(request->map);
+        }
+        p_ptr->m_Requests.push_back(request);
+    }
+    request->state = Unloading;
+    p_ptr->m_Unloading.push_back(request);
+}
+/*!
+    Returns the state of the chunk loaded from the Map by \a path.
+*/
+ChunkStreamer::ChunkState ChunkStreamer::state(const string &path) const {
+    ChunkStreamerPrivate::Request *request = p_ptr->find(path);
+    return (request) ? request->state : Invalid;
+}
+/*!
+    Returns the chunk loaded from the Map by \a path or nullptr if the chunk is not loaded yet.
+*/
+Chunk *ChunkStreamer::chunk(const string &path) const {
+    ChunkStreamerPrivate::Request *request = p_ptr->find(path);
+    return (request && request->state != Loading) ? request->chunk : nullptr;
+}
+/*!
+    Returns true if there are no chunks loading, attaching or unloading at the moment.
+*/
+bool ChunkStreamer::isIdle() const {
+    {
+        unique_lock<mutex> locker(p_ptr->m_Mutex);
+        if(p_ptr->m_Running || !p_ptr->m_Queue.empty() || !p_ptr->m_Loaded.empty()) {
+            return false;
+        }
+    }
+    return p_ptr->m_Attaching.empty() && p_ptr->m_Unloading.empty();
+}
+/*!
+    Returns the time in milliseconds which can be spent in update() per frame.
+*/
+float ChunkStreamer::budget() const {
+    return p_ptr->m_Budget;
+}
+/*!
+    Sets the time in \a milliseconds which can be spent in update() per frame.
+    At least one step is done per frame regardless of the budget.
+*/
+void ChunkStreamer::setBudget(float milliseconds) {
+    p_ptr->m_Budget = milliseconds;
+}
+/*!
+    Attaches the loaded chunks to the scene and unloads the requested chunks within the time budget.
+    \note Usually, this method calls internally and must not be called manually.
+*/
+void ChunkStreamer::update() {
+    PROFILE_FUNCTION();
+    TimePoint start = std::chrono::high_resolution_clock::now();
+
+    list<ChunkStreamerPrivate::Request *> loaded;
+    {
+        unique_lock<mutex> locker(p_ptr->m_Mutex);
+        loaded.swap(p_ptr->m_Loaded);
+    }
+    for(auto it : loaded) {
+        if(it->chunk == nullptr) {
+            Log(Log::ERR) << "Unable to load" << it->path.c_str();
+            p_ptr->discard(it);
+            p_ptr->m_Requests.remove(it);
+            delete it;
+            continue;
+        }
+        it->state = Attaching;
+        p_ptr->m_Attaching.push_back(it);
+
+        if(!it->additive) {
+            for(auto child : p_ptr->m_pScene->getChildren()) {
+                Chunk *chunk = dynamic_cast<Chunk *>(child);
+                if(chunk && chunk != it->chunk) {
+                    unload(chunk);
+                }
+            }
+        }
+    }
+
+    while(!p_ptr->m_Attaching.empty() || !p_ptr->m_Unloading.empty()) {
+        if(!p_ptr->m_Attaching.empty()) {
+            if(p_ptr->attach(p_ptr->m_Attaching.front())) {
+                p_ptr->m_Attaching.pop_front();
+            }
+        } else {
+            ChunkStreamerPrivate::Request *request = p_ptr->m_Unloading.front();
+            if(p_ptr->detach(request)) {
+                p_ptr->m_Unloading.pop_front();
+                p_ptr->m_Requests.remove(request);
+                delete request;
+            }
+        }
+
+        TimePoint current = std::chrono::high_resolution_clock::now();
+        if(std::chrono::duration<float, std::milli>(current - start).count() >= p_ptr->m_Budget) {
+            break;
+        }
+    }
+}
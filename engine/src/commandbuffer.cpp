@@ -1,5 +1,7 @@
 #include "commandbuffer.h"
 
+#include "framepacket.h"
+
 static bool s_Inited = false;
 
 void CommandBuffer::clearRenderTarget(bool clearColor, const Vector4 &color, bool clearDepth, float depth) {
@@ -106,3 +108,7 @@ void CommandBuffer::enableScissor(int32_t x, int32_t y, int32_t width, int32_t h
 void CommandBuffer::disableScissor() {
 
 }
+
+void CommandBuffer::executePacket(const FramePacket &packet) {
+    packet.replay(*this);
+}
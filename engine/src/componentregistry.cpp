@@ -0,0 +1,337 @@
+#include "componentregistry.h"
+
+#include "components/actor.h"
+#include "components/component.h"
+
+#include <mutex>
+
+namespace {
+    struct Member {
+        vector<ComponentRegistry::Pool *> pools;
+
+        ObjectSystem *system;
+    };
+
+    struct RegistryData {
+        unordered_map<const MetaObject *, ComponentRegistry::Pool *> m_Pools;
+
+        unordered_map<Component *, Member> m_Members;
+
+        recursive_mutex m_Mutex;
+    };
+
+    // Never destroyed, components can outlive the static objects on the application exit
+    RegistryData &registry() {
+        static RegistryData *data = new RegistryData;
+        return *data;
+    }
+
+    // Registrations made on the current thread are collected here instead of the pools
+    thread_local ComponentRegistry::Deferred *t_pDeferred = nullptr;
+
+    bool inherits(const MetaObject *meta, const MetaObject *type) {
+        while(meta) {
+            if(meta == type) {
+                return true;
+            }
+            meta = meta->super();
+        }
+        return false;
+    }
+}
+
+/*!
+    \class ComponentRegistry
+    \brief Keeps the dense per type arrays of the components.
+    \inmodule Engine
+
+    Each Pool contains the components of one type (including subclasses) with the scene, owning system and the enabled
+    and visible flags packed into the parallel arrays, so systems can iterate exactly the components they own without RTTI
+    and without walking the object tree.
+    A pool is created on the first request and filled with the already existing components of the type.
+    The registry is updated when a component is attached to an Actor, enabled or disabled, when the Actor hierarchy is
+    enabled, disabled or moved to another parent and when a component is destroyed.
+
+    \note The order of the components in a pool is not stable; removing a component moves the last one to its place.
+*/
+
+/*!
+    \class ComponentRegistry::Pool
+    \brief Dense array of the components of one type.
+    \inmodule Engine
+*/
+/*!
+    \fn uint32_t ComponentRegistry::Pool::size() const
+
+    Returns the number of components in the pool.
+*/
+/*!
+    \fn Component *ComponentRegistry::Pool::at(uint32_t index) const
+
+    Returns the component at \a index.
+*/
+/*!
+    \fn Scene *ComponentRegistry::Pool::scene(uint32_t index) const
+
+    Returns the scene of the component at \a index or nullptr if the component isn't placed to a scene.
+*/
+/*!
+    \fn ObjectSystem *ComponentRegistry::Pool::system(uint32_t index) const
+
+    Returns the system which created the component at \a index.
+*/
+/*!
+    \fn bool ComponentRegistry::Pool::isEnabled(uint32_t index) const
+
+    Returns true if the component at \a index is enabled.
+*/
+/*!
+    \fn bool ComponentRegistry::Pool::isVisible(uint32_t index) const
+
+    Returns true if the Actor of the component at \a index is enabled in hierarchy.
+*/
+/*!
+    \fn bool ComponentRegistry::Pool::isActive(uint32_t index) const
+
+    Returns true if the component at \a index is enabled and its Actor is enabled in hierarchy.
+*/
+/*!
+    \fn ComponentRegistry::Pool &ComponentRegistry::pool()
+
+    Returns the pool of the components of type T.
+*/
+
+/*!
+    \class ComponentRegistry::Deferred
+    \brief Collects the component registrations made on a worker thread.
+    \inmodule Engine
+
+    The pools are read by the systems on the main thread without locks, so the hierarchies built in the background
+    must not touch them. Between begin() and end() all the components registered on the calling thread are collected
+    by the Deferred object and added to the pools later with commit() on the main thread.
+
+    \note Components of the collected hierarchy destroyed after end() must be dropped with clear() before the deletion.
+*/
+/*!
+    \fn uint32_t ComponentRegistry::Deferred::size() const
+
+    Returns the number of the collected components which are not committed yet.
+*/
+
+ComponentRegistry::Deferred::Deferred() :
+        m_pPrevious(nullptr) {
+
+}
+
+ComponentRegistry::Deferred::~Deferred() {
+    if(t_pDeferred == this) {
+        end();
+    }
+}
+/*!
+    Starts collecting the component registrations made on the current thread.
+*/
+void ComponentRegistry::Deferred::begin() {
+    m_pPrevious = t_pDeferred;
+    t_pDeferred = this;
+}
+/*!
+    Stops collecting the component registrations on the current thread.
+*/
+void ComponentRegistry::Deferred::end() {
+    if(t_pDeferred == this) {
+        t_pDeferred = m_pPrevious;
+    }
+    m_pPrevious = nullptr;
+}
+/*!
+    Adds up to \a count collected components to the pools. Returns true when all the components are committed.
+*/
+bool ComponentRegistry::Deferred::commit(uint32_t count) {
+    PROFILE_FUNCTION();
+    while(count > 0 && !m_Components.empty()) {
+        auto &it = m_Components.back();
+        m_Indices.erase(it.first);
+        registerComponent(it.first, it.second);
+        m_Components.pop_back();
+        count--;
+    }
+    return m_Components.empty();
+}
+/*!
+    Drops all the collected components without registration.
+*/
+void ComponentRegistry::Deferred::clear() {
+    m_Components.clear();
+    m_Indices.clear();
+}
+
+void ComponentRegistry::Deferred::capture(Component *component, ObjectSystem *system) {
+    auto it = m_Indices.find(component);
+    if(it != m_Indices.end()) {
+        m_Components[it->second].second = system;
+        return;
+    }
+    m_Indices[component] = static_cast<uint32_t>(m_Components.size());
+    m_Components.push_back({component, system});
+}
+
+bool ComponentRegistry::Deferred::release(Component *component) {
+    auto it = m_Indices.find(component);
+    if(it == m_Indices.end()) {
+        return false;
+    }
+    uint32_t index = it->second;
+    m_Indices.erase(it);
+
+    uint32_t last = static_cast<uint32_t>(m_Components.size()) - 1;
+    if(index != last) {
+        m_Components[index] = m_Components[last];
+        m_Indices[m_Components[index].first] = index;
+    }
+    m_Components.pop_back();
+    return true;
+}
+
+void ComponentRegistry::Pool::insert(Component *component, ObjectSystem *system) {
+    m_Indices[component] = static_cast<uint32_t>(m_Components.size());
+
+    m_Components.push_back(component);
+    m_Scenes.push_back(nullptr);
+    m_Systems.push_back(system);
+    m_Enabled.push_back(false);
+    m_Visible.push_back(false);
+}
+
+void ComponentRegistry::Pool::remove(Component *component) {
+    auto it = m_Indices.find(component);
+    if(it == m_Indices.end()) {
+        return;
+    }
+    uint32_t index = it->second;
+    m_Indices.erase(it);
+
+    uint32_t last = static_cast<uint32_t>(m_Components.size()) - 1;
+    if(index != last) {
+        m_Components[index] = m_Components[last];
+        m_Scenes[index] = m_Scenes[last];
+        m_Systems[index] = m_Systems[last];
+        m_Enabled[index] = m_Enabled[last];
+        m_Visible[index] = m_Visible[last];
+
+        m_Indices[m_Components[index]] = index;
+    }
+
+    m_Components.pop_back();
+    m_Scenes.pop_back();
+    m_Systems.pop_back();
+    m_Enabled.pop_back();
+    m_Visible.pop_back();
+}
+
+void ComponentRegistry::Pool::update(Component *component, Scene *scene, bool enabled, bool visible) {
+    auto it = m_Indices.find(component);
+    if(it != m_Indices.end()) {
+        uint32_t index = it->second;
+        m_Scenes[index] = scene;
+        m_Enabled[index] = enabled;
+        m_Visible[index] = visible;
+    }
+}
+/*!
+    Returns the pool of the components which are instances of \a meta type or its subclasses.
+*/
+ComponentRegistry::Pool &ComponentRegistry::pool(const MetaObject *meta) {
+    RegistryData &data = registry();
+    unique_lock<recursive_mutex> locker(data.m_Mutex);
+
+    auto it = data.m_Pools.find(meta);
+    if(it != data.m_Pools.end()) {
+        return *(it->second);
+    }
+
+    Pool *result = new Pool;
+    data.m_Pools[meta] = result;
+
+    for(auto &member : data.m_Members) {
+        if(inherits(member.first->metaObject(), meta)) {
+            result->insert(member.first, member.second.system);
+            member.second.pools.push_back(result);
+            updateComponent(member.first);
+        }
+    }
+    return *result;
+}
+/*!
+    Adds the \a component created by the \a system to the pools of its type and all base types and updates its state.
+    Does nothing except the state update if the \a component is registered already.
+    The registration is postponed if the current thread is collecting the components to a Deferred object.
+*/
+void ComponentRegistry::registerComponent(Component *component, ObjectSystem *system) {
+    if(t_pDeferred) {
+        t_pDeferred->capture(component, system);
+        return;
+    }
+
+    RegistryData &data = registry();
+    unique_lock<recursive_mutex> locker(data.m_Mutex);
+
+    auto it = data.m_Members.find(component);
+    if(it == data.m_Members.end()) {
+        Member &member = data.m_Members[component];
+        member.system = system;
+        for(const MetaObject *meta = component->metaObject(); meta != nullptr; meta = meta->super()) {
+            auto pool = data.m_Pools.find(meta);
+            if(pool != data.m_Pools.end()) {
+                pool->second->insert(component, system);
+                member.pools.push_back(pool->second);
+            }
+        }
+    }
+
+    updateComponent(component);
+}
+/*!
+    Removes the \a component from all pools.
+*/
+void ComponentRegistry::unregisterComponent(Component *component) {
+    if(t_pDeferred && t_pDeferred->release(component)) {
+        return;
+    }
+
+    RegistryData &data = registry();
+    unique_lock<recursive_mutex> locker(data.m_Mutex);
+
+    auto it = data.m_Members.find(component);
+    if(it != data.m_Members.end()) {
+        for(auto pool : it->second.pools) {
+            pool->remove(component);
+        }
+        data.m_Members.erase(it);
+    }
+}
+/*!
+    Refreshes the scene, enabled and visible flags of the registered \a component.
+*/
+void ComponentRegistry::updateComponent(Component *component) {
+    if(t_pDeferred) {
+        return;
+    }
+
+    RegistryData &data = registry();
+    unique_lock<recursive_mutex> locker(data.m_Mutex);
+
+    auto it = data.m_Members.find(component);
+    if(it == data.m_Members.end() || it->second.pools.empty()) {
+        return;
+    }
+
+    Actor *actor = dynamic_cast<Actor *>(component->parent());
+    Scene *scene = (actor) ? actor->scene() : nullptr;
+    bool enabled = component->isEnabled();
+    bool visible = (actor) ? actor->isEnabledInHierarchy() : false;
+
+    for(auto pool : it->second.pools) {
+        pool->update(component, scene, enabled, visible);
+    }
+}
@@ -7,6 +7,7 @@
 #include "systems/resourcesystem.h"
 
 #include "commandbuffer.h"
+#include "componentregistry.h"
 
 #include <cstring>
 
@@ -20,6 +21,8 @@ const char *DELETED ("Deleted");
 const char *TRANSFORM("Transform");
 
 class ActorPrivate : public Resource::IObserver {
+    A_POOLED()
+
 public:
     explicit ActorPrivate(Actor *actor) :
         m_transform(nullptr),
@@ -46,73 +49,7 @@ public:
                     m_data = m_actor->saveUserData();
                 } break;
                 case Resource::Ready: {
-                    ActorPrivate::List prefabObjects;
-                    ActorPrivate::enumObjects(m_prefab->actor(), prefabObjects);
-
-                    ActorPrivate::List deleteObjects;
-                    ActorPrivate::enumObjects(m_actor, deleteObjects);
-
-                    list<pair<Object *, Object *>> array;
-
-                    for(auto prefabObject : prefabObjects) {
-                        bool create = true;
-                        auto it = deleteObjects.begin();
-                        while(it != deleteObjects.end()) {
-                            Object *clone = *it;
-                            if(prefabObject->uuid() == clone->clonedFrom()) {
-                                array.push_back(make_pair(prefabObject, clone));
-                                it = deleteObjects.erase(it);
-                                create = false;
-                                break;
-                            } else if(clone->clonedFrom() == 0) { // probably was created right in instance we don't need to sync it
-                                it = deleteObjects.erase(it);
-                                create = false;
-                                break;
-                            }
-                            ++it;
-                        }
-                        if(create) {
-                            Object *parent = System::findObject(prefabObject->parent()->uuid(), m_actor);
-                            Object *result = prefabObject->clone(parent ? parent : m_actor);
-
-                            array.push_back(make_pair(prefabObject, result));
-                        }
-                    }
-
-                    for(auto it : array) {
-                        const MetaObject *meta = it.first->metaObject();
-                        for(int i = 0; i < meta->propertyCount(); i++) {
-                            MetaProperty origin = meta->property(i);
-                            MetaProperty target = it.second->metaObject()->property(i);
-                            if(origin.isValid() && target.isValid()) {
-                                Variant data = origin.read(it.first);
-                                if(origin.type().flags() & MetaType::BASE_OBJECT) {
-                                    Object *ro = *(reinterpret_cast<Object **>(data.data()));
-
-                                    for(auto &item : array) {
-                                        if(item.first == ro) {
-                                            ro = item.second;
-                                            break;
-                                        }
-                                    }
-
-                                    data = Variant(data.userType(), &ro);
-                                }
-                                target.write(it.second, data);
-                            }
-                        }
-
-                        for(auto item : it.first->getReceivers()) {
-                            MetaMethod signal = it.second->metaObject()->method(item.signal);
-                            MetaMethod method = item.receiver->metaObject()->method(item.method);
-                            Object::connect(it.second, (to_string(1) + signal.signature()).c_str(),
-                                            item.receiver, (to_string((method.type() == MetaMethod::Signal) ? 1 : 2) + method.signature()).c_str());
-                        }
-                    }
-
-                    for(auto it : deleteObjects) {
-                        delete it;
-                    }
+                    syncPrefab();
 
                     m_actor->loadUserData(m_data);
                 } break;
@@ -131,6 +68,80 @@ public:
         }
     }
 
+    /*!
+        Synchronizes the instance hierarchy with the prefab: restores the properties and connections of the cloned objects,
+        creates the objects which were added to the prefab and deletes the objects which were removed from it.
+        Objects created right in the instance are kept untouched.
+    */
+    void syncPrefab() {
+        ActorPrivate::List prefabObjects;
+        ActorPrivate::enumObjects(m_prefab->actor(), prefabObjects);
+
+        ActorPrivate::List deleteObjects;
+        ActorPrivate::enumObjects(m_actor, deleteObjects);
+
+        list<pair<Object *, Object *>> array;
+
+        for(auto prefabObject : prefabObjects) {
+            bool create = true;
+            auto it = deleteObjects.begin();
+            while(it != deleteObjects.end()) {
+                Object *clone = *it;
+                if(prefabObject->uuid() == clone->clonedFrom()) {
+                    array.push_back(make_pair(prefabObject, clone));
+                    it = deleteObjects.erase(it);
+                    create = false;
+                    break;
+                } else if(clone->clonedFrom() == 0) { // probably was created right in instance we don't need to sync it
+                    it = deleteObjects.erase(it);
+                    continue;
+                }
+                ++it;
+            }
+            if(create) {
+                Object *parent = System::findObject(prefabObject->parent()->uuid(), m_actor);
+                Object *result = prefabObject->clone(parent ? parent : m_actor);
+
+                array.push_back(make_pair(prefabObject, result));
+            }
+        }
+
+        for(auto it : array) {
+            const MetaObject *meta = it.first->metaObject();
+            for(int i = 0; i < meta->propertyCount(); i++) {
+                MetaProperty origin = meta->property(i);
+                MetaProperty target = it.second->metaObject()->property(i);
+                if(origin.isValid() && target.isValid()) {
+                    Variant data = origin.read(it.first);
+                    if(origin.type().flags() & MetaType::BASE_OBJECT) {
+                        Object *ro = *(reinterpret_cast<Object **>(data.data()));
+
+                        for(auto &item : array) {
+                            if(item.first == ro) {
+                                ro = item.second;
+                                break;
+                            }
+                        }
+
+                        data = Variant(data.userType(), &ro);
+                    }
+                    target.write(it.second, data);
+                }
+            }
+
+            for(auto item : it.first->getReceivers()) {
+                MetaMethod signal = it.second->metaObject()->method(item.signal);
+                MetaMethod method = item.receiver->metaObject()->method(item.method);
+                Object::connect(it.second, (to_string(1) + signal.signature()).c_str(),
+                                item.receiver, (to_string((method.type() == MetaMethod::Signal) ? 1 : 2) + method.signature()).c_str());
+            }
+        }
+
+        for(auto it : deleteObjects) {
+            delete it;
+        }
+    }
+
     static bool isPointer(const char *name) {
         for(uint32_t i = 0; i < strlen(name); i++) {
             if(name[i] == '*') {
@@ -149,6 +160,23 @@ public:
         }
     }
 
+    /*!
+        Drops the cached scene and refreshes the registry state of all components in the \a actor hierarchy.
+    */
+    static void updateComponents(Actor *actor) {
+        actor->p_ptr->m_scene = nullptr;
+        for(auto it : actor->getChildren()) {
+            if(it->isComponent()) {
+                ComponentRegistry::updateComponent(static_cast<Component *>(it));
+            } else {
+                Actor *child = dynamic_cast<Actor *>(it);
+                if(child) {
+                    updateComponents(child);
+                }
+            }
+        }
+    }
+
     typedef list<const Object *> ConstList;
     static void enumConstObjects(const Object *object, ConstList &list) {
         PROFILE_FUNCTION();
@@ -158,11 +186,43 @@ public:
         }
     }
 
-    static Component *componentInChildHelper(const string &type, Object *parent) {
+    /*!
+        Resolves the component \a type name to the registered MetaObject once, so the children can be matched by
+        the pointer comparison. Aliases, overrides and unregistered names fall back to the name based check.
+    */
+    struct ComponentType {
+        explicit ComponentType(const string &type) :
+                m_name(type.c_str()),
+                m_meta(nullptr) {
+
+            ObjectSystem::FactoryPair *factory = ObjectSystem::metaFactory(type);
+            if(factory && factory->first && strcmp(factory->first->name(), m_name) == 0) {
+                m_meta = factory->first;
+            }
+        }
+
+        bool match(const MetaObject *meta) const {
+            if(m_meta == nullptr) {
+                return meta->canCastTo(m_name);
+            }
+            for(; meta != nullptr; meta = meta->super()) {
+                if(meta == m_meta) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        const char *m_name;
+
+        const MetaObject *m_meta;
+    };
+
+    static Component *componentInChildHelper(const ComponentType &type, Object *parent) {
         PROFILE_FUNCTION();
         for(auto it : parent->getChildren()) {
             const MetaObject *meta = it->metaObject();
-            if(meta->canCastTo(type.c_str())) {
+            if(type.match(meta)) {
                 return static_cast<Component *>(it);
             } else {
                 Component *result = componentInChildHelper(type, it);
@@ -243,9 +303,13 @@ bool Actor::isEnabledInHierarchy() const {
 void Actor::setHierarchyEnabled(bool enabled) {
     p_ptr->m_hierarchyEnable = enabled;
     for(auto it : getChildren()) {
-        Actor *actor = dynamic_cast<Actor *>(it);
-        if(actor) {
-            actor->setHierarchyEnabled(enabled);
+        if(it->isComponent()) {
+            ComponentRegistry::updateComponent(static_cast<Component *>(it));
+        } else {
+            Actor *actor = dynamic_cast<Actor *>(it);
+            if(actor) {
+                actor->setHierarchyEnabled(enabled);
+            }
         }
     }
 }
@@ -293,10 +357,10 @@ Transform *Actor::transform() {
 Scene *Actor::scene() {
     PROFILE_FUNCTION();
     if(p_ptr->m_scene == nullptr) {
-        Object *scene = this;
-        while(scene && scene->parent() != nullptr) {
-            scene = scene->parent();
-        p_ptr->m_scene = dynamic_cast<Scene *>(scene);
+        Object *object = parent();
+        while(object && p_ptr->m_scene == nullptr) {
+            p_ptr->m_scene = dynamic_cast<Scene *>(object);
+            object = object->parent();
         }
     }
     return p_ptr->m_scene;
@@ -306,9 +370,10 @@ Scene *Actor::scene() {
 */
 Component *Actor::component(const string type) {
     PROFILE_FUNCTION();
+    ActorPrivate::ComponentType filter(type);
     for(auto it : getChildren()) {
         const MetaObject *meta = it->metaObject();
-        if(meta->canCastTo(type.c_str())) {
+        if(filter.match(meta)) {
             return static_cast<Component *>(it);
         }
     }
@@ -320,8 +385,9 @@ Component *Actor::component(const string type) {
 */
 Component *Actor::componentInChild(const string type) {
     PROFILE_FUNCTION();
+    ActorPrivate::ComponentType filter(type);
     for(auto it : getChildren()) {
-        Component *result = ActorPrivate::componentInChildHelper(type, it);
+        Component *result = ActorPrivate::componentInChildHelper(filter, it);
         if(result) {
             return static_cast<Component *>(result);
         }
@@ -393,6 +459,8 @@ void Actor::setParent(Object *parent, int32_t position, bool force) {
         Object::setParent(parent, position);
     }
 
+    ActorPrivate::updateComponents(this);
+
     for(auto it : getChildren()) {
         Component *component = dynamic_cast<Component *>(it);
         if(component) {
@@ -432,6 +500,25 @@ void Actor::setPrefab(Prefab *prefab) {
         clearCloneRef();
     }
 }
+/*!
+    Restores the state of this prefab instance to the prefab defaults.
+    All the changes made in the instance hierarchy are discarded.
+    \internal
+*/
+void Actor::resetToPrefab() {
+    PROFILE_FUNCTION();
+    if(p_ptr->m_prefab && p_ptr->m_prefab->actor()) {
+        p_ptr->syncPrefab();
+    }
+}
+/*!
+    Refreshes the scene of this actor and its children after one of the ancestors was moved to another parent.
+    \internal
+*/
+void Actor::updateScene() {
+    PROFILE_FUNCTION();
+    ActorPrivate::updateComponents(this);
+}
 /*!
     \internal
 */
@@ -1,6 +1,9 @@
 #include "components/animator.h"
 
 #include "components/actor.h"
+#include "components/transform.h"
+#include "components/camera.h"
+#include "components/skinnedmeshrender.h"
 
 #include "private/baseanimationblender.h"
 
@@ -11,8 +14,20 @@
 
 #include "log.h"
 
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
 #define CLIP "Clip"
 
+#define LOD_REDUCED 0.25f
+#define LOD_MINIMAL 0.08f
+
+#define ANIMATORS_FULL      "Animators Full"
+#define ANIMATORS_REDUCED   "Animators Reduced"
+#define ANIMATORS_MINIMAL   "Animators Minimal"
+#define ANIMATORS_CULLED    "Animators Culled"
+
 static hash<string> hash_str;
 
 class AnimatorPrivate : public Resource::IObserver {
@@ -22,11 +37,26 @@ public:
         m_pStateMachine(nullptr),
         m_pCurrentState(nullptr),
         m_pCurrentClip(nullptr),
-        m_Time(0) {
+        m_Time(0),
+        m_Lod(Animator::Full),
+        m_Skipped(0),
+        m_Factor(1.0f),
+        m_Evaluate(true),
+        m_Mask(false),
+        m_RootOnly(false),
+        m_LodEnabled(true),
+        m_RendersDirty(true) {
 
     }
 
-    void setPosition(uint32_t position, bool force) {
+    ~AnimatorPrivate() {
+        auto it = std::find(m_Batch.begin(), m_Batch.end(), this);
+        if(it != m_Batch.end()) {
+            m_Batch.erase(it);
+        }
+    }
+
+    void setTime(uint32_t position, bool force) {
         PROFILE_FUNCTION();
 
         m_Time = position;
@@ -38,6 +68,183 @@ public:
         }
     }
 
+    void setPosition(uint32_t position, bool force, bool deferred = false) {
+        PROFILE_FUNCTION();
+
+        setTime(position, force);
+
+        if(deferred) {
+            if(std::find(m_Batch.begin(), m_Batch.end(), this) == m_Batch.end()) {
+                m_Batch.push_back(this);
+            }
+        } else {
+            m_Evaluate = true;
+            m_Factor = 1.0f;
+            m_Mask = false;
+            m_RootOnly = false;
+            apply();
+        }
+    }
+
+    void advance(uint32_t position) {
+        PROFILE_FUNCTION();
+
+        int32_t lod = selectLod();
+        m_Stats[lod]++;
+
+        bool snap = (lod != m_Lod && (m_Lod == Animator::Culled || lod == Animator::Full));
+        m_Lod = lod;
+
+        uint32_t interval = s_Intervals[m_Lod];
+        if(interval == 0) {
+            // The skeleton is frozen, but the root bones keep following the clip, so the bounds move with the root motion
+            m_Skipped = 0;
+            m_Evaluate = true;
+            m_Factor = 1.0f;
+            m_Mask = false;
+            m_RootOnly = true;
+            setPosition(position, true, true);
+            return;
+        }
+        m_RootOnly = false;
+
+        if(snap) {
+            m_Skipped = 0;
+        }
+
+        bool interpolate = (m_Lod == Animator::Reduced && !snap);
+
+        m_Evaluate = (m_Skipped == 0);
+        m_Mask = (m_Lod != Animator::Full);
+        m_Factor = interpolate ? static_cast<float>(m_Skipped + 1) / static_cast<float>(interval) : 1.0f;
+        m_Skipped = (m_Skipped + 1) % interval;
+
+        if(m_Evaluate || interpolate) {
+            setPosition(position, true, true);
+        } else {
+            setTime(position, true);
+        }
+    }
+
+    void apply() {
+        PROFILE_FUNCTION();
+
+        if(m_RootOnly) {
+            for(auto it : m_Roots) {
+                it->evaluate();
+                it->interpolate(m_Factor);
+            }
+            return;
+        }
+
+        for(auto it : m_Properties) {
+            BaseAnimationBlender *blender = it.second;
+            if(m_Mask && blender->isLeaf()) {
+                continue;
+            }
+            if(m_Evaluate) {
+                blender->evaluate();
+            }
+            blender->interpolate(m_Factor);
+        }
+    }
+
+    int32_t selectLod() {
+        if(!m_LodEnabled) {
+            return Animator::Full;
+        }
+
+        Camera *camera = Camera::current();
+        if(camera == nullptr) {
+            return Animator::Full;
+        }
+
+        if(m_RendersDirty) {
+            updateRenders();
+            updateRoots();
+        }
+
+        if(m_Renders.empty()) {
+            return Animator::Full;
+        }
+
+        AABBox box = m_Renders.front()->bound();
+        for(auto it : m_Renders) {
+            box.encapsulate(it->bound());
+        }
+
+        if(m_PlanesFrame != m_Frame || m_pPlanesCamera != camera) {
+            m_Planes = Camera::frustumPlanes(Camera::frustumCorners(*camera));
+            m_PlanesFrame = m_Frame;
+            m_pPlanesCamera = camera;
+        }
+
+        if(!box.intersect(m_Planes.data(), 6)) {
+            return Animator::Culled;
+        }
+
+        float size = 1.0f;
+        if(camera->orthographic()) {
+            size = box.radius * 2.0f / camera->orthoSize();
+        } else {
+            float distance = (box.center - camera->actor()->transform()->worldPosition()).length();
+            if(distance > box.radius) {
+                size = box.radius / (distance * tanf(camera->fov() * DEG2RAD * 0.5f));
+            }
+        }
+
+        if(size < LOD_MINIMAL) {
+            return Animator::Minimal;
+        }
+        if(size < LOD_REDUCED) {
+            return Animator::Reduced;
+        }
+        return Animator::Full;
+    }
+
+    void updateRenders() {
+        for(auto it : m_Renders) {
+            Object::disconnect(it, _SIGNAL(destroyed()), d_ptr, _SLOT(onReferenceDestroyed()));
+        }
+
+        Actor *actor = d_ptr->actor();
+        list<SkinnedMeshRender *> renders = actor->findChildren<SkinnedMeshRender *>();
+        m_Renders = RenderList(renders.begin(), renders.end());
+        for(auto it : m_Renders) {
+            Object::connect(it, _SIGNAL(destroyed()), d_ptr, _SLOT(onReferenceDestroyed()));
+        }
+        m_RendersDirty = false;
+    }
+    /*!
+        Collects the animated transforms which have no animated parents, these bones move the whole skeleton.
+    */
+    void updateRoots() {
+        unordered_set<const Object *> animated;
+        for(auto &it : m_Properties) {
+            if(dynamic_cast<const Transform *>(it.second->target())) {
+                animated.insert(it.second->target());
+            }
+        }
+
+        m_Roots.clear();
+        for(auto &it : m_Properties) {
+            const Transform *transform = dynamic_cast<const Transform *>(it.second->target());
+            if(transform == nullptr) {
+                continue;
+            }
+            bool root = true;
+            for(Transform *parent = transform->parentTransform(); parent != nullptr; parent = parent->parentTransform()) {
+                if(animated.find(parent) != animated.end()) {
+                    root = false;
+                    break;
+                }
+            }
+            if(root) {
+                m_Roots.push_back(it.second);
+            }
+        }
+    }
+
     void setStateHash(int hash) {
         PROFILE_FUNCTION();
 
@@ -67,6 +274,8 @@ public:
                 delete it.second;
             }
             m_Properties.clear();
+            m_Roots.clear();
+            m_RendersDirty = true;
 
             m_pCurrentState = nullptr;
             if(m_pStateMachine) {
@@ -93,6 +302,8 @@ public:
     void rebind() {
         PROFILE_FUNCTION();
 
+        m_RendersDirty = true;
+
         if(m_pCurrentClip) {
             Actor *actor = d_ptr->actor();
             for(auto &it : m_pCurrentClip->m_Tracks) {
@@ -117,6 +328,7 @@ public:
                 for(auto &i : it.curves()) {
                     property->setCurve(&i.second, i.first);
                 }
+                property->setTrack(m_pCurrentClip, m_pCurrentClip->compiledTrack(it.hash()));
             }
         }
     }
@@ -139,11 +351,13 @@ public:
                         property->setOffset(time);
                         property->setTransitionTime(duration);
                     }
+                    property->setPreviousTrack(start, start->compiledTrack(it.hash()));
                 }
             }
         }
 
         m_pCurrentClip = end;
+        m_RendersDirty = true;
 
         for(auto &it : m_Properties) {
             it.second->stop();
@@ -178,12 +392,15 @@ public:
                 property->setCurve(&i.second, i.first);
                 property->setTransitionTime(duration);
             }
+            property->setTrack(end, end->compiledTrack(it.hash()));
             property->start();
         }
     }
 
     unordered_map<uint32_t, BaseAnimationBlender *> m_Properties;
 
+    vector<BaseAnimationBlender *> m_Roots;
+
     AnimationStateMachine::VariableMap m_CurrentVariables;
 
     Animator *d_ptr;
@@ -195,8 +412,55 @@ public:
     AnimationClip *m_pCurrentClip;
 
     uint32_t m_Time;
+
+    int32_t m_Lod;
+
+    uint32_t m_Skipped;
+
+    float m_Factor;
+
+    bool m_Evaluate;
+
+    bool m_Mask;
+
+    bool m_RootOnly;
+
+    bool m_LodEnabled;
+
+    bool m_RendersDirty;
+
+    RenderList m_Renders;
+
+    static vector<AnimatorPrivate *> m_Batch;
+
+    static uint32_t m_Frame;
+
+    static uint32_t m_PlanesFrame;
+
+    static Camera *m_pPlanesCamera;
+
+    static array<Plane, 6> m_Planes;
+
+    static uint32_t m_Stats[Animator::LodCount];
+
+    static uint32_t m_LastStats[Animator::LodCount];
+
+    static const uint32_t s_Intervals[Animator::LodCount];
 };
 
+vector<AnimatorPrivate *> AnimatorPrivate::m_Batch;
+
+uint32_t AnimatorPrivate::m_Frame = 0;
+uint32_t AnimatorPrivate::m_PlanesFrame = UINT32_MAX;
+Camera *AnimatorPrivate::m_pPlanesCamera = nullptr;
+array<Plane, 6> AnimatorPrivate::m_Planes;
+
+uint32_t AnimatorPrivate::m_Stats[Animator::LodCount] = {0};
+uint32_t AnimatorPrivate::m_LastStats[Animator::LodCount] = {0};
+
+// Number of frames between the evaluations for each LOD level, zero means only the root bones are evaluated
+const uint32_t AnimatorPrivate::s_Intervals[Animator::LodCount] = {1, 2, 4, 0};
+
 /*!
     \class Animator
     \brief Manages all animations in the engine.
@@ -257,10 +521,69 @@ void Animator::update() {
             auto next = p_ptr->m_pCurrentState->m_transitions.begin();
             setStateHash(next->m_targetState->m_hash);
         } else {
-            setPosition(p_ptr->m_Time + static_cast<uint32_t>(1000.0f * Timer::deltaTime()));
+            p_ptr->advance(p_ptr->m_Time + static_cast<uint32_t>(1000.0f * Timer::deltaTime()));
         }
     }
 }
+/*!
+    Evaluates all Animators updated during the current frame in one pass.
+    Animators are grouped by the playing clip to keep the compiled animation data hot in the cache.
+    \internal
+*/
+void Animator::processBatch() {
+    PROFILE_FUNCTION();
+
+    vector<AnimatorPrivate *> &batch = AnimatorPrivate::m_Batch;
+    std::sort(batch.begin(), batch.end(), [](const AnimatorPrivate *left, const AnimatorPrivate *right) {
+        return left->m_pCurrentClip < right->m_pCurrentClip;
+    });
+
+    for(auto it : batch) {
+        it->apply();
+    }
+    batch.clear();
+
+    PROFILER_RESET(ANIMATORS_FULL);
+    PROFILER_RESET(ANIMATORS_REDUCED);
+    PROFILER_RESET(ANIMATORS_MINIMAL);
+    PROFILER_RESET(ANIMATORS_CULLED);
+
+    PROFILER_STAT(ANIMATORS_FULL, AnimatorPrivate::m_Stats[Full]);
+    PROFILER_STAT(ANIMATORS_REDUCED, AnimatorPrivate::m_Stats[Reduced]);
+    PROFILER_STAT(ANIMATORS_MINIMAL, AnimatorPrivate::m_Stats[Minimal]);
+    PROFILER_STAT(ANIMATORS_CULLED, AnimatorPrivate::m_Stats[Culled]);
+
+    memcpy(AnimatorPrivate::m_LastStats, AnimatorPrivate::m_Stats, sizeof(AnimatorPrivate::m_Stats));
+    memset(AnimatorPrivate::m_Stats, 0, sizeof(AnimatorPrivate::m_Stats));
+
+    AnimatorPrivate::m_Frame++;
+}
+/*!
+    Returns the number of Animators which were updated with the \a lod level during the last frame.
+*/
+uint32_t Animator::lodStatistics(int32_t lod) {
+    if(lod >= 0 && lod < LodCount) {
+        return AnimatorPrivate::m_LastStats[lod];
+    }
+    return 0;
+}
+/*!
+    Returns true if the update rate of the Animator depends on the visibility of the attached SkinnedMeshRender components; otherwise returns false.
+*/
+bool Animator::isLodEnabled() const {
+    PROFILE_FUNCTION();
+
+    return p_ptr->m_LodEnabled;
+}
+/*!
+    Enables or disables the animation LOD. When \a enabled the Animator evaluates only the root bones of the off-screen objects,
+    reduces the update rate for the small objects on the screen and ignores the leaf bones of the distant skeletons.
+*/
+void Animator::setLodEnabled(bool enabled) {
+    PROFILE_FUNCTION();
+
+    p_ptr->m_LodEnabled = enabled;
+}
 /*!
     Returns AnimationStateMachine resource attached to this Animator.
 */
@@ -463,3 +786,12 @@ VariantMap Animator::saveUserData() const {
     }
     return result;
 }
+/*!
+    \internal
+*/
+void Animator::onReferenceDestroyed() {
+    Renderable *render = dynamic_cast<Renderable *>(sender());
+    if(render) {
+        p_ptr->m_Renders.remove(render);
+    }
+}
@@ -4,6 +4,7 @@
 #include "components/actor.h"
 
 #include "systems/resourcesystem.h"
+#include "systems/rendersystem.h"
 
 #include "resources/pose.h"
 #include "resources/texture.h"
@@ -12,38 +13,176 @@
 
 #include <cstring>
 #include <cfloat>
+#include <atomic>
+#include <mutex>
 
 #define M4X3_SIZE 48
+#define DQ_SIZE 32
 #define MAX_BONES 170
 
+#define PALETTE_WIDTH 512
+#define PALETTE_ROWS 16
+#define PALETTE_PAGES 2
+
 namespace {
 const char *POSE = "Pose";
 }
 
-class ArmaturePrivate : public Resource::IObserver {
+/*
+    Shared bone matrices storage for all armatures.
+    Each armature owns a single row of the palette texture and uploads only the changed part of it.
+    The palette is double buffered, each frame uses own page. So the armatures can update the bones while the render
+    thread still uploads the page of the previous frame. The regions written to the page are copied to the next page
+    when the frame changes.
+*/
+class ArmaturePalette {
 public:
-    ArmaturePrivate() :
-            m_pBindPose(nullptr),
-            m_pCache(nullptr),
-            m_BindDirty(false) {
+    struct Region {
+        int32_t x;
+
+        int32_t y;
 
-        m_pCache = ResourceSystem::objectCreate<Texture>();
-        m_pCache->setFormat(Texture::RGBA32Float);
-        m_pCache->resize(512, 1);
+        int32_t width;
+    };
+
+    static ArmaturePalette *instance() {
+        static ArmaturePalette palette;
+        return &palette;
+    }
+
+    int32_t allocate() {
+        if(m_pTextures[0] == nullptr) {
+            for(int32_t p = 0; p < PALETTE_PAGES; p++) {
+                m_pTextures[p] = ResourceSystem::objectCreate<Texture>();
+                m_pTextures[p]->setFormat(Texture::RGBA32Float);
+                m_pTextures[p]->resize(PALETTE_WIDTH, PALETTE_ROWS);
+            }
+            m_Rows = PALETTE_ROWS;
+            initRows(0);
+        }
 
+        if(m_Free.empty()) {
+            grow();
+        }
+
+        int32_t row = m_Free.front();
+        m_Free.pop_front();
+        return row;
+    }
+
+    void release(int32_t row) {
+        if(row >= 0) {
+            m_Free.push_back(row);
+        }
+    }
+    // Writes the texels to the row of the current page
+    void write(int32_t row, int32_t x, int32_t width, const float *data) {
+        int32_t current = page();
+        memcpy(&texel(current, row)[x * sizeof(Vector4)], data, width * sizeof(Vector4));
+        m_pTextures[current]->setDirtyRegion(x, row, width, 1);
+
+        m_Written.push_back({x, row, width});
+    }
+    // Returns the page of the current frame, the first call in the frame switches the page
+    int32_t page() {
+        uint32_t frame = RenderSystem::frameIndex();
+        if(m_Frame != frame) {
+            unique_lock<mutex> locker(m_Mutex);
+            if(m_Frame != frame) {
+                int32_t previous = m_Page;
+                m_Page = frame % PALETTE_PAGES;
+                if(m_Page != previous) {
+                    // The render thread only reads the previous page
+                    for(auto &it : m_Written) {
+                        memcpy(&texel(m_Page, it.y)[it.x * sizeof(Vector4)],
+                               &texel(previous, it.y)[it.x * sizeof(Vector4)], it.width * sizeof(Vector4));
+                        m_pTextures[m_Page]->setDirtyRegion(it.x, it.y, it.width, 1);
+                    }
+                    m_Written.clear();
+                }
+                m_Frame = frame;
+            }
+        }
+        return m_Page;
+    }
+
+    Texture *texture() {
+        return m_pTextures[page()];
+    }
+
+protected:
+    ArmaturePalette() :
+            m_pTextures{nullptr},
+            m_Rows(0),
+            m_Page(0),
+            m_Frame(0) {
+
+    }
+
+    int8_t *texel(int32_t page, int32_t row) {
+        ByteArray &array = m_pTextures[page]->surface(0)[0];
+        return &array[row * PALETTE_WIDTH * sizeof(Vector4)];
+    }
+
+    void grow() {
+        // The pages are resized in place
+        RenderSystem::synchronize();
+
+        int32_t rows = m_Rows;
+        m_Rows *= 2;
+        for(int32_t p = 0; p < PALETTE_PAGES; p++) {
+            ByteArray array = m_pTextures[p]->surface(0)[0];
+            m_pTextures[p]->resize(PALETTE_WIDTH, m_Rows);
+
+            memcpy(texel(p, 0), &array[0], array.size());
+        }
+        initRows(rows);
+    }
+
+    void initRows(int32_t first) {
         Matrix4 t;
-        Texture::Surface &surface = m_pCache->surface(0);
-        ByteArray &array = surface[0];
-        int8_t *data = &array[0];
-        for(uint32_t i = 0; i < MAX_BONES; i++) {
-            memcpy(&data[i * M4X3_SIZE], t.mat, M4X3_SIZE);
+        for(int32_t r = first; r < m_Rows; r++) {
+            for(int32_t p = 0; p < PALETTE_PAGES; p++) {
+                int8_t *data = texel(p, r);
+                for(uint32_t i = 0; i < MAX_BONES; i++) {
+                    memcpy(&data[i * M4X3_SIZE], t.mat, M4X3_SIZE);
+                }
+            }
+            m_Free.push_back(r);
         }
     }
 
+    Texture *m_pTextures[PALETTE_PAGES];
+
+    int32_t m_Rows;
+
+    list<int32_t> m_Free;
+
+    vector<Region> m_Written;
+
+    mutex m_Mutex;
+
+    int32_t m_Page;
+
+    atomic<uint32_t> m_Frame;
+};
+
+class ArmaturePrivate : public Resource::IObserver {
+public:
+    ArmaturePrivate() :
+            m_pBindPose(nullptr),
+            m_Row(ArmaturePalette::instance()->allocate()),
+            m_BindDirty(false),
+            m_DualQuaternion(false) {
+
+        m_Params = Vector4(m_Row, 0.0f, 0.0f, 0.0f);
+    }
+
     ~ArmaturePrivate() {
         if(m_pBindPose) {
             m_pBindPose->unsubscribe(this);
         }
+        ArmaturePalette::instance()->release(m_Row);
     }
 
     void resourceUpdated(const Resource *resource, Resource::ResourceState state) {
@@ -56,7 +195,7 @@ public:
         if(m_pBindPose) {
             list<Actor *> bones = actor->findChildren<Actor *>();
 
-            uint32_t count = m_pBindPose->boneCount();
+            uint32_t count = MIN(m_pBindPose->boneCount(), MAX_BONES);
             m_Bones.resize(count);
             m_InvertTransform.resize(count);
             m_Transform.resize(count);
@@ -77,13 +216,51 @@ public:
             m_InvertTransform.clear();
         }
         m_BindDirty = false;
+        m_Cache.clear();
+    }
+
+    static void packMatrix(const Matrix4 &m, float *result) {
+        Matrix4 t = m;
+        t[3]  = m.mat[12];
+        t[7]  = m.mat[13];
+        t[11] = m.mat[14];
+
+        memcpy(result, t.mat, M4X3_SIZE);
+    }
+
+    static void packDualQuaternion(const Matrix4 &m, float *result) {
+        Matrix3 r = m.rotation();
+        for(int i = 0; i < 3; i++) {
+            Vector3 axis(r[i * 3], r[i * 3 + 1], r[i * 3 + 2]);
+            axis.normalize();
+            r[i * 3] = axis.x; r[i * 3 + 1] = axis.y; r[i * 3 + 2] = axis.z;
+        }
+        Quaternion q(r);
+
+        float tx = m.mat[12] * 0.5f;
+        float ty = m.mat[13] * 0.5f;
+        float tz = m.mat[14] * 0.5f;
+
+        result[0] = q.x;
+        result[1] = q.y;
+        result[2] = q.z;
+        result[3] = q.w;
+
+        result[4] = tx * q.w + ty * q.z - tz * q.y;
+        result[5] =-tx * q.z + ty * q.w + tz * q.x;
+        result[6] = tx * q.y - ty * q.x + tz * q.w;
+        result[7] =-tx * q.x - ty * q.y - tz * q.z;
     }
+
     vector<Matrix4> m_InvertTransform;
     vector<Matrix4> m_Transform;
     vector<Transform *> m_Bones;
+    vector<float> m_Cache;
+    Vector4 m_Params;
     Pose *m_pBindPose;
-    Texture *m_pCache;
+    int32_t m_Row;
     bool m_BindDirty;
+    bool m_DualQuaternion;
 };
 
 /*!
@@ -113,22 +290,36 @@ void Armature::update() {
         p_ptr->cleanDirty(actor());
     }
 
-    Texture::Surface &surface = p_ptr->m_pCache->surface(0);
-    ByteArray &array = surface[0];
-    int8_t *data = &array[0];
+    uint32_t stride = (p_ptr->m_DualQuaternion) ? 8 : 12;
+    uint32_t count = p_ptr->m_Bones.size();
+    p_ptr->m_Cache.resize(count * stride);
 
-    for(uint32_t i = 0; i < p_ptr->m_Bones.size(); i++) {
+    uint32_t first = count;
+    uint32_t last = 0;
+
+    float data[12];
+    for(uint32_t i = 0; i < count; i++) {
         if(i < p_ptr->m_InvertTransform.size() && p_ptr->m_Bones[i]) {
             p_ptr->m_Transform[i] = p_ptr->m_Bones[i]->worldTransform() * p_ptr->m_InvertTransform[i];
         }
-        Matrix4 t = p_ptr->m_Transform[i];
-        t[3]  = p_ptr->m_Transform[i].mat[12];
-        t[7]  = p_ptr->m_Transform[i].mat[13];
-        t[11] = p_ptr->m_Transform[i].mat[14];
+        if(p_ptr->m_DualQuaternion) {
+            ArmaturePrivate::packDualQuaternion(p_ptr->m_Transform[i], data);
+        } else {
+            ArmaturePrivate::packMatrix(p_ptr->m_Transform[i], data);
+        }
 
-        memcpy(&data[i * M4X3_SIZE], t.mat, M4X3_SIZE);
+        float *cache = &p_ptr->m_Cache[i * stride];
+        if(memcmp(cache, data, stride * sizeof(float)) != 0) {
+            memcpy(cache, data, stride * sizeof(float));
+            first = MIN(first, i);
+            last = i;
+        }
+    }
+
+    if(first < count) {
+        uint32_t texels = stride / 4;
+        ArmaturePalette::instance()->write(p_ptr->m_Row, first * texels, (last - first + 1) * texels, &p_ptr->m_Cache[first * stride]);
     }
-    p_ptr->m_pCache->setDirty();
 }
 /*!
     Returns a bind pose of the bone structure.
@@ -151,11 +342,36 @@ void Armature::setBindPose(Pose *pose) {
         update();
     }
 }
+/*!
+    Returns true if bone transformations are packed as dual quaternions; otherwise returns false.
+*/
+bool Armature::dualQuaternion() const {
+    return p_ptr->m_DualQuaternion;
+}
+/*!
+    Enables or disables dual quaternion packing with \a enabled flag.
+    Dual quaternions require less memory bandwidth than matrices but ignore the scale of bones.
+*/
+void Armature::setDualQuaternion(bool enabled) {
+    if(p_ptr->m_DualQuaternion != enabled) {
+        p_ptr->m_DualQuaternion = enabled;
+        p_ptr->m_Params.y = (enabled) ? 1.0f : 0.0f;
+        p_ptr->m_Cache.clear();
+    }
+}
 /*!
     \internal
+    Returns the palette page of the current frame.
 */
 Texture *Armature::texture() const {
-    return p_ptr->m_pCache;
+    return ArmaturePalette::instance()->texture();
+}
+/*!
+    \internal
+    Returns skinning parameters for the shader. X component contains the palette row, Y component contains the packing type.
+*/
+const Vector4 &Armature::params() const {
+    return p_ptr->m_Params;
 }
 /*!
     \internal
@@ -1,4 +1,5 @@
 #include "components/chunk.h"
+#include "components/actor.h"
 
 Chunk::Chunk() :
     m_resource(nullptr) {
@@ -20,3 +21,18 @@ Resource *Chunk::resource() const {
 void Chunk::setResource(Resource *resource) {
     m_resource = resource;
 }
+/*!
+    Makes the chunk a child of the \a parent at given \a position and updates the scene of the contained actors.
+    \note Please ignore the \a force flag it will be provided by the default.
+*/
+void Chunk::setParent(Object *parent, int32_t position, bool force) {
+    PROFILE_FUNCTION();
+    Object::setParent(parent, position, force);
+
+    for(auto it : getChildren()) {
+        Actor *actor = dynamic_cast<Actor *>(it);
+        if(actor) {
+            actor->updateScene();
+        }
+    }
+}
@@ -2,7 +2,11 @@
 
 #include "components/actor.h"
 
+#include "componentregistry.h"
+
 class ComponentPrivate {
+    A_POOLED()
+
 public:
     ComponentPrivate() :
         m_Enable(true),
@@ -27,6 +31,8 @@ Component::Component() :
 
 }
 Component::~Component() {
+    ComponentRegistry::unregisterComponent(this);
+
     delete p_ptr;
     p_ptr = nullptr;
 }
@@ -48,6 +54,8 @@ bool Component::isEnabled() const {
 */
 void Component::setEnabled(bool enabled) {
     p_ptr->m_Enable = enabled;
+
+    ComponentRegistry::updateComponent(this);
 }
 /*!
     Returns true if the component is flagged as started; otherwise returns false.
@@ -92,6 +100,16 @@ bool Component::isRenderable() const {
 bool Component::isPostProcessVolume() const {
     return false;
 }
+/*!
+    Makes the component a child of the \a parent at given \a position.
+    Registers the component in the ComponentRegistry on the first call.
+    \note Please ignore the \a force flag it will be provided by the default.
+*/
+void Component::setParent(Object *parent, int32_t position, bool force) {
+    Object::setParent(parent, position, force);
+
+    ComponentRegistry::registerComponent(this, system());
+}
 /*!
     \internal
 */
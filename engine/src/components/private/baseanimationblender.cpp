@@ -1,12 +1,59 @@
 #include "private/baseanimationblender.h"
 
+#include "components/actor.h"
+#include "components/transform.h"
+
+#include <cstring>
+
 BaseAnimationBlender::BaseAnimationBlender() :
+        m_pClip(nullptr),
+        m_pTrack(nullptr),
+        m_pPrevClip(nullptr),
+        m_pPrevTrack(nullptr),
+        m_pTransform(nullptr),
+        m_Channel(Generic),
+        m_Time(0.0f),
         m_Factor(0.0f),
         m_Offset(0.0f),
         m_TransitionTime(0.0f),
         m_PrevDuration(0),
-        m_PreviousTime(0) {
+        m_PreviousTime(0),
+        m_Leaf(false),
+        m_Sampled(false) {
 
+    memset(m_Default, 0, sizeof(m_Default));
+    memset(m_Source, 0, sizeof(m_Source));
+    memset(m_Target, 0, sizeof(m_Target));
+}
+/*!
+    Sets the new animated \a property of the \a object.
+    Position, rotation and scale of Transform components will be written directly without Variant conversions.
+*/
+void BaseAnimationBlender::setTarget(Object *object, const char *property) {
+    PropertyAnimation::setTarget(object, property);
+
+    m_pTransform = dynamic_cast<Transform *>(object);
+    m_Channel = Generic;
+    m_Leaf = false;
+    m_Sampled = false;
+    if(m_pTransform) {
+        m_Leaf = m_pTransform->actor()->findChildren<Actor *>(false).empty();
+
+        string name(property);
+        if(name == "position") {
+            m_Channel = Position;
+            memcpy(m_Default, m_pTransform->position().v, sizeof(Vector3));
+        } else if(name == "rotation") {
+            m_Channel = Rotation;
+            memcpy(m_Default, m_pTransform->rotation().v, sizeof(Vector3));
+        } else if(name == "quaternion") {
+            m_Channel = Orientation;
+            memcpy(m_Default, m_pTransform->quaternion().q, sizeof(Vector4));
+        } else if(name == "scale") {
+            m_Channel = Scale;
+            memcpy(m_Default, m_pTransform->scale().v, sizeof(Vector3));
+        }
+    }
 }
 
 void BaseAnimationBlender::setOffset(float offset) {
@@ -52,6 +99,13 @@ void BaseAnimationBlender::setCurrentTime(uint32_t position) {
             }
         }
 
+        if(isDirect()) {
+            // Will be evaluated in apply()
+            m_Time = time;
+            m_PreviousTime = position;
+            return;
+        }
+
         Variant data = defaultValue();
         switch(data.type()) {
             case MetaType::BOOLEAN: {
@@ -116,6 +170,118 @@ void BaseAnimationBlender::setPreviousCurve(AnimationCurve *curve, int32_t compo
     }
     m_PrevDuration = 0;
 }
+/*!
+    Sets compiled \a track from the \a clip to be used instead of animation curves.
+*/
+void BaseAnimationBlender::setTrack(const AnimationClip *clip, const AnimationClip::CompiledTrack *track) {
+    m_pClip = clip;
+    m_pTrack = track;
+}
+/*!
+    Sets compiled \a track from the \a clip to be used instead of the previous animation curves during crossfade.
+*/
+void BaseAnimationBlender::setPreviousTrack(const AnimationClip *clip, const AnimationClip::CompiledTrack *track) {
+    m_pPrevClip = clip;
+    m_pPrevTrack = track;
+}
+/*!
+    Returns true if the animated property can be evaluated using compiled tracks and written directly to the Transform; otherwise returns false.
+*/
+bool BaseAnimationBlender::isDirect() const {
+    return (m_Channel != Generic && m_pTrack != nullptr && m_pTrack->components <= 4);
+}
+/*!
+    Returns true if the animated Transform has no child transforms; otherwise returns false.
+    Leaf bones can be masked out for the distant objects without a visible impact on the rest of the skeleton.
+*/
+bool BaseAnimationBlender::isLeaf() const {
+    return m_Leaf;
+}
+/*!
+    Evaluates compiled tracks for the current time and writes the result directly to the target Transform.
+*/
+void BaseAnimationBlender::apply() {
+    PROFILE_FUNCTION();
+
+    evaluate();
+    interpolate(1.0f);
+}
+/*!
+    Evaluates compiled tracks for the current time without writing the result to the target Transform.
+    The previously evaluated value is kept to be used as the start point for interpolate().
+*/
+void BaseAnimationBlender::evaluate() {
+    PROFILE_FUNCTION();
+
+    if(!isValid() || !isDirect() || state() != RUNNING) {
+        return;
+    }
+
+    memcpy(m_Source, m_Target, sizeof(m_Source));
+
+    float value[4];
+    memcpy(value, m_Default, sizeof(value));
+    if(m_pPrevTrack && m_pPrevTrack->components <= 4) {
+        sample(m_pPrevClip, m_pPrevTrack, m_Time, value);
+    }
+
+    float end[4];
+    memcpy(end, m_Default, sizeof(end));
+    sample(m_pClip, m_pTrack, MAX(m_Time - m_Offset, 0.0f), end);
+
+    if(m_Channel == Orientation) {
+        Quaternion q(value[0], value[1], value[2], value[3]);
+        q.mix(Quaternion(end[0], end[1], end[2], end[3]), q, m_Factor);
+        q.normalize();
+        memcpy(m_Target, q.q, sizeof(m_Target));
+    } else {
+        for(int i = 0; i < 3; i++) {
+            m_Target[i] = MIX(end[i], value[i], m_Factor);
+        }
+    }
+
+    if(!m_Sampled) {
+        memcpy(m_Source, m_Target, sizeof(m_Source));
+        m_Sampled = true;
+    }
+}
+/*!
+    Writes the value between the two last evaluated results to the target Transform.
+    The \a factor 0.0 corresponds to the previous result and 1.0 to the latest one.
+*/
+void BaseAnimationBlender::interpolate(float factor) {
+    PROFILE_FUNCTION();
+
+    if(!m_Sampled || !isValid() || !isDirect()) {
+        return;
+    }
+
+    if(m_Channel == Orientation) {
+        Quaternion q;
+        q.mix(Quaternion(m_Source[0], m_Source[1], m_Source[2], m_Source[3]),
+              Quaternion(m_Target[0], m_Target[1], m_Target[2], m_Target[3]), factor);
+        m_pTransform->setQuaternion(q);
+        return;
+    }
+
+    Vector3 v(MIX(m_Source[0], m_Target[0], factor),
+              MIX(m_Source[1], m_Target[1], factor),
+              MIX(m_Source[2], m_Target[2], factor));
+
+    switch(m_Channel) {
+        case Position: m_pTransform->setPosition(v); break;
+        case Rotation: m_pTransform->setRotation(v); break;
+        case Scale: m_pTransform->setScale(v); break;
+        default: break;
+    }
+}
+
+void BaseAnimationBlender::sample(const AnimationClip *clip, const AnimationClip::CompiledTrack *track, float position, float *result) const {
+    float data[4];
+    int32_t components = MIN(track->components, 4);
+    clip->sample(*track, position, data);
+    memcpy(result, data, sizeof(float) * components);
+}
 
 float BaseAnimationBlender::mix(float value, int32_t component, float position) {
     PROFILE_FUNCTION();
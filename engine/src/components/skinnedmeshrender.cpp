@@ -15,6 +15,7 @@ const char *MESH = "Mesh";
 const char *MATERIAL = "Material";
 const char *ARMATURE = "Armature";
 const char *MATRICES = "skinMatrices";
+const char *PARAMS = "skinParams";
 }
 
 class SkinnedMeshRenderPrivate {
@@ -22,7 +23,8 @@ public:
     SkinnedMeshRenderPrivate() :
             m_pMesh(nullptr),
             m_pMaterial(nullptr),
-            m_pArmature(nullptr) {
+            m_pArmature(nullptr),
+            m_pPalette(nullptr) {
 
     }
 
@@ -30,7 +32,11 @@ public:
 
     MaterialInstance *m_pMaterial;
 
+    Vector4 m_Params;
+
     Armature *m_pArmature;
+
+    Texture *m_pPalette;
 };
 /*!
     \class SkinnedMeshRender
@@ -59,6 +65,16 @@ void SkinnedMeshRender::draw(CommandBuffer &buffer, uint32_t layer) {
             buffer.setColor(CommandBuffer::idToColor(a->uuid()));
         }
 
+        if(p_ptr->m_pArmature) {
+            p_ptr->m_Params = p_ptr->m_pArmature->params();
+            // The palette is double buffered, so the page changes every frame
+            Texture *t = p_ptr->m_pArmature->texture();
+            if(p_ptr->m_pMaterial && t != p_ptr->m_pPalette) {
+                p_ptr->m_pMaterial->setTexture(MATRICES, t);
+                p_ptr->m_pPalette = t;
+            }
+        }
+
         buffer.drawMesh(a->transform()->worldTransform(), p_ptr->m_pMesh, 0, layer, p_ptr->m_pMaterial);
         buffer.setColor(Vector4(1.0f));
     }
@@ -112,9 +128,11 @@ void SkinnedMeshRender::setMaterial(Material *material) {
             delete p_ptr->m_pMaterial;
         }
         p_ptr->m_pMaterial = material->createInstance(Material::Skinned);
+        p_ptr->m_pMaterial->setVector4(PARAMS, &p_ptr->m_Params);
         if(p_ptr->m_pArmature) {
             Texture *t = p_ptr->m_pArmature->texture();
             p_ptr->m_pMaterial->setTexture(MATRICES, t);
+            p_ptr->m_pPalette = t;
         }
     }
 }
@@ -134,6 +152,7 @@ void SkinnedMeshRender::setArmature(Armature *armature) {
         if(p_ptr->m_pMaterial) {
             Texture *t = p_ptr->m_pArmature->texture();
             p_ptr->m_pMaterial->setTexture(MATRICES, t);
+            p_ptr->m_pPalette = t;
         }
     }
 }
@@ -28,6 +28,8 @@ public:
             m_pMaterial(nullptr),
             m_pMesh(Engine::loadResource<Mesh>(".embedded/plane.fbx/Plane001")),
             m_pCustomMesh(nullptr),
+            m_pCustomMeshes{nullptr, nullptr},
+            m_pDrawn(nullptr),
             m_Color(1.0f),
             m_Size(1.0f),
             m_Hash(0),
@@ -57,16 +59,18 @@ public:
 
     void composeMesh(bool resetSize = false) {
         if(m_pSprite) {
-            if(m_pCustomMesh == nullptr) {
-                m_pCustomMesh = Engine::objectCreate<Mesh>("");
+            // The render thread can still upload the mesh of the last recorded frame, so the other one is rewritten
+            int32_t index = (m_pDrawn && m_pDrawn == m_pCustomMeshes[0]) ? 1 : 0;
+            if(m_pCustomMeshes[index] == nullptr) {
+                m_pCustomMeshes[index] = Engine::objectCreate<Mesh>("");
             }
 
-            bool result = SpriteRender::composeMesh(m_pSprite, m_Hash, m_pCustomMesh, m_Size, (m_DrawMode == SpriteRender::Tiled), resetSize);
+            bool result = SpriteRender::composeMesh(m_pSprite, m_Hash, m_pCustomMeshes[index], m_Size, (m_DrawMode == SpriteRender::Tiled), resetSize);
             if(result) {
+                m_pCustomMesh = m_pCustomMeshes[index];
                 return;
             }
         }
-        delete m_pCustomMesh;
         m_pCustomMesh = nullptr;
     }
 
@@ -78,6 +82,8 @@ public:
 
     Mesh *m_pMesh;
     Mesh *m_pCustomMesh;
+    Mesh *m_pCustomMeshes[2];
+    Mesh *m_pDrawn;
 
     Vector4 m_Color;
 
@@ -124,9 +130,9 @@ void SpriteRender::draw(CommandBuffer &buffer, uint32_t layer) {
             buffer.setColor(CommandBuffer::idToColor(a->uuid()));
         }
 
-        buffer.drawMesh(a->transform()->worldTransform(),
-                        (p_ptr->m_pCustomMesh) ? p_ptr->m_pCustomMesh : p_ptr->m_pMesh,
-                        0, layer, p_ptr->m_pMaterial);
+        p_ptr->m_pDrawn = (p_ptr->m_pCustomMesh) ? p_ptr->m_pCustomMesh : p_ptr->m_pMesh;
+
+        buffer.drawMesh(a->transform()->worldTransform(), p_ptr->m_pDrawn, 0, layer, p_ptr->m_pMaterial);
         buffer.setColor(Vector4(1.0f));
     }
 }
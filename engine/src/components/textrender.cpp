@@ -17,20 +17,71 @@
 #define OVERRIDE "uni.texture0"
 #define COLOR "uni.color0"
 
+#define MAX_SHAPES 256
+
+namespace  {
+    struct ShapeKey {
+        Font *font;
+
+        string text;
+
+        Vector2 boundaries;
+
+        int32_t size;
+
+        int32_t alignment;
+
+        bool kerning;
+
+        bool wrap;
+
+        bool operator==(const ShapeKey &right) const {
+            return font == right.font && size == right.size && alignment == right.alignment &&
+                   kerning == right.kerning && wrap == right.wrap && boundaries == right.boundaries && text == right.text;
+        }
+    };
+
+    struct ShapeKeyHash {
+        size_t operator()(const ShapeKey &key) const {
+            size_t result = hash<string>()(key.text);
+            result ^= hash<void *>()(key.font) + 0x9e3779b9 + (result << 6) + (result >> 2);
+            result ^= hash<int32_t>()(key.size ^ (key.alignment << 16)) + 0x9e3779b9 + (result << 6) + (result >> 2);
+            return result;
+        }
+    };
+
+    struct ShapedText {
+        Lod lod;
+
+        AABBox bound;
+
+        uint32_t revision;
+    };
+    /*!
+        Recently composed texts. The text meshes of score counters, timers and similar labels are reused from here instead of shaping them again.
+    */
+    unordered_map<ShapeKey, ShapedText, ShapeKeyHash> s_ShapeCache;
+}
+
 class TextRenderPrivate : public Resource::IObserver {
 public:
     TextRenderPrivate() :
         m_Color(1.0f),
         m_pFont(nullptr),
         m_pMaterial(nullptr),
-        m_pMesh(Engine::objectCreate<Mesh>()),
+        m_pMesh(nullptr),
+        m_pDrawn(nullptr),
         m_Size(16),
         m_Alignment(Left),
         m_Kerning(true),
         m_Wrap(false) {
 
-        m_pMesh->makeDynamic();
-        m_pMesh->setFlags(Mesh::Uv0);
+        for(auto &it : m_pMeshes) {
+            it = Engine::objectCreate<Mesh>();
+            it->makeDynamic();
+            it->setFlags(Mesh::Uv0);
+        }
+        m_pMesh = m_pMeshes[0];
 
         Material *material = Engine::loadResource<Material>(".embedded/DefaultFont.mtl");
         if(material) {
@@ -51,7 +102,13 @@ public:
     }
 
     void composeMesh() {
-        TextRender::composeMesh(m_pFont, m_pMesh, m_Size, m_Text, m_Alignment, m_Kerning, m_Wrap, m_Boundaries);
+        if(m_pFont == nullptr) {
+            return;
+        }
+        // The render thread can still upload the mesh of the last recorded frame, so the other one is rewritten
+        Mesh *mesh = (m_pDrawn == m_pMeshes[0]) ? m_pMeshes[1] : m_pMeshes[0];
+        TextRender::composeMesh(m_pFont, mesh, m_Size, m_Text, m_Alignment, m_Kerning, m_Wrap, m_Boundaries);
+        m_pMesh = mesh;
     }
 
     string m_Text;
@@ -64,8 +121,12 @@ public:
 
     MaterialInstance *m_pMaterial;
 
+    Mesh *m_pMeshes[2];
+
     Mesh *m_pMesh;
 
+    Mesh *m_pDrawn;
+
     int32_t m_Size;
 
     int m_Alignment;
@@ -95,6 +156,10 @@ TextRender::~TextRender() {
     \internal
 */
 void TextRender::draw(CommandBuffer &buffer, uint32_t layer) {
+    if(p_ptr->m_pFont) {
+        p_ptr->m_pFont->commitGlyphs();
+    }
+
     Actor *a = actor();
     if(p_ptr->m_pMesh && layer & a->layers() && !p_ptr->m_Text.empty()) {
         if(layer & CommandBuffer::RAYCAST) {
@@ -102,6 +167,8 @@ void TextRender::draw(CommandBuffer &buffer, uint32_t layer) {
         }
         buffer.drawMesh(a->transform()->worldTransform(), p_ptr->m_pMesh, 0, layer, p_ptr->m_pMaterial);
         buffer.setColor(Vector4(1.0f));
+
+        p_ptr->m_pDrawn = p_ptr->m_pMesh;
     }
 }
 /*!
@@ -114,8 +181,10 @@ string TextRender::text() const {
     Changes the \a text which will be drawn.
 */
 void TextRender::setText(const string &text) {
-    p_ptr->m_Text = text;
-    p_ptr->composeMesh();
+    if(p_ptr->m_Text != text) {
+        p_ptr->m_Text = text;
+        p_ptr->composeMesh();
+    }
 }
 /*!
     Returns the font which will be used to draw a text.
@@ -326,24 +395,44 @@ AABBox TextRender::bound() const {
 */
 void TextRender::composeMesh(Font *font, Mesh *mesh, int size, const string &text, int alignment, bool kerning, bool wrap, const Vector2 &boundaries) {
     if(font) {
-        float spaceWidth = font->spaceWidth() * size;
-        float spaceLine = font->lineHeight() * size;
+        PROFILE_FUNCTION();
 
         string data = Engine::translate(text);
         font->requestCharacters(data);
 
-        uint32_t length = font->length(data);
+        ShapeKey key = {font, data, boundaries, size, alignment, kerning, wrap};
+        auto cached = s_ShapeCache.find(key);
+        if(cached != s_ShapeCache.end() && cached->second.revision == font->revision()) {
+            Lod *target = mesh->lod(0);
+            if(target) {
+                *target = cached->second.lod;
+            }
+            mesh->setBound(cached->second.bound);
+            mesh->setTopology(Mesh::Triangles);
+            mesh->setLod(0, (target) ? target : &cached->second.lod);
+            return;
+        }
+
+        float spaceWidth = font->spaceWidth() * size;
+        float spaceLine = font->lineHeight() * size;
+
+        u32string u32 = Utils::utf8ToUtf32(data);
+        uint32_t length = u32.length();
         if(length) {
-            u32string u32 = Utils::utf8ToUtf32(data);
+            // The text is shaped directly into the existing geometry of the mesh to reuse the allocated memory
+            Lod local;
+            Lod *lod = mesh->lod(0);
+            if(lod == nullptr) {
+                lod = &local;
+            }
 
-            Lod lod;
+            IndexVector &indices = lod->indices();
+            Vector3Vector &vertices = lod->vertices();
+            Vector2Vector &uv0 = lod->uv0();
 
-            IndexVector &indices = lod.indices();
-            Vector3Vector &vertices = lod.vertices();
-            Vector2Vector &uv0 = lod.uv0();
+            uint32_t quads = indices.size() / 6;
 
             vertices.resize(length * 4);
-            indices.resize(length * 6);
             uv0.resize(length * 4);
 
             list<float> width;
@@ -424,14 +513,6 @@ void TextRender::composeMesh(Font *font, Mesh *mesh, int size, const string &tex
                         uv0[it * 4 + 2] = uv[2];
                         uv0[it * 4 + 3] = uv[3];
 
-                        indices[it * 6 + 0] = it * 4 + 0;
-                        indices[it * 6 + 1] = it * 4 + 1;
-                        indices[it * 6 + 2] = it * 4 + 2;
-
-                        indices[it * 6 + 3] = it * 4 + 0;
-                        indices[it * 6 + 4] = it * 4 + 2;
-                        indices[it * 6 + 5] = it * 4 + 3;
-
                         pos += Vector3(shape[2].x * size, 0.0f, 0.0f);
                         it++;
                     } break;
@@ -450,9 +531,22 @@ void TextRender::composeMesh(Font *font, Mesh *mesh, int size, const string &tex
             position.push_back(it);
 
             vertices.resize(it * 4);
-            indices.resize(it * 6);
             uv0.resize(it * 4);
 
+            // Indices depend on the number of glyphs only
+            if(quads != it) {
+                indices.resize(it * 6);
+                for(uint32_t i = 0; i < it; i++) {
+                    indices[i * 6 + 0] = i * 4 + 0;
+                    indices[i * 6 + 1] = i * 4 + 1;
+                    indices[i * 6 + 2] = i * 4 + 2;
+
+                    indices[i * 6 + 3] = i * 4 + 0;
+                    indices[i * 6 + 4] = i * 4 + 2;
+                    indices[i * 6 + 5] = i * 4 + 3;
+                }
+            }
+
             auto w = width.begin();
             auto p = position.begin();
             float shiftX = (!(alignment & Left)) ? (boundaries.x - (*w)) / ((alignment & Center) ? 2 : 1) : 0.0f;
@@ -471,7 +565,15 @@ void TextRender::composeMesh(Font *font, Mesh *mesh, int size, const string &tex
             box.setBox(bb[0], bb[1]);
             mesh->setBound(box);
             mesh->setTopology(Mesh::Triangles);
-            mesh->setLod(0, &lod);
+            mesh->setLod(0, lod);
+
+            if(s_ShapeCache.size() >= MAX_SHAPES) {
+                s_ShapeCache.clear();
+            }
+            ShapedText &shaped = s_ShapeCache[key];
+            shaped.lod = *lod;
+            shaped.bound = box;
+            shaped.revision = font->revision();
         }
     }
 }
@@ -6,6 +6,8 @@
 #include <mutex>
 
 class TransformPrivate {
+    A_POOLED()
+
 public:
     TransformPrivate() :
         m_Position(Vector3()),
@@ -256,7 +258,7 @@ void Transform::setParent(Object *parent, int32_t position, bool force) {
     if(parent == this) {
         return;
     }
-    Object::setParent(parent, 0, force);
+    Component::setParent(parent, 0, force);
 
     Actor *p = dynamic_cast<Actor *>(actor()->parent());
     if(p) {
@@ -242,6 +242,15 @@ AssetConverterSettings *AssetConverter::createSettings() const {
     return new AssetConverterSettings();
 }
 
+/*!
+    Returns true if convertFile() can be called from the worker threads concurrently with other conversions.
+    Such converters must not touch the editor state and must use only the objects which are owned by conversion.
+    Default implementation returns false, so the conversion is performed on the main thread.
+*/
+bool AssetConverter::isThreadSafe() const {
+    return false;
+}
+
 QString AssetConverter::templatePath() const {
     return QString();
 }
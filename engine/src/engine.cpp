@@ -17,6 +17,11 @@
 #include "system.h"
 #include "timer.h"
 #include "input.h"
+#include "componentregistry.h"
+#include "chunkstreamer.h"
+#include "systemscheduler.h"
+
+#include "systems/rendersystem.h"
 
 #include "components/scene.h"
 #include "components/chunk.h"
@@ -84,20 +89,9 @@ public:
             m_Platform->destroy();
             delete m_Platform;
         }
-
-        //for(auto it : m_Pool) {
-        //    delete it;
-        //}
-        m_Pool.clear();
-
-        //for(auto it : m_Serial) {
-        //    delete it;
-        //}
-        m_Serial.clear();
     }
 
-    static list<System *>    m_Pool;
-    static list<System *>    m_Serial;
+    static SystemScheduler  *m_pScheduler;
 
     static Scene            *m_Scene;
 
@@ -121,11 +115,11 @@ public:
 
     static VariantMap        m_Values;
 
-    ThreadPool               m_ThreadPool;
-
     static ResourceSystem   *m_pResourceSystem;
 
     static Translator       *m_Translator;
+
+    static ChunkStreamer    *m_pStreamer;
 };
 
 File            *EnginePrivate::m_File = nullptr;
@@ -140,11 +134,10 @@ PlatformAdaptor *EnginePrivate::m_Platform = nullptr;
 Scene           *EnginePrivate::m_Scene = nullptr;
 ResourceSystem  *EnginePrivate::m_pResourceSystem = nullptr;
 Translator      *EnginePrivate::m_Translator = nullptr;
+ChunkStreamer   *EnginePrivate::m_pStreamer = nullptr;
+SystemScheduler *EnginePrivate::m_pScheduler = nullptr;
 Engine          *EnginePrivate::m_Instance = nullptr;
 
-list<System *>  EnginePrivate::m_Pool;
-list<System *>  EnginePrivate::m_Serial;
-
 typedef Vector4 Color;
 
 /*!
@@ -189,8 +182,10 @@ Engine::Engine(File *file, const char *path) :
 
     EnginePrivate::m_Instance = this;
 
+    EnginePrivate::m_pScheduler = new SystemScheduler;
+
     EnginePrivate::m_pResourceSystem = new ResourceSystem;
-    EnginePrivate::m_Serial.push_back(p_ptr->m_pResourceSystem);
+    EnginePrivate::m_pScheduler->addSystem(p_ptr->m_pResourceSystem);
     EnginePrivate::m_ApplicationPath = path;
     Uri uri(EnginePrivate::m_ApplicationPath);
     EnginePrivate::m_ApplicationDir = uri.dir();
@@ -235,6 +230,7 @@ Engine::Engine(File *file, const char *path) :
     Armature::registerClassFactory(this);
 
     EnginePrivate::m_Scene = Engine::objectCreate<Scene>("Scene");
+    EnginePrivate::m_pStreamer = new ChunkStreamer(EnginePrivate::m_Scene);
 }
 /*!
     Destructs Engine, related objects, registered object factories and platform adaptor.
@@ -242,8 +238,14 @@ Engine::Engine(File *file, const char *path) :
 Engine::~Engine() {
     PROFILE_FUNCTION();
 
+    delete EnginePrivate::m_pStreamer;
+    EnginePrivate::m_pStreamer = nullptr;
+
     deleteAllObjects();
 
+    delete EnginePrivate::m_pScheduler;
+    EnginePrivate::m_pScheduler = nullptr;
+
     delete p_ptr;
 }
 /*!
@@ -262,7 +264,7 @@ bool Engine::init() {
     Timer::reset();
     Input::init(EnginePrivate::m_Platform);
 
-    p_ptr->m_ThreadPool.setMaxThreads(MAX(ThreadPool::optimalThreadCount() - 1, 1));
+    EnginePrivate::m_pScheduler->setMaxThreads(MAX(ThreadPool::optimalThreadCount() - 1, 1));
 
     return result;
 }
@@ -276,14 +278,7 @@ bool Engine::start() {
 
     p_ptr->m_Platform->start();
 
-    for(auto it : EnginePrivate::m_Pool) {
-        if(!it->init()) {
-            Log(Log::ERR) << "Failed to initialize system:" << it->name();
-            p_ptr->m_Platform->stop();
-            return false;
-        }
-    }
-    for(auto it : EnginePrivate::m_Serial) {
+    for(auto it : EnginePrivate::m_pScheduler->systems()) {
         if(!it->init()) {
             Log(Log::ERR) << "Failed to initialize system:" << it->name();
             p_ptr->m_Platform->stop();
@@ -313,6 +308,13 @@ bool Engine::start() {
     while(p_ptr->m_Platform->isValid()) {
         update();
     }
+    // The render thread must release the context before the platform shutdown
+    for(auto it : EnginePrivate::m_pScheduler->systems()) {
+        RenderSystem *render = dynamic_cast<RenderSystem *>(it);
+        if(render) {
+            render->setThreaded(false);
+        }
+    }
     p_ptr->m_Platform->stop();
 #endif
     return true;
@@ -354,17 +356,11 @@ void Engine::update() {
 
     processEvents();
 
+    EnginePrivate::m_pStreamer->update();
+
     EnginePrivate::m_Scene->setToBeUpdated(true);
 
-    for(auto it : EnginePrivate::m_Pool) {
-        it->setActiveScene(EnginePrivate::m_Scene);
-        p_ptr->m_ThreadPool.start(*it);
-    }
-    for(auto it : EnginePrivate::m_Serial) {
-        it->setActiveScene(EnginePrivate::m_Scene);
-        it->processEvents();
-    }
-    p_ptr->m_ThreadPool.waitForDone();
+    EnginePrivate::m_pScheduler->execute(EnginePrivate::m_Scene);
 
     EnginePrivate::m_Scene->setToBeUpdated(false);
 
@@ -379,9 +375,12 @@ void Engine::processEvents() {
     ObjectSystem::processEvents();
 
     if(isGameMode()) {
-        for(auto it : m_ObjectList) {
-            NativeBehaviour *comp = dynamic_cast<NativeBehaviour *>(it);
-            if(comp && comp->isEnabled() && comp->actor() && comp->actor()->scene() == EnginePrivate::m_Scene) {
+        ComponentRegistry::Pool &pool = ComponentRegistry::pool<NativeBehaviour>();
+        // The size is checked on each step, behaviours can be created or destroyed during the update
+        for(uint32_t i = 0; i < pool.size(); i++) {
+            // Behaviours of the other systems are updated by their owners
+            if(pool.isEnabled(i) && pool.system(i) == this && pool.scene(i) == EnginePrivate::m_Scene) {
+                NativeBehaviour *comp = static_cast<NativeBehaviour *>(pool.at(i));
                 if(!comp->isStarted()) {
                     comp->start();
                     comp->setStarted(true);
@@ -389,6 +388,8 @@ void Engine::processEvents() {
                 comp->update();
             }
         }
+
+        Animator::processBatch();
     }
 }
 /*!
@@ -431,10 +432,7 @@ void Engine::setValue(const string &key, const Variant &value) {
 void Engine::syncValues() {
     PROFILE_FUNCTION();
 
-    for(auto it : EnginePrivate::m_Pool) {
-        it->syncSettings();
-    }
-    for(auto it : EnginePrivate::m_Serial) {
+    for(auto it : EnginePrivate::m_pScheduler->systems()) {
         it->syncSettings();
     }
 
@@ -496,6 +494,12 @@ void Engine::setResource(Object *object, const string &uuid) {
 
     EnginePrivate::m_pResourceSystem->setResource(static_cast<Resource *>(object), uuid);
 }
+/*!
+    Returns the current platform adaptor.
+*/
+PlatformAdaptor *Engine::platformAdaptor() {
+    return EnginePrivate::m_Platform;
+}
 /*!
     Replaces a current \a platform adaptor with new one;
     \note The previous one will not be deleted.
@@ -597,12 +601,7 @@ void Engine::addModule(Module *module) {
     PROFILE_FUNCTION();
     VariantMap metaInfo = Json::load(module->metaInfo()).toMap();
     for(auto &it : metaInfo[gSystems].toList()) {
-        System *system = module->system(it.toString().c_str());
-        if(system->threadPolicy() == System::Pool) {
-            EnginePrivate::m_Pool.push_back(system);
-        } else {
-            EnginePrivate::m_Serial.push_back(system);
-        }
+        EnginePrivate::m_pScheduler->addSystem(module->system(it.toString().c_str()));
     }
 }
 /*!
@@ -617,6 +616,7 @@ Scene *Engine::scene() {
 /*!
     Loads the scene chunk stored in the .map files by the it's \a path to the Engine.
     \note The previous chunks will be not unloaded in the case of an \a additive flag is true.
+    \note This method blocks until the chunk is loaded; use chunkStreamer() to load the chunks in the background.
 */
 Chunk *Engine::loadSceneChunk(const string &path, bool additive) {
     Map *map = loadResource<Map>(path);
@@ -644,6 +644,18 @@ void Engine::unloadSceneChunk(Chunk *chunk) {
         EnginePrivate::m_pResourceSystem->unloadResource(map);
     }
 }
+/*!
+    Returns the streamer which loads and unloads the scene chunks in the background without stalling the game cycle.
+*/
+ChunkStreamer *Engine::chunkStreamer() {
+    return EnginePrivate::m_pStreamer;
+}
+/*!
+    Returns the scheduler which executes the game systems.
+*/
+SystemScheduler *Engine::scheduler() {
+    return EnginePrivate::m_pScheduler;
+}
 /*!
     Returns file system module.
 */
@@ -0,0 +1,498 @@
+#include "framepacket.h"
+
+#include "resources/material.h"
+
+#include <cstring>
+
+#define BLOCK_SIZE  65536
+
+namespace {
+    enum CommandTypes {
+        ClearTarget,
+        DrawMesh,
+        DrawInstanced,
+        SetTarget,
+        SetColor,
+        ResetViewProjection,
+        SetViewProjection,
+        SetGlobalValue,
+        SetGlobalTexture,
+        SetViewport,
+        EnableScissor,
+        DisableScissor,
+        ExecutePacket
+    };
+
+    enum ClearFlags {
+        Color = (1<<0),
+        Depth = (1<<1)
+    };
+}
+
+class FramePacketPrivate {
+public:
+    class Snapshot : public MaterialInstance {
+    public:
+        Snapshot() :
+                MaterialInstance(nullptr) {
+
+        }
+        /*!
+            Copies the parameters of the \a instance, the parameter pointers still point to the \a instance data.
+        */
+        void assign(MaterialInstance *instance) {
+            m_pMaterial = instance->material();
+            m_SurfaceType = instance->surfaceType();
+            m_Info = instance->params();
+        }
+        /*!
+            Returns true if the snapshot contains the current parameter values of the \a instance.
+        */
+        bool isEqual(MaterialInstance *instance) {
+            MaterialInstance::InfoMap &params = instance->params();
+            if(m_pMaterial != instance->material() || m_SurfaceType != instance->surfaceType() ||
+               m_Info.size() != params.size()) {
+                return false;
+            }
+            for(auto &it : params) {
+                auto info = m_Info.find(it.first);
+                if(info == m_Info.end() || info->second.type != it.second.type || info->second.count != it.second.count) {
+                    return false;
+                }
+                uint32_t size = paramSize(it.second.type) * it.second.count;
+                if(size > 0 && it.second.ptr && info->second.ptr) {
+                    if(memcmp(info->second.ptr, it.second.ptr, size) != 0) {
+                        return false;
+                    }
+                } else if(info->second.ptr != it.second.ptr) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    struct Command {
+        uint8_t type;
+
+        uint8_t flags;
+
+        uint32_t index;
+
+        uint32_t count;
+
+        uint32_t sub;
+
+        uint32_t layer;
+
+        float depth;
+
+        void *object;
+
+        MaterialInstance *material;
+
+        Vector4 vector;
+    };
+
+    FramePacketPrivate() :
+            m_Snapshots(0),
+            m_Offset(BLOCK_SIZE) {
+
+    }
+
+    ~FramePacketPrivate() {
+        clear();
+        for(auto it : m_Blocks) {
+            delete []it;
+        }
+        for(auto it : m_Materials) {
+            delete it;
+        }
+    }
+
+    void clear() {
+        // Snapshots are reused by the next frame to keep the allocated parameter maps
+        m_Snapshots = 0;
+        m_Last.clear();
+
+        m_Commands.clear();
+        m_Matrices.clear();
+        m_Names.clear();
+        m_Values.clear();
+
+        for(auto it : m_Large) {
+            delete []it;
+        }
+        m_Large.clear();
+        // The first block is reused by the next frame, the bigger frames allocate the rest again
+        for(size_t i = 1; i < m_Blocks.size(); i++) {
+            delete []m_Blocks[i];
+        }
+        if(m_Blocks.size() > 1) {
+            m_Blocks.resize(1);
+        }
+        m_Offset = (m_Blocks.empty()) ? BLOCK_SIZE : 0;
+    }
+
+    Command &add(uint8_t type) {
+        Command command = {};
+        command.type = type;
+        m_Commands.push_back(command);
+        return m_Commands.back();
+    }
+    /*!
+        Returns the \a size bytes from the packet storage, the memory is valid until clear().
+    */
+    uint8_t *allocate(uint32_t size) {
+        size = (size + 15) & ~15;
+        if(size > BLOCK_SIZE) {
+            uint8_t *block = new uint8_t[size];
+            m_Large.push_back(block);
+            return block;
+        }
+        if(m_Offset + size > BLOCK_SIZE) {
+            m_Blocks.push_back(new uint8_t[BLOCK_SIZE]);
+            m_Offset = 0;
+        }
+        uint8_t *result = m_Blocks.back() + m_Offset;
+        m_Offset += size;
+        return result;
+    }
+
+    static uint32_t paramSize(uint32_t type) {
+        switch(type) {
+            case MetaType::INTEGER: return sizeof(int32_t);
+            case MetaType::FLOAT:   return sizeof(float);
+            case MetaType::VECTOR2: return sizeof(Vector2);
+            case MetaType::VECTOR3: return sizeof(Vector3);
+            case MetaType::VECTOR4: return sizeof(Vector4);
+            case MetaType::MATRIX4: return sizeof(Matrix4);
+            default: break;
+        }
+        return 0;
+    }
+    /*!
+        Returns a copy of the \a instance with parameter values stored in the packet.
+        The components which own the parameters can be changed or destroyed while the packet is drawn.
+    */
+    MaterialInstance *snapshot(MaterialInstance *instance) {
+        if(instance == nullptr) {
+            return nullptr;
+        }
+        // The same material is usually drawn several times per frame, for example by the shadow passes
+        auto last = m_Last.find(instance);
+        if(last != m_Last.end() && last->second->isEqual(instance)) {
+            return last->second;
+        }
+
+        if(m_Snapshots == m_Materials.size()) {
+            m_Materials.push_back(new Snapshot);
+        }
+        Snapshot *result = m_Materials[m_Snapshots];
+        m_Snapshots++;
+
+        result->assign(instance);
+        for(auto &it : result->params()) {
+            uint32_t size = paramSize(it.second.type) * it.second.count;
+            if(size > 0 && it.second.ptr) {
+                uint8_t *data = allocate(size);
+                memcpy(data, it.second.ptr, size);
+                it.second.ptr = data;
+            }
+        }
+
+        m_Last[instance] = result;
+        return result;
+    }
+
+    vector<Command> m_Commands;
+
+    vector<Matrix4> m_Matrices;
+
+    vector<string> m_Names;
+
+    vector<Variant> m_Values;
+
+    vector<Snapshot *> m_Materials;
+
+    unordered_map<MaterialInstance *, Snapshot *> m_Last;
+
+    uint32_t m_Snapshots;
+
+    vector<uint8_t *> m_Blocks;
+
+    vector<uint8_t *> m_Large;
+
+    uint32_t m_Offset;
+};
+
+/*!
+    \class FramePacket
+    \brief The FramePacket contains the rendering commands of a single frame.
+    \inmodule Engine
+
+    The packet is recorded by the FrameRecorder on the main thread and can be drawn later on the other thread with
+    replay(). The packet stores everything which can be changed by the game logic after the recording: the model
+    matrices of the visible renderables, the view and projection of the camera, global values and copies of the
+    material parameters used by the lights and renderables.
+    The resources (meshes, materials, textures and render targets) are referenced and must be alive until the packet
+    is drawn.
+*/
+FramePacket::FramePacket() :
+        p_ptr(new FramePacketPrivate) {
+
+}
+
+FramePacket::~FramePacket() {
+    delete p_ptr;
+}
+/*!
+    Removes all recorded commands.
+*/
+void FramePacket::clear() {
+    p_ptr->clear();
+}
+/*!
+    Returns the number of recorded commands.
+*/
+uint32_t FramePacket::size() const {
+    return p_ptr->m_Commands.size();
+}
+/*!
+    Executes the recorded commands on the \a buffer in the recording order.
+*/
+void FramePacket::replay(CommandBuffer &buffer) const {
+    PROFILE_FUNCTION();
+    for(auto &it : p_ptr->m_Commands) {
+        switch(it.type) {
+            case ClearTarget: {
+                buffer.clearRenderTarget(it.flags & Color, it.vector, it.flags & Depth, it.depth);
+            } break;
+            case DrawMesh: {
+                buffer.drawMesh(p_ptr->m_Matrices[it.index], static_cast<Mesh *>(it.object), it.sub, it.layer, it.material);
+            } break;
+            case DrawInstanced: {
+                buffer.drawMeshInstanced(&p_ptr->m_Matrices[it.index], it.count, static_cast<Mesh *>(it.object), it.sub, it.layer, it.material);
+            } break;
+            case SetTarget: {
+                buffer.setRenderTarget(static_cast<RenderTarget *>(it.object), it.count);
+            } break;
+            case SetColor: {
+                buffer.setColor(it.vector);
+            } break;
+            case ResetViewProjection: {
+                buffer.resetViewProjection();
+            } break;
+            case SetViewProjection: {
+                buffer.setViewProjection(p_ptr->m_Matrices[it.index], p_ptr->m_Matrices[it.index + 1]);
+            } break;
+            case SetGlobalValue: {
+                buffer.setGlobalValue(p_ptr->m_Names[it.index].c_str(), p_ptr->m_Values[it.index]);
+            } break;
+            case SetGlobalTexture: {
+                buffer.setGlobalTexture(p_ptr->m_Names[it.index].c_str(), static_cast<Texture *>(it.object));
+            } break;
+            case SetViewport: {
+                buffer.setViewport(it.vector.x, it.vector.y, it.vector.z, it.vector.w);
+            } break;
+            case EnableScissor: {
+                buffer.enableScissor(it.vector.x, it.vector.y, it.vector.z, it.vector.w);
+            } break;
+            case DisableScissor: {
+                buffer.disableScissor();
+            } break;
+            case ExecutePacket: {
+                buffer.executePacket(*static_cast<const FramePacket *>(it.object));
+            } break;
+            default: break;
+        }
+    }
+}
+
+/*!
+    \class FrameRecorder
+    \brief The FrameRecorder records the commands to the FramePacket instead of the execution.
+    \inmodule Engine
+
+    The recorder keeps the state which can be requested during the recording, like the current view and projection.
+    The recorded packet is intended to be replayed on the target buffer.
+*/
+/*!
+    Constructs a recorder for the \a target buffer.
+*/
+FrameRecorder::FrameRecorder(CommandBuffer *target) :
+        m_pTarget(target),
+        m_pPacket(nullptr) {
+
+}
+/*!
+    Returns the buffer which executes the recorded packets.
+*/
+CommandBuffer *FrameRecorder::target() const {
+    return m_pTarget;
+}
+/*!
+    Returns the packet which receives the commands.
+*/
+FramePacket *FrameRecorder::packet() const {
+    return m_pPacket;
+}
+/*!
+    Sets the \a packet which receives the commands. Commands are dropped if the packet is not set.
+*/
+void FrameRecorder::setPacket(FramePacket *packet) {
+    m_pPacket = packet;
+}
+
+void FrameRecorder::clearRenderTarget(bool clearColor, const Vector4 &color, bool clearDepth, float depth) {
+    if(m_pPacket) {
+        FramePacketPrivate::Command &command = m_pPacket->p_ptr->add(ClearTarget);
+        command.flags = (clearColor ? Color : 0) | (clearDepth ? Depth : 0);
+        command.vector = color;
+        command.depth = depth;
+    }
+}
+
+void FrameRecorder::drawMesh(const Matrix4 &model, Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance *material) {
+    if(m_pPacket && mesh && material) {
+        FramePacketPrivate *packet = m_pPacket->p_ptr;
+
+        FramePacketPrivate::Command &command = packet->add(DrawMesh);
+        command.index = packet->m_Matrices.size();
+        command.sub = sub;
+        command.layer = layer;
+        command.object = mesh;
+        command.material = packet->snapshot(material);
+
+        packet->m_Matrices.push_back(model);
+    }
+}
+
+void FrameRecorder::drawMeshInstanced(const Matrix4 *models, uint32_t count, Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance *material) {
+    if(m_pPacket && mesh && material && count > 0) {
+        FramePacketPrivate *packet = m_pPacket->p_ptr;
+
+        FramePacketPrivate::Command &command = packet->add(DrawInstanced);
+        command.index = packet->m_Matrices.size();
+        command.count = count;
+        command.sub = sub;
+        command.layer = layer;
+        command.object = mesh;
+        command.material = packet->snapshot(material);
+
+        packet->m_Matrices.insert(packet->m_Matrices.end(), models, models + count);
+    }
+}
+
+void FrameRecorder::setRenderTarget(RenderTarget *target, uint32_t level) {
+    if(m_pPacket) {
+        FramePacketPrivate::Command &command = m_pPacket->p_ptr->add(SetTarget);
+        command.object = target;
+        command.count = level;
+    }
+}
+
+void FrameRecorder::setColor(const Vector4 &color) {
+    if(m_pPacket) {
+        FramePacketPrivate::Command &command = m_pPacket->p_ptr->add(SetColor);
+        command.vector = color;
+    }
+}
+
+void FrameRecorder::resetViewProjection() {
+    m_View = m_SaveView;
+    m_Projection = m_SaveProjection;
+
+    if(m_pPacket) {
+        m_pPacket->p_ptr->add(ResetViewProjection);
+    }
+}
+
+void FrameRecorder::setViewProjection(const Matrix4 &view, const Matrix4 &projection) {
+    m_SaveView = m_View;
+    m_SaveProjection = m_Projection;
+
+    m_View = view;
+    m_Projection = projection;
+
+    if(m_pPacket) {
+        FramePacketPrivate *packet = m_pPacket->p_ptr;
+
+        FramePacketPrivate::Command &command = packet->add(SetViewProjection);
+        command.index = packet->m_Matrices.size();
+
+        packet->m_Matrices.push_back(view);
+        packet->m_Matrices.push_back(projection);
+    }
+}
+
+void FrameRecorder::setGlobalValue(const char *name, const Variant &value) {
+    if(m_pPacket) {
+        FramePacketPrivate *packet = m_pPacket->p_ptr;
+
+        FramePacketPrivate::Command &command = packet->add(SetGlobalValue);
+        command.index = packet->m_Names.size();
+
+        packet->m_Names.push_back(name);
+        packet->m_Values.push_back(value);
+    }
+}
+
+void FrameRecorder::setGlobalTexture(const char *name, Texture *value) {
+    m_Textures[name] = value;
+
+    if(m_pPacket) {
+        FramePacketPrivate *packet = m_pPacket->p_ptr;
+
+        FramePacketPrivate::Command &command = packet->add(SetGlobalTexture);
+        command.index = packet->m_Names.size();
+        command.object = value;
+
+        packet->m_Names.push_back(name);
+        packet->m_Values.push_back(Variant());
+    }
+}
+
+void FrameRecorder::setViewport(int32_t x, int32_t y, int32_t width, int32_t height) {
+    if(m_pPacket) {
+        FramePacketPrivate::Command &command = m_pPacket->p_ptr->add(SetViewport);
+        // Screen coordinates are exactly representable with floats
+        command.vector = Vector4(x, y, width, height);
+    }
+}
+
+void FrameRecorder::enableScissor(int32_t x, int32_t y, int32_t width, int32_t height) {
+    if(m_pPacket) {
+        FramePacketPrivate::Command &command = m_pPacket->p_ptr->add(EnableScissor);
+        command.vector = Vector4(x, y, width, height);
+    }
+}
+
+void FrameRecorder::disableScissor() {
+    if(m_pPacket) {
+        m_pPacket->p_ptr->add(DisableScissor);
+    }
+}
+
+void FrameRecorder::executePacket(const FramePacket &packet) {
+    if(m_pPacket) {
+        FramePacketPrivate::Command &command = m_pPacket->p_ptr->add(ExecutePacket);
+        command.object = const_cast<FramePacket *>(&packet);
+    }
+}
+
+Matrix4 FrameRecorder::projection() const {
+    return m_Projection;
+}
+
+Matrix4 FrameRecorder::view() const {
+    return m_View;
+}
+
+Texture *FrameRecorder::texture(const char *name) const {
+    auto it = m_Textures.find(name);
+    if(it != m_Textures.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
@@ -0,0 +1,299 @@
+#include "prefabpool.h"
+
+#include "components/actor.h"
+
+#include "resources/prefab.h"
+
+#include "componentregistry.h"
+
+#include <threadpool.h>
+
+#include <atomic>
+#include <unordered_set>
+
+#define POOL_INSTANCES  "Prefab Pool Instances"
+#define POOL_AVAILABLE  "Prefab Pool Available"
+#define POOL_ACTIVE     "Prefab Pool Active"
+
+namespace {
+    atomic<int32_t> s_Instances(0);
+    atomic<int32_t> s_Available(0);
+    atomic<int32_t> s_Active(0);
+}
+
+class PrefabPoolPrivate : public Object {
+public:
+    struct Instance {
+        Actor *actor;
+
+        bool dirty;
+    };
+
+    struct Clone {
+        Actor *actor;
+
+        ComponentRegistry::Deferred *components;
+    };
+
+    explicit PrefabPoolPrivate(Prefab *prefab) :
+            m_pPrefab(prefab),
+            m_pSnapshot(nullptr),
+            m_Pending(0),
+            m_Running(false) {
+
+        m_Pool.setMaxThreads(1);
+    }
+
+    ~PrefabPoolPrivate() {
+        delete m_pSnapshot;
+    }
+    /*!
+        Copies the \a origin hierarchy on the main thread, the worker clones this copy instead of the live prefab which
+        can be edited or reloaded meanwhile. Must be called only while the worker is idle.
+    */
+    void takeSnapshot(Actor *origin) {
+        PROFILE_FUNCTION();
+        delete m_pSnapshot;
+
+        // The snapshot is never added to the scene, so its components stay out of the pools
+        ComponentRegistry::Deferred components;
+        components.begin();
+        m_pSnapshot = static_cast<Actor *>(origin->Object::clone());
+        m_pSnapshot->setEnabled(false);
+        components.end();
+        components.clear();
+    }
+    /*!
+        Instantiates the requested copies of the prefab snapshot on the worker thread.
+    */
+    void processEvents() override {
+        PROFILE_FUNCTION();
+        while(true) {
+            Actor *origin = nullptr;
+            {
+                unique_lock<mutex> locker(m_Mutex);
+                origin = m_pSnapshot;
+                if(m_Pending == 0 || origin == nullptr) {
+                    m_Pending = 0;
+                    m_Running = false;
+                    return;
+                }
+                m_Pending--;
+            }
+            // Prefab subscription is not thread safe, the instance will be linked to the prefab in collect()
+            ComponentRegistry::Deferred *components = new ComponentRegistry::Deferred;
+            components->begin();
+            Actor *actor = static_cast<Actor *>(origin->Object::clone());
+            actor->setEnabled(false);
+            components->end();
+            {
+                unique_lock<mutex> locker(m_Mutex);
+                m_Ready.push_back({actor, components});
+            }
+        }
+    }
+    /*!
+        Moves the instances created by the worker thread to the list of available instances.
+    */
+    void collect() {
+        vector<Clone> ready;
+        {
+            unique_lock<mutex> locker(m_Mutex);
+            ready.swap(m_Ready);
+        }
+        for(auto &it : ready) {
+            it.components->commit(it.components->size());
+            delete it.components;
+
+            it.actor->setPrefab(m_pPrefab);
+            m_Free.push_back({it.actor, false});
+        }
+        s_Instances += static_cast<int32_t>(ready.size());
+        s_Available += static_cast<int32_t>(ready.size());
+        updateStats();
+    }
+
+    static void updateStats() {
+        PROFILER_RESET(POOL_INSTANCES);
+        PROFILER_RESET(POOL_AVAILABLE);
+        PROFILER_RESET(POOL_ACTIVE);
+
+        PROFILER_STAT(POOL_INSTANCES, s_Instances);
+        PROFILER_STAT(POOL_AVAILABLE, s_Available);
+        PROFILER_STAT(POOL_ACTIVE, s_Active);
+    }
+
+    Prefab *m_pPrefab;
+
+    Actor *m_pSnapshot;
+
+    vector<Instance> m_Free;
+
+    unordered_set<Actor *> m_Active;
+
+    vector<Clone> m_Ready;
+
+    mutex m_Mutex;
+
+    uint32_t m_Pending;
+
+    bool m_Running;
+
+    ThreadPool m_Pool;
+};
+
+/*!
+    \class PrefabPool
+    \brief Keeps the ready to use instances of the Prefab.
+    \inmodule Engine
+
+    The pool helps to spawn and despawn the frequently used prefabs like bullets, effects or pickups without
+    creating and destroying the whole hierarchy each time.
+    Instances are created in the background with reserve() or on demand with acquire().
+    The acquired instance is disabled; enable it after the placement.
+    The released instance is detached from the scene and reset to the prefab defaults on the next acquire().
+
+    The number of instances, available and active instances of all pools are reported to the profiler.
+
+    \note The acquired instances must be returned to the pool with release() instead of deletion.
+*/
+/*!
+    Constructs a pool for \a prefab and starts the background instantiation of \a capacity copies.
+*/
+PrefabPool::PrefabPool(Prefab *prefab, uint32_t capacity) :
+        p_ptr(new PrefabPoolPrivate(prefab)) {
+
+    if(prefab) {
+        prefab->incRef();
+    }
+    reserve(capacity);
+}
+/*!
+    Destroys the pool and all available instances. Active instances stay alive and belong to their parents.
+*/
+PrefabPool::~PrefabPool() {
+    p_ptr->m_Pool.waitForDone();
+    p_ptr->collect();
+
+    for(auto &it : p_ptr->m_Free) {
+        delete it.actor;
+    }
+    s_Instances -= static_cast<int32_t>(p_ptr->m_Free.size() + p_ptr->m_Active.size());
+    s_Available -= static_cast<int32_t>(p_ptr->m_Free.size());
+    s_Active -= static_cast<int32_t>(p_ptr->m_Active.size());
+    PrefabPoolPrivate::updateStats();
+
+    if(p_ptr->m_pPrefab) {
+        p_ptr->m_pPrefab->decRef();
+    }
+
+    delete p_ptr;
+}
+/*!
+    Returns the prefab instantiated by this pool.
+*/
+Prefab *PrefabPool::prefab() const {
+    return p_ptr->m_pPrefab;
+}
+/*!
+    Requests \a count additional instances to be created on the background thread.
+    The instances are built from a copy of the prefab taken on the calling thread, so the prefab can be edited meanwhile.
+*/
+void PrefabPool::reserve(uint32_t count) {
+    PROFILE_FUNCTION();
+    Actor *origin = (p_ptr->m_pPrefab) ? p_ptr->m_pPrefab->actor() : nullptr;
+    if(count == 0 || origin == nullptr) {
+        return;
+    }
+
+    bool start = false;
+    {
+        unique_lock<mutex> locker(p_ptr->m_Mutex);
+        p_ptr->m_Pending += count;
+        if(!p_ptr->m_Running) {
+            p_ptr->m_Running = true;
+            start = true;
+        }
+    }
+    if(start) {
+        // The running worker keeps the snapshot of its batch, the new one is taken for the next batch only
+        p_ptr->takeSnapshot(origin);
+        p_ptr->m_Pool.start(*p_ptr);
+    }
+}
+/*!
+    Returns a disabled instance of the prefab attached to the \a parent.
+    A new instance will be created in case of the pool is empty.
+*/
+Actor *PrefabPool::acquire(Object *parent) {
+    PROFILE_FUNCTION();
+    p_ptr->collect();
+
+    Actor *result = nullptr;
+    if(p_ptr->m_Free.empty()) {
+        Actor *origin = (p_ptr->m_pPrefab) ? p_ptr->m_pPrefab->actor() : nullptr;
+        if(origin == nullptr) {
+            return nullptr;
+        }
+        result = static_cast<Actor *>(origin->clone());
+        s_Instances++;
+    } else {
+        PrefabPoolPrivate::Instance instance = p_ptr->m_Free.back();
+        p_ptr->m_Free.pop_back();
+        s_Available--;
+
+        result = instance.actor;
+        if(instance.dirty) {
+            result->resetToPrefab();
+        }
+    }
+
+    result->setEnabled(false);
+    result->setParent(parent);
+
+    p_ptr->m_Active.insert(result);
+    s_Active++;
+    PrefabPoolPrivate::updateStats();
+
+    return result;
+}
+/*!
+    Returns the \a actor to the pool. The \a actor will be disabled and detached from its parent.
+*/
+void PrefabPool::release(Actor *actor) {
+    PROFILE_FUNCTION();
+    auto it = p_ptr->m_Active.find(actor);
+    if(it == p_ptr->m_Active.end()) {
+        return;
+    }
+    p_ptr->m_Active.erase(it);
+
+    actor->setEnabled(false);
+    actor->setParent(nullptr);
+
+    p_ptr->m_Free.push_back({actor, true});
+
+    s_Active--;
+    s_Available++;
+    PrefabPoolPrivate::updateStats();
+}
+/*!
+    Returns the total number of instances owned by the pool.
+*/
+uint32_t PrefabPool::size() const {
+    p_ptr->collect();
+    return p_ptr->m_Free.size() + p_ptr->m_Active.size();
+}
+/*!
+    Returns the number of instances ready to be acquired.
+*/
+uint32_t PrefabPool::available() const {
+    p_ptr->collect();
+    return p_ptr->m_Free.size();
+}
+/*!
+    Returns the number of acquired instances.
+*/
+uint32_t PrefabPool::active() const {
+    return p_ptr->m_Active.size();
+}
@@ -1,6 +1,69 @@
 #include "resources/animationclip.h"
 
-#define TRACKS  "Tracks"
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+
+#define TRACKS      "Tracks"
+#define COMPRESSED  "Compressed"
+
+#define SAMPLE_RATE 60
+
+#define QUAT_SCALE  32767.0f
+#define QUAT_RANGE  1.41421356f // sqrt(2)
+#define KEY_SCALE   65535.0f
+
+namespace {
+    uint16_t quantize(float value, float min, float range) {
+        if(range <= 0.0f) {
+            return 0;
+        }
+        return static_cast<uint16_t>(CLAMP((value - min) / range, 0.0f, 1.0f) * KEY_SCALE + 0.5f);
+    }
+
+    void packQuaternion(const float q[4], uint16_t *result) {
+        int32_t index = 0;
+        for(int32_t i = 1; i < 4; i++) {
+            if(fabsf(q[i]) > fabsf(q[index])) {
+                index = i;
+            }
+        }
+        float sign = (q[index] < 0.0f) ? -1.0f : 1.0f;
+
+        int32_t c = 0;
+        for(int32_t i = 0; i < 4; i++) {
+            if(i != index) {
+                float v = CLAMP(q[i] * sign * QUAT_RANGE * 0.5f + 0.5f, 0.0f, 1.0f); // [-1/sqrt(2), 1/sqrt(2)] -> [0, 1]
+                result[c] = static_cast<uint16_t>(v * QUAT_SCALE + 0.5f);
+                c++;
+            }
+        }
+        result[0] |= (index & 1) << 15;
+        result[1] |= (index >> 1) << 15;
+    }
+
+    void unpackQuaternion(const uint16_t *data, float *result) {
+        int32_t index = (data[0] >> 15) | ((data[1] >> 15) << 1);
+
+        float sum = 0.0f;
+        int32_t c = 0;
+        for(int32_t i = 0; i < 4; i++) {
+            if(i != index) {
+                float v = static_cast<float>(data[c] & 0x7fff) / QUAT_SCALE;
+                result[i] = (v - 0.5f) * 2.0f / QUAT_RANGE;
+                sum += result[i] * result[i];
+                c++;
+            }
+        }
+        result[index] = sqrtf(MAX(1.0f - sum, 0.0f));
+    }
+}
+
+namespace {
+    bool isTransformTrack(const string &property) {
+        return property == "position" || property == "quaternion" || property == "scale";
+    }
+}
 
 static hash<string> hash_str;
 
@@ -111,6 +174,10 @@ AnimationTrack::CurveMap &AnimationTrack::curves() {
     Which allows them to animate elements independently.
 */
 
+AnimationClip::AnimationClip() :
+        m_Compressed(false) {
+
+}
 /*!
     \internal
 */
@@ -118,6 +185,16 @@ void AnimationClip::loadUserData(const VariantMap &data) {
     PROFILE_FUNCTION();
 
     m_Tracks.clear();
+    m_Compiled.clear();
+    m_Samples.clear();
+    m_Data.clear();
+    m_Times.clear();
+    m_Compressed = false;
+
+    auto compressed = data.find(COMPRESSED);
+    if(compressed != data.end()) {
+        loadCompressed((*compressed).second.toList());
+    }
 
     auto section = data.find(TRACKS);
     if(section != data.end()) {
@@ -166,6 +243,17 @@ void AnimationClip::loadUserData(const VariantMap &data) {
             m_Tracks.push_back(track);
         }
     }
+
+    if(m_Compressed) {
+        // The tracks which are not compressed are stored with curves
+        for(auto &it : m_Tracks) {
+            if(!it.curves().empty()) {
+                compileTrack(it);
+            }
+        }
+    } else {
+        compile();
+    }
 }
 /*!
     \internal
@@ -173,8 +261,15 @@ void AnimationClip::loadUserData(const VariantMap &data) {
 VariantMap AnimationClip::saveUserData() const {
     VariantMap result;
 
+    if(m_Compressed) {
+        result[COMPRESSED] = saveCompressed();
+    }
+
     VariantList tracks;
     for(auto t : m_Tracks) {
+        if(m_Compressed && t.curves().empty()) {
+            continue;
+        }
         VariantList track;
         track.push_back(t.path());
         track.push_back(t.property());
@@ -218,3 +313,384 @@ int AnimationClip::duration() const {
     }
     return result;
 }
+/*!
+    Converts animation tracks to the compiled form.
+    Each curve will be resampled with a fixed frame rate and stored in the single contiguous array.
+    Sample values for all components of the frame are placed together which allows to evaluate a track in the constant time.
+    \note This method is called automatically on resource loading and must be called manually in case of track modifications.
+*/
+void AnimationClip::compile() {
+    PROFILE_FUNCTION();
+
+    m_Compiled.clear();
+    m_Samples.clear();
+    m_Data.clear();
+    m_Times.clear();
+    m_Compressed = false;
+
+    for(auto &it : m_Tracks) {
+        compileTrack(it);
+    }
+}
+/*!
+    \internal
+    Resamples the curves of the \a track and appends the result to the compiled tracks.
+*/
+void AnimationClip::compileTrack(AnimationTrack &track) {
+    AnimationTrack::CurveMap &curves = track.curves();
+    if(curves.empty()) {
+        return;
+    }
+
+    CompiledTrack compiled;
+    memset(&compiled, 0, sizeof(CompiledTrack));
+    compiled.hash = track.hash();
+    compiled.format = Sampled;
+    compiled.duration = track.duration();
+    compiled.components = curves.rbegin()->first + 1;
+    compiled.frames = MAX(compiled.duration * SAMPLE_RATE / 1000, 1) + 1;
+    compiled.offset = m_Samples.size();
+
+    m_Samples.resize(compiled.offset + compiled.frames * compiled.components, 0.0f);
+
+    for(auto &curve : curves) {
+        uint32_t cursor = 0;
+        for(int32_t f = 0; f < compiled.frames; f++) {
+            float position = static_cast<float>(f) / static_cast<float>(compiled.frames - 1);
+            m_Samples[compiled.offset + f * compiled.components + curve.first] = curve.second.value(position, cursor);
+        }
+    }
+
+    m_Compiled.push_back(compiled);
+}
+/*!
+    Returns the list of compiled tracks.
+    \sa compile()
+*/
+const AnimationClip::CompiledTracks &AnimationClip::compiledTracks() const {
+    return m_Compiled;
+}
+/*!
+    Returns the compiled track with provided \a hash of path and property; returns nullptr if the track doesn't exist.
+*/
+const AnimationClip::CompiledTrack *AnimationClip::compiledTrack(int32_t hash) const {
+    for(auto &it : m_Compiled) {
+        if(it.hash == hash) {
+            return &it;
+        }
+    }
+    return nullptr;
+}
+/*!
+    Evaluates compiled \a track at normalized \a position and writes the values for all components to the \a result.
+    Compressed tracks are decoded on the fly, only two neighbour keys are decompressed.
+*/
+void AnimationClip::sample(const CompiledTrack &track, float position, float *result) const {
+    if(track.format == Sampled) {
+        float frame = CLAMP(position, 0.0f, 1.0f) * static_cast<float>(track.frames - 1);
+        int32_t index = MIN(static_cast<int32_t>(frame), track.frames - 1);
+        int32_t next = MIN(index + 1, track.frames - 1);
+        float factor = frame - static_cast<float>(index);
+
+        const float *a = &m_Samples[track.offset + index * track.components];
+        const float *b = &m_Samples[track.offset + next * track.components];
+        for(int32_t i = 0; i < track.components; i++) {
+            result[i] = MIX(a[i], b[i], factor);
+        }
+        return;
+    }
+
+    int32_t a, b;
+    float factor;
+    keyRange(track, position, a, b, factor);
+
+    if(track.format == SmallestThree) {
+        float qa[4], qb[4];
+        unpackQuaternion(&m_Data[track.offset + a * 3], qa);
+        unpackQuaternion(&m_Data[track.offset + b * 3], qb);
+
+        float dot = qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3];
+        float sign = (dot < 0.0f) ? -1.0f : 1.0f;
+        for(int32_t i = 0; i < 4; i++) {
+            result[i] = MIX(qa[i], qb[i] * sign, factor);
+        }
+        return;
+    }
+
+    const uint16_t *ka = &m_Data[track.offset + a * track.components];
+    const uint16_t *kb = &m_Data[track.offset + b * track.components];
+    for(int32_t i = 0; i < track.components; i++) {
+        float va = track.min[i] + static_cast<float>(ka[i]) / KEY_SCALE * track.range[i];
+        float vb = track.min[i] + static_cast<float>(kb[i]) / KEY_SCALE * track.range[i];
+        result[i] = MIX(va, vb, factor);
+    }
+}
+/*!
+    Returns true if the clip contains compressed tracks; otherwise returns false.
+*/
+bool AnimationClip::isCompressed() const {
+    return m_Compressed;
+}
+/*!
+    Converts animation tracks to the compressed form.
+    Keys are stored with 16-bit quantized time and values, quaternions use the smallest-three encoding with 15 bits per component.
+    Tracks with a single key are stored as constants.
+    The compressed keys are interpolated linearly, so the tracks with the linear keys keep their key positions and
+    the other tracks are resampled with a fixed frame rate in addition to the key positions.
+    Only the position, quaternion and scale tracks are compressed, other tracks are compiled as usual.
+    \note Animation curves of the compressed tracks are released after the compression, those tracks can be evaluated only with sample().
+*/
+void AnimationClip::compress() {
+    PROFILE_FUNCTION();
+
+    m_Compiled.clear();
+    m_Samples.clear();
+    m_Data.clear();
+    m_Times.clear();
+
+    for(auto &it : m_Tracks) {
+        AnimationTrack::CurveMap &curves = it.curves();
+        if(curves.empty()) {
+            continue;
+        }
+        if(!isTransformTrack(it.property())) {
+            compileTrack(it);
+            continue;
+        }
+
+        CompiledTrack track;
+        memset(&track, 0, sizeof(CompiledTrack));
+        track.hash = it.hash();
+        track.duration = it.duration();
+        track.components = MIN(curves.rbegin()->first + 1, 4);
+        track.format = (it.property() == "quaternion" && track.components == 4) ? SmallestThree : Quantized;
+
+        // Key positions of all curves, the keys of different curves may not match
+        bool linear = true;
+        vector<uint16_t> times;
+        for(auto &curve : curves) {
+            const AnimationCurve::Keys &keys = curve.second.m_Keys;
+            for(uint32_t k = 0; k < keys.size(); k++) {
+                times.push_back(quantize(keys[k].m_Position, 0.0f, 1.0f));
+                if(k + 1 < keys.size() && keys[k].m_Type != AnimationCurve::KeyFrame::Linear) {
+                    linear = false;
+                }
+            }
+        }
+        if(!linear) {
+            int32_t frames = MAX(track.duration * SAMPLE_RATE / 1000, 1) + 1;
+            for(int32_t f = 0; f < frames; f++) {
+                times.push_back(quantize(static_cast<float>(f) / static_cast<float>(frames - 1), 0.0f, 1.0f));
+            }
+        }
+        std::sort(times.begin(), times.end());
+        times.erase(std::unique(times.begin(), times.end()), times.end());
+        if(times.empty()) {
+            times.push_back(0);
+        }
+
+        track.frames = times.size();
+        track.times = m_Times.size();
+        track.offset = m_Data.size();
+        m_Times.insert(m_Times.end(), times.begin(), times.end());
+
+        vector<float> values(track.frames * 4, 0.0f);
+        for(int32_t c = 0; c < track.components; c++) {
+            auto curve = curves.find(c);
+            if(curve == curves.end()) {
+                continue;
+            }
+            uint32_t cursor = 0;
+            for(int32_t f = 0; f < track.frames; f++) {
+                values[f * 4 + c] = curve->second.value(static_cast<float>(times[f]) / KEY_SCALE, cursor);
+            }
+        }
+
+        for(int32_t c = 0; c < track.components; c++) {
+            float min = FLT_MAX;
+            float max =-FLT_MAX;
+            for(int32_t f = 0; f < track.frames; f++) {
+                min = MIN(min, values[f * 4 + c]);
+                max = MAX(max, values[f * 4 + c]);
+            }
+            track.min[c] = min;
+            track.range[c] = max - min;
+        }
+
+        for(int32_t f = 0; f < track.frames; f++) {
+            float *value = &values[f * 4];
+            if(track.format == SmallestThree) {
+                Quaternion q(value[0], value[1], value[2], value[3]);
+                q.normalize();
+
+                uint16_t packed[3];
+                packQuaternion(q.q, packed);
+                m_Data.insert(m_Data.end(), packed, packed + 3);
+            } else {
+                for(int32_t c = 0; c < track.components; c++) {
+                    m_Data.push_back(quantize(value[c], track.min[c], track.range[c]));
+                }
+            }
+        }
+
+        m_Compiled.push_back(track);
+
+        curves.clear();
+    }
+
+    m_Compressed = true;
+}
+/*!
+    \internal
+    Finds the pair of keys \a a and \a b around the normalized \a position and interpolation \a factor between them.
+*/
+void AnimationClip::keyRange(const CompiledTrack &track, float position, int32_t &a, int32_t &b, float &factor) const {
+    a = b = 0;
+    factor = 0.0f;
+    if(track.frames < 2) {
+        return;
+    }
+
+    uint16_t time = quantize(position, 0.0f, 1.0f);
+
+    auto begin = m_Times.begin() + track.times;
+    auto end = begin + track.frames;
+    auto it = std::upper_bound(begin, end, time);
+    if(it == begin) {
+        return;
+    }
+    if(it == end) {
+        a = b = track.frames - 1;
+        return;
+    }
+    b = static_cast<int32_t>(std::distance(begin, it));
+    a = b - 1;
+
+    float ta = static_cast<float>(*(it - 1));
+    float tb = static_cast<float>(*it);
+    factor = (tb > ta) ? (static_cast<float>(time) - ta) / (tb - ta) : 0.0f;
+}
+/*!
+    \internal
+*/
+void AnimationClip::loadCompressed(const VariantList &data) {
+    PROFILE_FUNCTION();
+
+    m_Compiled.clear();
+    m_Samples.clear();
+    m_Data.clear();
+    m_Times.clear();
+
+    for(auto &it : data) {
+        VariantList trackData = it.toList();
+        if(trackData.size() < 9) {
+            continue;
+        }
+        auto i = trackData.begin();
+
+        AnimationTrack track;
+        track.setPath((*i).toString());
+        i++;
+        track.setProperty((*i).toString());
+        i++;
+        track.setDuration((*i).toInt());
+        i++;
+
+        CompiledTrack compiled;
+        memset(&compiled, 0, sizeof(CompiledTrack));
+        compiled.hash = track.hash();
+        compiled.duration = track.duration();
+        compiled.format = (*i).toInt();
+        i++;
+        compiled.components = MIN((*i).toInt(), 4);
+        i++;
+
+        int32_t c = 0;
+        for(auto &v : (*i).toList()) {
+            if(c < 4) {
+                compiled.min[c] = v.toFloat();
+            }
+            c++;
+        }
+        i++;
+        c = 0;
+        for(auto &v : (*i).toList()) {
+            if(c < 4) {
+                compiled.range[c] = v.toFloat();
+            }
+            c++;
+        }
+        i++;
+
+        ByteArray times = (*i).toByteArray();
+        i++;
+        ByteArray values = (*i).toByteArray();
+
+        compiled.frames = times.size() / sizeof(uint16_t);
+        compiled.times = m_Times.size();
+        compiled.offset = m_Data.size();
+
+        m_Times.resize(compiled.times + compiled.frames);
+        if(!times.empty()) {
+            memcpy(&m_Times[compiled.times], &times[0], times.size());
+        }
+        m_Data.resize(compiled.offset + values.size() / sizeof(uint16_t));
+        if(!values.empty()) {
+            memcpy(&m_Data[compiled.offset], &values[0], values.size());
+        }
+
+        m_Tracks.push_back(track);
+        m_Compiled.push_back(compiled);
+    }
+
+    m_Compressed = true;
+}
+/*!
+    \internal
+*/
+VariantList AnimationClip::saveCompressed() const {
+    VariantList result;
+
+    auto track = m_Tracks.begin();
+    for(auto &it : m_Compiled) {
+        if(it.format == Sampled) {
+            continue;
+        }
+        while(track != m_Tracks.end() && track->hash() != it.hash) {
+            ++track;
+        }
+        if(track == m_Tracks.end()) {
+            break;
+        }
+
+        VariantList data;
+        data.push_back(track->path());
+        data.push_back(track->property());
+        data.push_back(track->duration());
+        data.push_back(it.format);
+        data.push_back(it.components);
+
+        VariantList min;
+        VariantList range;
+        for(int32_t c = 0; c < it.components; c++) {
+            min.push_back(it.min[c]);
+            range.push_back(it.range[c]);
+        }
+        data.push_back(min);
+        data.push_back(range);
+
+        uint32_t stride = (it.format == SmallestThree) ? 3 : it.components;
+
+        ByteArray times(it.frames * sizeof(uint16_t));
+        memcpy(&times[0], &m_Times[it.times], times.size());
+        data.push_back(times);
+
+        ByteArray values(it.frames * stride * sizeof(uint16_t));
+        memcpy(&values[0], &m_Data[it.offset], values.size());
+        data.push_back(values);
+
+        result.push_back(data);
+    }
+
+    return result;
+}
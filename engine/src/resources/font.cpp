@@ -12,162 +12,331 @@
 
 #include "log.h"
 
+#include <threadpool.h>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <cfloat>
+#include <cstring>
+
 #define HEADER  "Header"
 #define DATA    "Data"
 
 #define DF_GLYPH_SIZE 128
 #define DF_DEFAULT_SCALE 4
 
+#define GLYPH_BATCH 8
+
+#define PLACEHOLDER_INDEX 0
+#define BLANK_INDEX 1
+#define PLACEHOLDER_SIZE 16
+
+static FT_Library library = nullptr;
+//FT_Done_FreeType(library);
+
+static atomic<uint32_t> s_Revision(0);
+
+struct GlyphData {
+    uint32_t character;
+
+    int32_t width;
+    int32_t height;
+
+    int32_t box[4];
+
+    ByteArray pixels;
+};
+/*!
+    \internal
+    Results of the glyph generation shared between the font and its worker tasks.
+*/
+class GlyphQueue {
+public:
+    GlyphQueue() :
+            m_Ready(false),
+            m_Cancel(false) {
+
+    }
+
+    mutex m_Mutex;
+
+    list<GlyphData> m_Results;
+
+    atomic<bool> m_Ready;
+
+    atomic<bool> m_Cancel;
+};
+
 class FontPrivate {
 public:
     FontPrivate() :
+        m_Queue(make_shared<GlyphQueue>()),
         m_pFace(nullptr),
         m_Scale(DF_GLYPH_SIZE * DF_DEFAULT_SCALE),
+        m_SpaceWidth(0.0f),
+        m_LineHeight(0.0f),
+        m_Revision(++s_Revision),
         m_UseKerning(false) {
     }
 
+    /*!
+        Adds the placeholder glyph which is used while the real glyph is being generated and the blank glyph for the characters without an outline.
+    */
+    void addReserved(Font *font) {
+        ByteArray buffer;
+        buffer.resize(PLACEHOLDER_SIZE * PLACEHOLDER_SIZE);
+        for(int32_t y = 0; y < PLACEHOLDER_SIZE; y++) {
+            for(int32_t x = 0; x < PLACEHOLDER_SIZE; x++) {
+                int32_t d = MIN(MIN(x, y), MIN(PLACEHOLDER_SIZE - 1 - x, PLACEHOLDER_SIZE - 1 - y));
+                buffer[y * PLACEHOLDER_SIZE + x] = CLAMP(80 + d * 24, 0, 255);
+            }
+        }
+        addElement(font, buffer, PLACEHOLDER_SIZE, PLACEHOLDER_SIZE,
+                   {Vector3(0.05f, 0.7f, 0.0f), Vector3(0.55f, 0.7f, 0.0f), Vector3(0.55f, 0.0f, 0.0f), Vector3(0.05f, 0.0f, 0.0f)});
+
+        buffer.assign(1, 0);
+        addElement(font, buffer, 1, 1, {Vector3(), Vector3(), Vector3(), Vector3()});
+    }
+
+    int addElement(Font *font, const ByteArray &pixels, int32_t width, int32_t height, const Vector3Vector &vertices) {
+        Texture::Surface s;
+        s.push_back(pixels);
+
+        Texture *t = Engine::objectCreate<Texture>("", font);
+        t->setWidth(width);
+        t->setHeight(height);
+        t->addSurface(s);
+
+        int index = font->addElement(t);
+        Lod *lod = font->mesh(index)->lod(0);
+        if(lod) {
+            lod->setVertices(vertices);
+        }
+        return index;
+    }
+
+    /*!
+        Stops all running glyph tasks. The results of the stopped tasks will be ignored.
+    */
+    void cancel() {
+        m_Queue->m_Cancel = true;
+        m_Queue = make_shared<GlyphQueue>();
+        m_Requested.clear();
+    }
+
+    static ThreadPool &pool() {
+        static ThreadPool pool;
+        static bool init = false;
+        if(!init) {
+            pool.setMaxThreads(MAX(ThreadPool::optimalThreadCount() / 2, 1));
+            init = true;
+        }
+        return pool;
+    }
+
     typedef unordered_map<uint32_t, uint32_t> GlyphMap;
     typedef unordered_map<uint32_t, Vector2> SpecialMap;
 
     GlyphMap m_GlyphMap;
-    ByteArray m_Data;
-
-    FT_FaceRec_ *m_pFace;
+    unordered_set<uint32_t> m_Requested;
 
-    int32_t m_Scale;
-
-    bool m_UseKerning;
-};
+    unordered_map<uint64_t, int32_t> m_Kerning;
 
-struct Point {
-    short dx, dy;
-    int f;
-};
+    shared_ptr<ByteArray> m_Data;
 
-struct Grid {
-    int32_t w, h;
-    Point *grid;
-};
+    shared_ptr<GlyphQueue> m_Queue;
 
-static Point pointInside = { 0, 0, 0 };
-static Point pointEmpty = { 9999, 9999, 9999*9999 };
+    FT_FaceRec_ *m_pFace;
 
-static FT_Library library = nullptr;
-//FT_Done_FreeType(library);
+    int32_t m_Scale;
 
-static inline Point get(Grid &g, int32_t x, int32_t y) {
-    return g.grid[y * (g.w + 2) + x];
-}
+    float m_SpaceWidth;
+    float m_LineHeight;
 
-static inline void put(Grid &g, int32_t x, int32_t y, const Point &p) {
-    g.grid[y * (g.w + 2) + x] = p;
-}
+    uint32_t m_Revision;
 
-static inline void compare(Grid &g, Point &p, int32_t x, int32_t y, int32_t offsetx, int32_t offsety) {
-    int add;
-    Point other = get(g, x + offsetx, y + offsety);
-    if(offsety == 0) {
-        add = 2 * other.dx + 1;
-    } else if(offsetx == 0) {
-        add = 2 * other.dy + 1;
-    } else {
-        add = 2 * (other.dy + other.dx + 1);
+    bool m_UseKerning;
+};
+/*!
+    \internal
+    Computes the exact squared euclidean distance transform of the 1D function \a f with \a n samples to \a d.
+    Uses lower envelope of parabolas algorithm by Felzenszwalb and Huttenlocher, \a v and \a z are temporary buffers.
+*/
+static void distanceTransform(const float *f, float *d, int32_t *v, float *z, int32_t n) {
+    int32_t k = 0;
+    v[0] = 0;
+    z[0] = -FLT_MAX;
+    z[1] = FLT_MAX;
+    for(int32_t q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while(s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = FLT_MAX;
     }
-    other.f += add;
-    if(other.f < p.f) {
-        p.f = other.f;
-        if(offsety == 0) {
-            p.dx = other.dx + 1;
-            p.dy = other.dy;
-        } else if(offsetx == 0) {
-            p.dy = other.dy + 1;
-            p.dx = other.dx;
-        } else {
-            p.dy = other.dy + 1;
-            p.dx = other.dx + 1;
+
+    k = 0;
+    for(int32_t q = 0; q < n; q++) {
+        while(z[k + 1] < q) {
+            k++;
         }
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
     }
 }
-
-static void generateSDF(Grid &g) {
-    for(int32_t y = 1; y <= g.h; y++) {
-        for(int32_t x = 1; x <= g.w; x++) {
-            Point p = get(g, x, y);
-            compare(g, p, x, y, -1,  0);
-            compare(g, p, x, y,  0, -1);
-            compare(g, p, x, y, -1, -1);
-            compare(g, p, x, y,  1, -1);
-            put(g, x, y, p);
+/*!
+    \internal
+    Transforms the \a grid with \a w x \a h dimensions to the squared distances to the nearest zero sample.
+*/
+static void distanceTransform(vector<float> &grid, int32_t w, int32_t h) {
+    int32_t n = MAX(w, h);
+    vector<float> f(n);
+    vector<float> d(n);
+    vector<float> z(n + 1);
+    vector<int32_t> v(n);
+
+    for(int32_t x = 0; x < w; x++) {
+        for(int32_t y = 0; y < h; y++) {
+            f[y] = grid[y * w + x];
+        }
+        distanceTransform(&f[0], &d[0], &v[0], &z[0], h);
+        for(int32_t y = 0; y < h; y++) {
+            grid[y * w + x] = d[y];
         }
     }
 
-    for(int32_t y = g.h; y > 0; y--) {
-        for(int32_t x = g.w; x > 0; x--) {
-            Point p = get(g, x, y);
-            compare(g, p, x, y,  1,  0);
-            compare(g, p, x, y,  0,  1);
-            compare(g, p, x, y, -1,  1);
-            compare(g, p, x, y,  1,  1);
-            put(g, x, y, p);
-        }
+    for(int32_t y = 0; y < h; y++) {
+        distanceTransform(&grid[y * w], &d[0], &v[0], &z[0], w);
+        memcpy(&grid[y * w], &d[0], sizeof(float) * w);
     }
 }
 
-void calculateDF(int8_t *dst, const FT_Bitmap &src, int32_t dw, int32_t dh) {
+static void calculateDF(int8_t *dst, const FT_Bitmap &src, int32_t dw, int32_t dh) {
     PROFILE_FUNCTION();
 
-    Grid grid[2];
+    const float infinity = 1e20f;
 
     int32_t w = src.width;
     int32_t h = src.rows;
-    grid[0].w = grid[1].w = w;
-    grid[0].h = grid[1].h = h;
-    grid[0].grid = static_cast<Point*>(malloc(sizeof(Point) * (w + 2) * (h + 2)));
-    grid[1].grid = static_cast<Point*>(malloc(sizeof(Point) * (w + 2) * (h + 2)));
-
-    for(int32_t x = 0; x < w + 2; x++) {
-        put(grid[0], x, 0, pointInside);
-        put(grid[1], x, 0, pointEmpty);
-    }
-    for(int32_t y = 1; y <= h; y++) {
-        put(grid[0], 0, y, pointInside);
-        put(grid[1], 0, y, pointEmpty);
-
-        for(int32_t x = 1; x <= w; x++) {
-            uint32_t index = (y - 1) * w + (x - 1);
-
-            if(src.buffer[index] > 128) {
-                put(grid[0], x, y, pointEmpty);
-                put(grid[1], x, y, pointInside);
-            } else {
-                put(grid[0], x, y, pointInside);
-                put(grid[1], x, y, pointEmpty);
+    int32_t gw = w + 2;
+    int32_t gh = h + 2;
+
+    // Distances to the nearest outside pixel and to the nearest inside pixel, the grids have one pixel wide outside border
+    vector<float> outside(gw * gh, 0.0f);
+    vector<float> inside(gw * gh, infinity);
+
+    for(int32_t y = 0; y < h; y++) {
+        for(int32_t x = 0; x < w; x++) {
+            if(src.buffer[y * src.pitch + x] > 128) {
+                uint32_t index = (y + 1) * gw + (x + 1);
+                outside[index] = infinity;
+                inside[index] = 0.0f;
             }
         }
-        put(grid[0], w + 1, y, pointInside);
-        put(grid[1], w + 1, y, pointEmpty);
     }
-    for(int32_t x = 0; x < w + 2; x++) {
-        put(grid[0], x, h + 1, pointInside);
-        put(grid[1], x, h + 1, pointEmpty);
-    }
-    generateSDF(grid[0]);
-    generateSDF(grid[1]);
+    distanceTransform(outside, gw, gh);
+    distanceTransform(inside, gw, gh);
 
     for(int32_t y = 0; y < dh; y++) {
         for(int32_t x = 0; x < dw; x++) {
-            int gx = x * w / (dw - 1);
-            int gy = y * h / (dh - 1);
-            double dist1 = sqrt((double)(get(grid[0], gx, gy).f + 1));
-            double dist2 = sqrt((double)(get(grid[1], gx, gy).f + 1));
-            double dist = dist1 - dist2;
-            uint32_t index = y * dw + x;
-            dst[index] = CLAMP(dist * 64 / 2.0f + 128, 0, 255);
+            int32_t gx = x * w / MAX(dw - 1, 1);
+            int32_t gy = y * h / MAX(dh - 1, 1);
+            uint32_t index = gy * gw + gx;
+            float dist = sqrtf(outside[index] + 1.0f) - sqrtf(inside[index] + 1.0f);
+            dst[y * dw + x] = CLAMP(dist * 64 / 2.0f + 128, 0, 255);
         }
     }
-    free(grid[0].grid);
-    free(grid[1].grid);
 }
+/*!
+    \internal
+    Generates distance field glyphs for the list of characters in a worker thread.
+    The task uses its own FreeType instance and deletes itself when finished.
+*/
+class GlyphTask : public Object {
+public:
+    GlyphTask(const shared_ptr<ByteArray> &data, const shared_ptr<GlyphQueue> &queue, const vector<uint32_t> &characters, int32_t scale) :
+            m_Data(data),
+            m_Queue(queue),
+            m_Characters(characters),
+            m_Scale(scale) {
+
+    }
+
+    void processEvents() override {
+        PROFILE_FUNCTION();
+
+        FT_Library lib = nullptr;
+        if(!m_Queue->m_Cancel && FT_Init_FreeType(&lib) == 0) {
+            FT_Face face = nullptr;
+            if(FT_New_Memory_Face(lib, reinterpret_cast<const uint8_t *>(m_Data->data()), m_Data->size(), 0, &face) == 0) {
+                if(FT_Set_Char_Size(face, m_Scale * 64, 0, 0, 0) == 0) {
+                    for(auto it : m_Characters) {
+                        if(m_Queue->m_Cancel) {
+                            break;
+                        }
+                        GlyphData glyph;
+                        glyph.character = it;
+                        glyph.width = 0;
+                        glyph.height = 0;
+
+                        rasterize(face, glyph);
+
+                        unique_lock<mutex> locker(m_Queue->m_Mutex);
+                        m_Queue->m_Results.push_back(glyph);
+                        m_Queue->m_Ready = true;
+                    }
+                }
+                FT_Done_Face(face);
+            }
+            FT_Done_FreeType(lib);
+        }
+
+        delete this;
+    }
+
+protected:
+    void rasterize(FT_Face face, GlyphData &data) {
+        FT_Error error = FT_Load_Glyph(face, FT_Get_Char_Index(face, data.character), FT_LOAD_DEFAULT);
+        if(!error) {
+            FT_Glyph glyph;
+            error = FT_Get_Glyph(face->glyph, &glyph);
+            if(!error) {
+                FT_Glyph_To_Bitmap(&glyph, ft_render_mode_normal, nullptr, true);
+                FT_Bitmap &bitmap = reinterpret_cast<FT_BitmapGlyph>(glyph)->bitmap;
+
+                int32_t w = bitmap.width / DF_DEFAULT_SCALE;
+                int32_t h = bitmap.rows / DF_DEFAULT_SCALE;
+                if(w && h) {
+                    data.pixels.resize(w * h);
+                    calculateDF(&data.pixels[0], bitmap, w, h);
+
+                    FT_BBox bbox;
+                    FT_Glyph_Get_CBox(glyph, ft_glyph_bbox_pixels, &bbox);
+
+                    data.width = w;
+                    data.height = h;
+                    data.box[0] = bbox.xMin;
+                    data.box[1] = bbox.yMin;
+                    data.box[2] = bbox.xMax;
+                    data.box[3] = bbox.yMax;
+                }
+                FT_Done_Glyph(glyph);
+            }
+        }
+    }
+
+    shared_ptr<ByteArray> m_Data;
+
+    shared_ptr<GlyphQueue> m_Queue;
+
+    vector<uint32_t> m_Characters;
+
+    int32_t m_Scale;
+};
 
 /*!
     \class Font
@@ -176,7 +345,8 @@ void calculateDF(int8_t *dst, const FT_Bitmap &src, int32_t dw, int32_t dh) {
 
     The basic element of a font is a glyph.
     All required glyphs are contained in a special texture - Atlas.
-    If at the moment of accessing the font the glyph is not present in the atlas, the glyph will be loaded there dynamically.
+    If at the moment of accessing the font the glyph is not present in the atlas, the glyph will be generated in a worker thread.
+    The placeholder glyph is used until the generated glyph is committed to the atlas with Font::commitGlyphs().
 */
 
 Font::Font() :
@@ -190,6 +360,7 @@ Font::~Font() {
 }
 /*!
     Returns the index of the \a glyph in the atlas.
+    Returns the index of placeholder glyph if the \a glyph is not generated yet.
 */
 int Font::atlasIndex(int glyph) const {
     PROFILE_FUNCTION();
@@ -198,81 +369,109 @@ int Font::atlasIndex(int glyph) const {
     if(it != p_ptr->m_GlyphMap.end()) {
         return (*it).second;
     }
-    return 0;
+    return PLACEHOLDER_INDEX;
 }
 /*!
     Requests \a characters to be added to the font atlas.
+    The missing glyphs are generated asynchronously; use Font::commitGlyphs() to place them to the atlas.
 */
 void Font::requestCharacters(const string &characters) {
     PROFILE_FUNCTION();
 
+    if(p_ptr->m_pFace == nullptr) {
+        return;
+    }
+
     u32string u32 = Utils::utf8ToUtf32(characters);
 
-    bool isNew = false;
+    vector<uint32_t> missing;
     for(auto it : u32) {
         uint32_t ch = it;
-        if(p_ptr->m_GlyphMap.find(ch) == p_ptr->m_GlyphMap.end() && p_ptr->m_pFace) {
-            FT_Error error = FT_Load_Glyph( p_ptr->m_pFace, FT_Get_Char_Index( p_ptr->m_pFace, it ), FT_LOAD_DEFAULT );
-            if(!error) {
-                FT_Glyph glyph;
-                error = FT_Get_Glyph(p_ptr->m_pFace->glyph, &glyph);
-                if(!error) {
-                    FT_Glyph_To_Bitmap(&glyph, ft_render_mode_normal, nullptr, true);
-                    FT_Bitmap &bitmap = reinterpret_cast<FT_BitmapGlyph>(glyph)->bitmap;
-
-                    uint32_t w = bitmap.width / DF_DEFAULT_SCALE;
-                    uint32_t h = bitmap.rows / DF_DEFAULT_SCALE;
-                    if(w && h) {
-                        Texture::Surface s;
-                        ByteArray buffer;
-                        buffer.resize(w * h);
-                        calculateDF(&buffer[0], bitmap, w, h); /// \todo Must be moved into separate thread
-
-                        s.push_back(buffer);
-
-                        FT_BBox bbox;
-                        FT_Glyph_Get_CBox(glyph, ft_glyph_bbox_pixels, &bbox);
-
-                        Texture *t  = Engine::objectCreate<Texture>("", this);
-                        t->setWidth(w);
-                        t->setHeight(h);
-                        t->addSurface(s);
-
-                        int index = addElement(t);
-                        Mesh *m = mesh(index);
-                        Lod *lod = m->lod(0);
-                        if(lod) {
-                            lod->setVertices({Vector3(bbox.xMin, bbox.yMax, 0.0f) / p_ptr->m_Scale,
-                                              Vector3(bbox.xMax, bbox.yMax, 0.0f) / p_ptr->m_Scale,
-                                              Vector3(bbox.xMax, bbox.yMin, 0.0f) / p_ptr->m_Scale,
-                                              Vector3(bbox.xMin, bbox.yMin, 0.0f) / p_ptr->m_Scale});
-                        }
-                        p_ptr->m_GlyphMap[ch] = index;
+        if(p_ptr->m_Requested.insert(ch).second) {
+            missing.push_back(ch);
+        }
+    }
 
-                        isNew = true;
-                    }
-                }
-            }
+    for(size_t i = 0; i < missing.size(); i += GLYPH_BATCH) {
+        vector<uint32_t> batch(missing.begin() + i, missing.begin() + MIN(i + GLYPH_BATCH, missing.size()));
+
+        GlyphTask *task = new GlyphTask(p_ptr->m_Data, p_ptr->m_Queue, batch, p_ptr->m_Scale);
+        FontPrivate::pool().start(*task);
+    }
+}
+/*!
+    Places all glyphs generated since the last call to the font atlas.
+    Only the changed regions of the atlas texture will be uploaded to GPU.
+    Subscribers will be notified to rebuild the text meshes.
+    Returns true if the atlas was changed; otherwise returns false.
+    \note Must be called from the main thread.
+*/
+bool Font::commitGlyphs() {
+    if(!p_ptr->m_Queue->m_Ready) {
+        return false;
+    }
+
+    PROFILE_FUNCTION();
+
+    list<GlyphData> results;
+    {
+        unique_lock<mutex> locker(p_ptr->m_Queue->m_Mutex);
+        results.swap(p_ptr->m_Queue->m_Results);
+        p_ptr->m_Queue->m_Ready = false;
+    }
+
+    bool isNew = false;
+    for(auto &it : results) {
+        if(it.width && it.height) {
+            float scale = p_ptr->m_Scale;
+            p_ptr->m_GlyphMap[it.character] = p_ptr->addElement(this, it.pixels, it.width, it.height,
+                                                                {Vector3(it.box[0], it.box[3], 0.0f) / scale,
+                                                                 Vector3(it.box[2], it.box[3], 0.0f) / scale,
+                                                                 Vector3(it.box[2], it.box[1], 0.0f) / scale,
+                                                                 Vector3(it.box[0], it.box[1], 0.0f) / scale});
+            isNew = true;
+        } else {
+            p_ptr->m_GlyphMap[it.character] = BLANK_INDEX;
         }
     }
     if(isNew) {
         pack(1);
     }
+    p_ptr->m_Revision = ++s_Revision;
+    notifyCurrentState();
+
+    return true;
 }
 /*!
     Returns the kerning offset between a \a glyph and \a previous glyph.
+    The results are stored in the kerning table of the font, so each pair of glyphs is queried from the font face only once.
     \note In case of font doesn't support kerning this method will return 0.
 */
 int Font::requestKerning(int glyph, int previous) const {
     PROFILE_FUNCTION();
 
     if(p_ptr->m_UseKerning && previous)  {
+        uint64_t pair = (static_cast<uint64_t>(static_cast<uint32_t>(previous)) << 32) | static_cast<uint32_t>(glyph);
+        auto it = p_ptr->m_Kerning.find(pair);
+        if(it != p_ptr->m_Kerning.end()) {
+            return it->second;
+        }
+
         FT_Vector delta;
         FT_Get_Kerning( p_ptr->m_pFace, previous, glyph, FT_KERNING_DEFAULT, &delta );
-        return delta.x >> 6;
+        int32_t result = delta.x >> 6;
+        p_ptr->m_Kerning[pair] = result;
+        return result;
     }
     return 0;
 }
+/*!
+    Returns the revision of the font atlas.
+    The revision is changed each time the font is reloaded or new glyphs are committed to the atlas, so it can be used to validate the cached text meshes.
+*/
+uint32_t Font::revision() const {
+    return p_ptr->m_Revision;
+}
 /*!
     Returns the number of \a characters in the string.
 */
@@ -284,25 +483,13 @@ int Font::length(const string &characters) const {
     Returns visual width of space character for the font in world units.
 */
 float Font::spaceWidth() const {
-    PROFILE_FUNCTION();
-
-    FT_Error error = FT_Load_Glyph( p_ptr->m_pFace, FT_Get_Char_Index( p_ptr->m_pFace, ' ' ), FT_LOAD_DEFAULT );
-    if(!error) {
-        return static_cast<float>(p_ptr->m_pFace->glyph->advance.x) / p_ptr->m_Scale / 64.0f;
-    }
-    return 0;
+    return p_ptr->m_SpaceWidth;
 }
 /*!
     Returns visual height for the font in world units.
 */
 float Font::lineHeight() const {
-    PROFILE_FUNCTION();
-
-    FT_Error error = FT_Load_Glyph( p_ptr->m_pFace, FT_Get_Char_Index( p_ptr->m_pFace, '\n' ), FT_LOAD_DEFAULT );
-    if(!error) {
-        return static_cast<float>(p_ptr->m_pFace->glyph->metrics.height) / p_ptr->m_Scale / 32.0f;
-    }
-    return 0;
+    return p_ptr->m_LineHeight;
 }
 /*!
     \internal
@@ -315,10 +502,11 @@ void Font::loadUserData(const VariantMap &data) {
     {
         auto it = data.find(DATA);
         if(it != data.end()) {
-            p_ptr->m_Data = (*it).second.toByteArray();
-            FT_Error error = FT_New_Memory_Face(library, reinterpret_cast<const uint8_t *>(&p_ptr->m_Data[0]), p_ptr->m_Data.size(), 0, &p_ptr->m_pFace);
+            p_ptr->m_Data = make_shared<ByteArray>((*it).second.toByteArray());
+            FT_Error error = FT_New_Memory_Face(library, reinterpret_cast<const uint8_t *>(p_ptr->m_Data->data()), p_ptr->m_Data->size(), 0, &p_ptr->m_pFace);
             if(error) {
                 Log(Log::ERR) << "Can't load font. System returned error:" << error;
+                p_ptr->m_pFace = nullptr;
                 return;
             }
             error = FT_Set_Char_Size( p_ptr->m_pFace, p_ptr->m_Scale * 64, 0, 0, 0 );
@@ -327,6 +515,18 @@ void Font::loadUserData(const VariantMap &data) {
                 return;
             }
             p_ptr->m_UseKerning = FT_HAS_KERNING( p_ptr->m_pFace );
+
+            error = FT_Load_Glyph( p_ptr->m_pFace, FT_Get_Char_Index( p_ptr->m_pFace, ' ' ), FT_LOAD_DEFAULT );
+            if(!error) {
+                p_ptr->m_SpaceWidth = static_cast<float>(p_ptr->m_pFace->glyph->advance.x) / p_ptr->m_Scale / 64.0f;
+            }
+            error = FT_Load_Glyph( p_ptr->m_pFace, FT_Get_Char_Index( p_ptr->m_pFace, '\n' ), FT_LOAD_DEFAULT );
+            if(!error) {
+                p_ptr->m_LineHeight = static_cast<float>(p_ptr->m_pFace->glyph->metrics.height) / p_ptr->m_Scale / 32.0f;
+            }
+
+            p_ptr->addReserved(this);
+            pack(1);
         }
     }
 }
@@ -342,8 +542,8 @@ VariantMap Font::saveUserData() const {
         header.push_back("");
         result[HEADER]  = header;
     }
-    {
-        result[DATA] = p_ptr->m_Data;
+    if(p_ptr->m_Data) {
+        result[DATA] = *p_ptr->m_Data;
     }
     return result;
 }
@@ -354,6 +554,14 @@ VariantMap Font::saveUserData() const {
 void Font::clear() {
     PROFILE_FUNCTION();
 
+    p_ptr->cancel();
     p_ptr->m_GlyphMap.clear();
-    FT_Done_Face(p_ptr->m_pFace);
+    p_ptr->m_Kerning.clear();
+    p_ptr->m_Revision = ++s_Revision;
+    p_ptr->m_SpaceWidth = 0.0f;
+    p_ptr->m_LineHeight = 0.0f;
+    if(p_ptr->m_pFace) {
+        FT_Done_Face(p_ptr->m_pFace);
+        p_ptr->m_pFace = nullptr;
+    }
 }
@@ -27,6 +27,7 @@
 #include "log.h"
 
 #include "commandbuffer.h"
+#include "componentregistry.h"
 
 #include <algorithm>
 
@@ -48,6 +49,40 @@ bool typeLessThan(PostProcessVolume *left, PostProcessVolume *right) {
     return left->priority() < right->priority();
 }
 
+// Returns true if the left object goes before the right one in the depth-first order of the hierarchy
+bool hierarchyLessThan(const Object *left, const Object *right) {
+    vector<const Object *> l;
+    for(const Object *it = left; it != nullptr; it = it->parent()) {
+        l.push_back(it);
+    }
+    vector<const Object *> r;
+    for(const Object *it = right; it != nullptr; it = it->parent()) {
+        r.push_back(it);
+    }
+
+    auto li = l.rbegin();
+    auto ri = r.rbegin();
+    while(li != l.rend() && ri != r.rend() && *li == *ri) {
+        ++li;
+        ++ri;
+    }
+    if(li == l.rend() || ri == r.rend()) {
+        return li == l.rend() && ri != r.rend();
+    }
+    if(li == l.rbegin()) {
+        return false; // Different roots
+    }
+    for(auto it : (*(li - 1))->getChildren()) {
+        if(it == *li) {
+            return true;
+        }
+        if(it == *ri) {
+            return false;
+        }
+    }
+    return false;
+}
+
 Pipeline::Pipeline() :
         m_Buffer(Engine::objectCreate<CommandBuffer>()),
         m_pSprite(nullptr),
@@ -205,6 +240,9 @@ void Pipeline::setRenderTexture(const string &name, Texture *texture) {
 
 void Pipeline::resize(int32_t width, int32_t height) {
     if(m_Width != width || m_Height != height) {
+        // The render thread can use the buffers of the previous frame
+        RenderSystem::synchronize();
+
         m_Width = width;
         m_Height = height;
 
@@ -350,6 +388,11 @@ RenderTarget *Pipeline::requestShadowTiles(uint32_t id, uint32_t lod, int32_t *x
 CommandBuffer *Pipeline::buffer() const {
     return m_Buffer;
 }
+void Pipeline::setBuffer(CommandBuffer *buffer) {
+    if(buffer) {
+        m_Buffer = buffer;
+    }
+}
 
 void Pipeline::drawComponents(uint32_t layer, list<Renderable *> &list) {
     for(auto it : list) {
@@ -414,32 +457,33 @@ void Pipeline::postProcess(RenderTarget *source, uint32_t layer) {
     m_Buffer->resetViewProjection();
 }
 
-void Pipeline::combineComponents(Object *object, bool update) {
-    for(auto &it : object->getChildren()) {
-        Object *child = it;
-        if(child->isComponent()) {
-            Component *component = static_cast<Component *>(child);
-            if(component->isRenderable()) {
-                Renderable *comp = static_cast<Renderable *>(child);
-                if(comp->isEnabled() && comp->actor()->isEnabledInHierarchy()) {
-                    if(update) {
-                        comp->update();
-                    }
-                    if(comp->isLight()) {
-                        m_SceneLights.push_back(comp);
-                    } else {
-                        if(comp->actor()->layers() & CommandBuffer::UI) {
-                            m_UiComponents.push_back(comp);
-                        } else {
-                            m_SceneComponents.push_back(comp);
-                        }
-                    }
+void Pipeline::combineComponents(Scene *scene, bool update) {
+    ComponentRegistry::Pool &renderables = ComponentRegistry::pool<Renderable>();
+    for(uint32_t i = 0; i < renderables.size(); i++) {
+        if(renderables.scene(i) == scene && renderables.isActive(i)) {
+            Renderable *comp = static_cast<Renderable *>(renderables.at(i));
+            if(update) {
+                comp->update();
+            }
+            if(comp->isLight()) {
+                m_SceneLights.push_back(comp);
+            } else {
+                if(comp->actor()->layers() & CommandBuffer::UI) {
+                    m_UiComponents.push_back(comp);
+                } else {
+                    m_SceneComponents.push_back(comp);
                 }
-            } else if(component->isPostProcessVolume()){
-                m_postProcessVolume.push_back(static_cast<PostProcessVolume *>(component));
             }
-        } else {
-            combineComponents(child, update);
+        }
+    }
+
+    // The pool order changes on each removal, the UI is drawn in the hierarchy order
+    m_UiComponents.sort(hierarchyLessThan);
+
+    ComponentRegistry::Pool &volumes = ComponentRegistry::pool<PostProcessVolume>();
+    for(uint32_t i = 0; i < volumes.size(); i++) {
+        if(volumes.scene(i) == scene) {
+            m_postProcessVolume.push_back(static_cast<PostProcessVolume *>(volumes.at(i)));
         }
     }
 }
@@ -448,7 +492,13 @@ struct ObjectComp {
     bool operator() (const Renderable *left, const Renderable *right) {
         Matrix4 m1 = left->actor()->transform()->worldTransform();
         Matrix4 m2 = right->actor()->transform()->worldTransform();
-        return origin.dot(Vector3(m1[12], m1[13], m1[14])) < origin.dot(Vector3(m2[12], m2[13], m2[14]));
+        float d1 = origin.dot(Vector3(m1[12], m1[13], m1[14]));
+        float d2 = origin.dot(Vector3(m2[12], m2[13], m2[14]));
+        if(d1 == d2) {
+            // The components are collected in the pool order, the hierarchy order resolves the ties
+            return hierarchyLessThan(left, right);
+        }
+        return d1 < d2;
     }
     Vector3 origin;
 };
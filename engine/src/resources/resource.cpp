@@ -1,6 +1,7 @@
 #include "resources/resource.h"
 
 #include <mutex>
+#include <atomic>
 
 class ResourcePrivate {
 public:
@@ -12,7 +13,7 @@ public:
     }
     Resource::ResourceState m_State;
     Resource::ResourceState m_Last;
-    uint32_t m_ReferenceCount;
+    atomic<int32_t> m_ReferenceCount;
     list<Resource::IObserver *> m_Observers;
     mutex m_Mutex;
 };
@@ -114,20 +115,19 @@ void Resource::notifyCurrentState() {
 }
 /*!
     Increases the reference counter for the resource.
+    \note The counter is thread safe, resources can be referenced by the hierarchies loaded in the background.
 */
 void Resource::incRef() {
-    if(p_ptr->m_ReferenceCount <= 0 && p_ptr->m_State == Suspend) {
+    if(p_ptr->m_ReferenceCount++ <= 0 && p_ptr->m_State == Suspend) {
         setState(p_ptr->m_Last);
     }
-    p_ptr->m_ReferenceCount++;
 }
 /*!
     Decreases the reference counter for the resource.
     In case of the reference count becomes zero the resource set to ResourceState::Suspend state.
 */
 void Resource::decRef() {
-    p_ptr->m_ReferenceCount--;
-    if(p_ptr->m_ReferenceCount <= 0 && p_ptr->m_State != Suspend) {
+    if(--p_ptr->m_ReferenceCount <= 0 && p_ptr->m_State != Suspend) {
         p_ptr->m_Last = p_ptr->m_State;
         setState(Suspend);
     }
@@ -21,7 +21,8 @@ class SpritePrivate {
 public:
     SpritePrivate() :
         m_pTexture(nullptr),
-        m_pRoot(new AtlasNode) {
+        m_pRoot(new AtlasNode),
+        m_Packed(0) {
 
     }
     Meshes m_Meshes;
@@ -31,6 +32,8 @@ public:
     Textures m_Sources;
 
     AtlasNode *m_pRoot;
+
+    uint32_t m_Packed;
 };
 
 /*!
@@ -73,6 +76,14 @@ void Sprite::clearAtlas() {
         delete it;
     }
     p_ptr->m_Sources.clear();
+
+    AtlasNode *root = new AtlasNode;
+    root->w = p_ptr->m_pRoot->w;
+    root->h = p_ptr->m_pRoot->h;
+
+    delete p_ptr->m_pRoot;
+    p_ptr->m_pRoot = root;
+    p_ptr->m_Packed = 0;
 }
 /*!
     Adds new sub \a texture as element to current sprite sheet.
@@ -106,22 +117,33 @@ int Sprite::addElement(Texture *texture) {
     Packs all added elements int to a single sprite sheet.
     Parameter \a padding can be used to delimit elements.
 
+    Packing is incremental: only the elements added since the previous call are placed to the sprite sheet and only their regions will be uploaded to GPU.
+    The sprite sheet will be enlarged and repacked from scratch only in case of new elements don't fit into it.
+
     \sa addElement()
 */
 void Sprite::pack(int padding) {
     PROFILE_FUNCTION();
 
-    for(size_t i = 0; i < p_ptr->m_Sources.size(); i++) {
+    bool full = false;
+    while(p_ptr->m_Packed < p_ptr->m_Sources.size()) {
+        uint32_t i = p_ptr->m_Packed;
         Texture *it = p_ptr->m_Sources[i];
-        Mesh *m = mesh(i);
-        Lod *lod = m->lod(0);
 
         int32_t width  = (it->width() + padding * 2);
         int32_t height = (it->height() + padding * 2);
 
         AtlasNode *n = p_ptr->m_pRoot->insert(width, height);
-        if(n && lod) {
-            n->fill = true;
+        if(n == nullptr) {
+            resize(p_ptr->m_pRoot->w * 2, p_ptr->m_pRoot->h * 2);
+            full = true;
+            continue;
+        }
+        n->fill = true;
+
+        Mesh *m = mesh(i);
+        Lod *lod = (m) ? m->lod(0) : nullptr;
+        if(lod) {
             int32_t w = n->w - padding * 2;
             int32_t h = n->h - padding * 2;
 
@@ -141,13 +163,17 @@ void Sprite::pack(int padding) {
                          Vector2(uv.z, uv.y),
                          Vector2(uv.z, uv.w),
                          Vector2(uv.x, uv.w)});
-        } else {
-            resize(p_ptr->m_pRoot->w * 2, p_ptr->m_pRoot->h * 2);
-            pack(padding);
+
+            if(!full) {
+                p_ptr->m_pTexture->setDirtyRegion(n->x, n->y, n->w, n->h);
+            }
         }
+        p_ptr->m_Packed++;
     }
 
-    p_ptr->m_pTexture->setDirty();
+    if(full) {
+        p_ptr->m_pTexture->setDirty();
+    }
 }
 
 /*!
@@ -163,6 +189,7 @@ void Sprite::resize(int32_t width, int32_t height) {
     }
     p_ptr->m_pRoot->w = width;
     p_ptr->m_pRoot->h = height;
+    p_ptr->m_Packed = 0;
 
     p_ptr->m_pTexture->resize(width, height);
 }
@@ -32,6 +32,7 @@ public:
 
     Vector2Vector m_Shape;
     Texture::Sides m_Sides;
+    Texture::Regions m_Regions;
 };
 
 /*!
@@ -65,6 +66,15 @@ public:
     \value Depth \c Depth buffer texture format. Number bits per pixel depend on graphical settings and hardware. Can be 16, 24 or 32-bit per pixel.
 */
 
+/*!
+    \enum Texture::CompressionType
+
+    \value Uncompressed \c Texture data is stored as is.
+    \value DXT1 \c BC1 block compression. 4 bits per pixel, without alpha channel.
+    \value DXT5 \c BC3 block compression. 8 bits per pixel, with alpha channel.
+    \value ETC2 \c ETC2 RGBA8 block compression with EAC alpha channel. 8 bits per pixel. Used on mobile platforms.
+*/
+
 /*!
     \enum Texture::FilteringType
 
@@ -154,6 +164,19 @@ void Texture::addSurface(const Surface &surface) {
     That means this texture must be forcefully reloaded.
 */
 void Texture::setDirty() {
+    p_ptr->m_Regions.clear();
+    switchState(ToBeUpdated);
+}
+/*!
+    Marks a region of the first surface with \a x and \a y position and \a width and \a height dimensions as dirty.
+    Only dirty regions will be uploaded to GPU instead of the whole texture.
+    \note If the full update is already scheduled the region will be ignored.
+*/
+void Texture::setDirtyRegion(int x, int y, int width, int height) {
+    if(state() == ToBeUpdated && p_ptr->m_Regions.empty()) {
+        return;
+    }
+    p_ptr->m_Regions.push_back({x, y, width, height});
     switchState(ToBeUpdated);
 }
 /*!
@@ -193,6 +216,7 @@ int Texture::height() const {
 */
 void Texture::setWidth(int width) {
     p_ptr->m_Width = width;
+    p_ptr->m_Regions.clear();
     switchState(ToBeUpdated);
 }
 /*!
@@ -200,6 +224,7 @@ void Texture::setWidth(int width) {
 */
 void Texture::setHeight(int height) {
     p_ptr->m_Height = height;
+    p_ptr->m_Regions.clear();
     switchState(ToBeUpdated);
 }
 /*!
@@ -235,6 +260,21 @@ int Texture::format() const {
 void Texture::setFormat(int type) {
     p_ptr->m_Format = type;
 }
+/*!
+    Returns the compression method of the texture data.
+    For more details please see the Texture::CompressionType enum.
+*/
+int Texture::compress() const {
+    return p_ptr->m_Compress;
+}
+/*!
+    Sets the compression \a method of the texture data.
+    For more details please see the Texture::CompressionType enum.
+    \note The texture data must be already compressed with the provided \a method.
+*/
+void Texture::setCompress(int method) {
+    p_ptr->m_Compress = method;
+}
 /*!
     Returns filtering type of texture.
     For more details please see the Texture::FilteringType enum.
@@ -285,6 +325,14 @@ void Texture::setDepthBits(int depth) {
 Texture::Sides *Texture::getSides() {
     return &p_ptr->m_Sides;
 }
+/*!
+    \internal
+    Returns the list of regions which must be uploaded to GPU.
+    An empty list means that the whole texture must be uploaded.
+*/
+Texture::Regions &Texture::dirtyRegions() {
+    return p_ptr->m_Regions;
+}
 /*!
     Returns true if texture uses one of the compression formats; otherwise returns false.
 */
@@ -324,6 +372,7 @@ uint8_t Texture::components() const {
 void Texture::clear() {
     p_ptr->m_Sides.clear();
     p_ptr->m_Shape.clear();
+    p_ptr->m_Regions.clear();
 }
 /*!
     \internal
@@ -9,13 +9,37 @@
     \note All methods will be called internaly in the engine.
     \note Systems can process only components which registered in this system.
     \note Systems can be executed one by one or in parallel based on thread policy.
+
+    Each system declares the component types it reads and writes with addRead() and addWrite() in its constructor.
+    The SystemScheduler runs the systems with no conflicting access in parallel and orders the conflicting ones.
+    A declared type covers all of its subclasses, declaring Component claims access to every component.
+    The system without any declarations is considered to access everything and never runs in parallel with others.
 */
 
 /*!
     \enum System::ThreadPolicy
 
     \value Main \c The System::update will be executed one by one in the main thread. This method is handy when you need to execute systems with exact sequence. This policy uses only one CPU core.
-    \value Pool \c The System::update will be executed in the dedicated thread pool. Please note, there is no warranty of a sequence of execution for this case. This policy is preferable because it utilizes CPU cores more efficiently.
+    \value Pool \c The System::update will be executed in the dedicated thread pool. The sequence of execution is defined only by the declared read and write access. This policy is preferable because it utilizes CPU cores more efficiently.
+*/
+
+/*!
+    \enum System::Stage
+
+    \value Simulation \c The system changes the game state.
+    \value Presentation \c The system presents the game state to the user, like the rendering or the audio. The presentation can use the state of the previous frame and go before the simulation, see SystemScheduler::setPipelined().
+*/
+
+/*!
+    \fn template<typename T> void System::addRead()
+
+    Declares that the system reads the components of type T and its subclasses during System::update.
+*/
+
+/*!
+    \fn template<typename T> void System::addWrite()
+
+    Declares that the system modifies the components of type T and its subclasses during System::update.
 */
 
 /*!
@@ -49,6 +73,25 @@ System::System() :
     m_pScene(nullptr) {
 
 }
+/*!
+    Returns the stage of the system. Simulation by default.
+    For more details please refer to System::Stage enum.
+*/
+int System::stage() const {
+    return Simulation;
+}
+/*!
+    Returns the list of component types which the system reads.
+*/
+const System::TypeList &System::reads() const {
+    return m_Reads;
+}
+/*!
+    Returns the list of component types which the system writes.
+*/
+const System::TypeList &System::writes() const {
+    return m_Writes;
+}
 /*!
     This method is a callback to react on saving game settings.
 */
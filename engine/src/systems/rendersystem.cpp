@@ -14,29 +14,234 @@
 #include "components/postprocessvolume.h"
 
 #include "components/camera.h"
+#include "components/transform.h"
 
 #include "resources/pipeline.h"
 #include "resources/material.h"
 
+#include "adapters/platformadaptor.h"
+
 #include "commandbuffer.h"
+#include "framepacket.h"
+
+#include <log.h>
+
+#include <condition_variable>
+#include <thread>
+
+#define RENDER_THREAD "render.thread"
 
 class RenderSystemPrivate {
 public:
-    RenderSystemPrivate() :
-        m_Update(true) {
+    struct Recording {
+        explicit Recording(CommandBuffer *target) :
+                recorder(target),
+                current(0) {
+
+            recorder.setPacket(&packets[current]);
+        }
+
+        FrameRecorder recorder;
+
+        FramePacket packets[2];
 
+        uint32_t current;
+    };
+
+    explicit RenderSystemPrivate(RenderSystem *system) :
+            m_pSystem(system),
+            m_pPacket(nullptr),
+            m_pPipeline(nullptr),
+            m_pTarget(nullptr),
+            m_Update(true),
+            m_Threaded(false),
+            m_Exit(false) {
+
+        s_Instances.push_back(this);
+    }
+
+    ~RenderSystemPrivate() {
+        s_Instances.remove(this);
+
+        stop();
+
+        for(auto it : m_Recordings) {
+            delete it;
+        }
+    }
+    /*!
+        Starts the render thread which takes the ownership of the graphics context.
+        Returns false if the platform can't share the context with the other thread.
+    */
+    bool start() {
+        PlatformAdaptor *adaptor = Engine::platformAdaptor();
+        if(adaptor == nullptr || !adaptor->makeContextCurrent(false)) {
+            return false;
+        }
+
+        m_Exit = false;
+        m_Thread = thread(&RenderSystemPrivate::run, this);
+        return true;
     }
+    /*!
+        Waits for the last packet and stops the render thread.
+    */
+    void stop() {
+        if(m_Thread.joinable()) {
+            {
+                unique_lock<mutex> locker(m_Mutex);
+                m_Exit = true;
+                m_Condition.notify_all();
+            }
+            m_Thread.join();
+        }
+    }
+
+    void setThreaded(bool threaded) {
+        if(m_Threaded == threaded) {
+            return;
+        }
+        if(threaded) {
+            if(!start()) {
+                Log(Log::WRN) << "[ RenderSystem ] The platform doesn't support the render thread";
+                return;
+            }
+        } else {
+            stop();
+
+            PlatformAdaptor *adaptor = Engine::platformAdaptor();
+            if(adaptor) {
+                adaptor->makeContextCurrent(true);
+            }
+        }
+        m_Threaded = threaded;
+    }
+    /*!
+        Returns the recording which records the commands of the \a pipeline.
+        Replaces the pipeline buffer with the recorder in the threaded mode and restores the original one otherwise.
+    */
+    Recording *recording(Pipeline *pipeline) {
+        FrameRecorder *recorder = dynamic_cast<FrameRecorder *>(pipeline->buffer());
+        if(recorder) {
+            for(auto it : m_Recordings) {
+                if(&it->recorder == recorder) {
+                    if(m_Threaded) {
+                        return it;
+                    }
+                    // The commands recorded out of the frame must be executed in the inline mode
+                    it->packets[it->current].replay(*recorder->target());
+                    it->packets[it->current].clear();
+
+                    pipeline->setBuffer(recorder->target());
+                    return nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        if(m_Threaded) {
+            Recording *result = new Recording(pipeline->buffer());
+            m_Recordings.push_back(result);
+
+            pipeline->setBuffer(&result->recorder);
+            return result;
+        }
+        return nullptr;
+    }
+    /*!
+        Sends the recorded frame of the \a pipeline to the render thread.
+        The other packet of the \a recording collects the commands of the next frame.
+    */
+    void submit(Recording *recording, Pipeline *pipeline) {
+        unique_lock<mutex> locker(m_Mutex);
+        m_pPacket = &recording->packets[recording->current];
+        m_pPipeline = pipeline;
+        m_pTarget = recording->recorder.target();
+
+        recording->current ^= 1;
+        recording->packets[recording->current].clear();
+        recording->recorder.setPacket(&recording->packets[recording->current]);
+
+        m_Condition.notify_all();
+    }
+    /*!
+        Waits for the render thread to draw the submitted packet.
+    */
+    void wait() {
+        if(m_Thread.joinable()) {
+            unique_lock<mutex> locker(m_Mutex);
+            m_Condition.wait(locker, [this]() { return m_pPacket == nullptr; });
+        }
+    }
+    /*!
+        The render thread routine.
+    */
+    void run() {
+        PlatformAdaptor *adaptor = Engine::platformAdaptor();
+        adaptor->makeContextCurrent(true);
+
+        unique_lock<mutex> locker(m_Mutex);
+        while(true) {
+            m_Condition.wait(locker, [this]() { return m_pPacket != nullptr || m_Exit; });
+            if(m_pPacket == nullptr) {
+                break;
+            }
+            locker.unlock();
+
+            m_pSystem->beginFrame(m_pPipeline);
+            m_pPacket->replay(*m_pTarget);
+            m_pSystem->endFrame(m_pPipeline);
+
+            adaptor->swapBuffers();
+
+            locker.lock();
+            m_pPacket = nullptr;
+            m_Condition.notify_all();
+        }
+        locker.unlock();
+
+        adaptor->makeContextCurrent(false);
+    }
+
     static int32_t m_AtlasPageWidth;
     static int32_t m_AtlasPageHeight;
 
+    static list<RenderSystemPrivate *> s_Instances;
+
+    static uint32_t s_Frame;
+
+    RenderSystem *m_pSystem;
+
+    list<Recording *> m_Recordings;
+
+    thread m_Thread;
+
+    mutex m_Mutex;
+
+    condition_variable m_Condition;
+
+    FramePacket *m_pPacket;
+
+    Pipeline *m_pPipeline;
+
+    CommandBuffer *m_pTarget;
+
     bool m_Update;
+
+    bool m_Threaded;
+
+    bool m_Exit;
 };
 
 int32_t RenderSystemPrivate::m_AtlasPageWidth = 1024;
 int32_t RenderSystemPrivate::m_AtlasPageHeight = 1024;
 
+list<RenderSystemPrivate *> RenderSystemPrivate::s_Instances;
+
+uint32_t RenderSystemPrivate::s_Frame = 0;
+
 RenderSystem::RenderSystem() :
-        p_ptr(new RenderSystemPrivate()) {
+        p_ptr(new RenderSystemPrivate(this)) {
 
     Renderable::registerClassFactory(this);
     MeshRender::registerClassFactory(this);
@@ -55,6 +260,11 @@ RenderSystem::RenderSystem() :
     CommandBuffer::registerClassFactory(this);
 
     PostProcessVolume::registerClassFactory(this);
+
+    // Renderables update their bounds and the dynamic geometry during the drawing
+    addRead<Component>();
+    addRead<Resource>();
+    addWrite<Renderable>();
 }
 
 RenderSystem::~RenderSystem() {
@@ -75,12 +285,18 @@ RenderSystem::~RenderSystem() {
     CommandBuffer::unregisterClassFactory(this);
 
     PostProcessVolume::unregisterClassFactory(this);
+
+    delete p_ptr;
 }
 
 int RenderSystem::threadPolicy() const {
     return Main;
 }
 
+int RenderSystem::stage() const {
+    return Presentation;
+}
+
 const char *RenderSystem::name() const {
     return "Render";
 }
@@ -92,16 +308,89 @@ bool RenderSystem::init() {
 void RenderSystem::update(Scene *scene) {
     PROFILE_FUNCTION();
 
+    // The renderables can update the dynamic geometry during the recording
+    p_ptr->wait();
+
     PROFILER_RESET(POLYGONS);
     PROFILER_RESET(DRAWCALLS);
 
     Camera *camera = Camera::current();
     if(camera) {
         Pipeline *pipe = camera->pipeline();
+
+        RenderSystemPrivate::Recording *recording = p_ptr->recording(pipe);
+        if(recording == nullptr) {
+            beginFrame(pipe);
+        }
+
         pipe->analizeScene(scene, this);
         pipe->draw(*camera);
         pipe->finish();
+
+        if(recording) {
+            p_ptr->submit(recording, pipe);
+        } else {
+            endFrame(pipe);
+        }
     }
+
+    RenderSystemPrivate::s_Frame++;
+}
+/*!
+    Returns true if the frames are drawn on the render thread.
+*/
+bool RenderSystem::isThreaded() const {
+    return p_ptr->m_Threaded;
+}
+/*!
+    Enables the \a threaded rendering.
+    In this mode the main thread records the frame to the FramePacket and the dedicated render thread draws it while
+    the main thread simulates the next frame. The render thread owns the graphics context and presents the frames.
+    The mode stays disabled if the platform adaptor can't transfer the context to the other thread.
+    Can be enabled with the "render.thread" setting. Disabled by default.
+    The engine components which update the resources each frame (the armature palette, the text and sprite meshes)
+    write the copy which is not used by the last recorded frame, see frameIndex().
+    \note The other resources must not be changed in place while the render thread draws the frame, see synchronize().
+*/
+void RenderSystem::setThreaded(bool threaded) {
+    p_ptr->setThreaded(threaded);
+}
+/*!
+    Waits for the render threads of all render systems to draw the submitted frames.
+    Must be called before changing or deleting the resources which can be used by the last frame.
+*/
+void RenderSystem::synchronize() {
+    PROFILE_FUNCTION();
+    for(auto it : RenderSystemPrivate::s_Instances) {
+        it->wait();
+    }
+}
+/*!
+    Returns the number of frames recorded by the render systems.
+    The resources which are updated each frame can be double buffered by this index instead of synchronize().
+*/
+uint32_t RenderSystem::frameIndex() {
+    return RenderSystemPrivate::s_Frame;
+}
+/*!
+    \internal
+*/
+void RenderSystem::syncSettings() const {
+    p_ptr->setThreaded(Engine::value(RENDER_THREAD, false).toBool());
+}
+/*!
+    Prepares the backend to draw the frame of the \a pipeline.
+    Called on the thread which owns the graphics context.
+*/
+void RenderSystem::beginFrame(Pipeline *pipeline) {
+    A_UNUSED(pipeline);
+}
+/*!
+    Finishes the frame of the \a pipeline.
+    Called on the thread which owns the graphics context.
+*/
+void RenderSystem::endFrame(Pipeline *pipeline) {
+    A_UNUSED(pipeline);
 }
 
 void RenderSystem::atlasPageSize(int32_t &width, int32_t &height) {
@@ -6,8 +6,12 @@
 
 #include "engine.h"
 
+#include "systems/rendersystem.h"
+
 #include "resources/resource.h"
 
+#include <mutex>
+
 class ResourceSystemPrivate {
 public:
     ResourceSystem::DictionaryMap  m_IndexMap;
@@ -15,11 +19,16 @@ public:
     unordered_map<Resource*, string> m_ReferenceCache;
 
     list<Resource *> m_DeleteList;
+
+    // Resources can be requested by the scene chunks loading in the background
+    recursive_mutex m_Mutex;
 };
 
 ResourceSystem::ResourceSystem() :
     p_ptr(new ResourceSystemPrivate) {
 
+    addWrite<Resource>();
+
 }
 
 ResourceSystem::~ResourceSystem() {
@@ -36,6 +45,19 @@ const char *ResourceSystem::name() const {
 
 void ResourceSystem::update(Scene *) {
     PROFILE_FUNCTION();
+    unique_lock<recursive_mutex> locker(p_ptr->m_Mutex);
+
+    // The render thread can still use the resources which are going to be changed
+    for(auto &it : p_ptr->m_ResourceCache) {
+        if(it.second == nullptr) {
+            continue;
+        }
+        Resource::ResourceState state = it.second->state();
+        if(state == Resource::Loading || state == Resource::Suspend || state == Resource::ToBeDeleted) {
+            RenderSystem::synchronize();
+            break;
+        }
+    }
 
     for(auto it = p_ptr->m_ResourceCache.begin(); it != p_ptr->m_ResourceCache.end();) {
         processState(it->second);
@@ -50,11 +72,12 @@ void ResourceSystem::update(Scene *) {
 }
 
 int ResourceSystem::threadPolicy() const {
-    return Pool;
+    return Main;
 }
 
 void ResourceSystem::setResource(Resource *object, const string &uuid) {
     PROFILE_FUNCTION();
+    unique_lock<recursive_mutex> locker(p_ptr->m_Mutex);
 
     p_ptr->m_ResourceCache[uuid] = object;
     p_ptr->m_ReferenceCache[object] = uuid;
@@ -85,19 +108,32 @@ Resource *ResourceSystem::loadResource(const string &path) {
             file->fread(&data[0], data.size(), 1, fp);
             file->fclose(fp);
 
-            Variant var = Bson::load(data);
-            if(!var.isValid()) {
-                var = Json::load(string(data.begin(), data.end()));
+            Object *res = nullptr;
+            if(Engine::isBinary(data)) {
+                res = Engine::binaryToObject(data);
+            } else {
+                Variant var = Bson::load(data);
+                if(!var.isValid()) {
+                    var = Json::load(string(data.begin(), data.end()));
+                }
+                if(var.isValid()) {
+                    res = Engine::toObject(var);
+                }
             }
-            if(var.isValid()) {
-                Object *res = Engine::toObject(var);
-                if(res) {
-                    Resource *resource = static_cast<Resource *>(res);
-                    if(resource) {
-                        setResource(resource, uuid);
-                        resource->switchState(Resource::ToBeUpdated);
-                        return resource;
+            if(res) {
+                Resource *resource = static_cast<Resource *>(res);
+                if(resource) {
+                    unique_lock<recursive_mutex> locker(p_ptr->m_Mutex);
+                    // The same resource could be loaded by another thread meanwhile
+                    string origin = uuid;
+                    object = ResourceSystem::resource(origin);
+                    if(object) {
+                        delete resource;
+                        return object;
                     }
+                    setResource(resource, uuid);
+                    resource->switchState(Resource::ToBeUpdated);
+                    return resource;
                 }
             }
         }
@@ -130,6 +166,7 @@ void ResourceSystem::reloadResource(Resource *resource, bool force) {
 
 string ResourceSystem::reference(Resource *resource) {
     PROFILE_FUNCTION();
+    unique_lock<recursive_mutex> locker(p_ptr->m_Mutex);
     auto it = p_ptr->m_ReferenceCache.find(resource);
     if(it != p_ptr->m_ReferenceCache.end()) {
         return it->second;
@@ -143,6 +180,7 @@ ResourceSystem::DictionaryMap &ResourceSystem::indices() const {
 
 void ResourceSystem::deleteFromCahe(Resource *resource) {
     PROFILE_FUNCTION();
+    unique_lock<recursive_mutex> locker(p_ptr->m_Mutex);
     auto ref = p_ptr->m_ReferenceCache.find(resource);
     if(ref != p_ptr->m_ReferenceCache.end()) {
         auto res = p_ptr->m_ResourceCache.find(ref->second);
@@ -176,9 +214,14 @@ void ResourceSystem::processState(Resource *resource) {
                         file->fread(&data[0], data.size(), 1, fp);
                         file->fclose(fp);
 
-                        Variant var = Bson::load(data);
-                        if(!var.isValid()) {
-                            var = Json::load(string(data.begin(), data.end()));
+                        Variant var;
+                        if(Engine::isBinary(data)) {
+                            var = Engine::fromBinary(data);
+                        } else {
+                            var = Bson::load(data);
+                            if(!var.isValid()) {
+                                var = Json::load(string(data.begin(), data.end()));
+                            }
                         }
 
                         List deleteObjects;
@@ -242,6 +285,7 @@ void ResourceSystem::processState(Resource *resource) {
 }
 
 Resource *ResourceSystem::resource(string &path) const {
+    unique_lock<recursive_mutex> locker(p_ptr->m_Mutex);
     {
         auto it = p_ptr->m_IndexMap.find(path);
         if(it != p_ptr->m_IndexMap.end()) {
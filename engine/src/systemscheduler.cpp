@@ -0,0 +1,379 @@
+#include "systemscheduler.h"
+
+#include "system.h"
+
+#include <threadpool.h>
+#include <log.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <set>
+
+class SystemSchedulerPrivate {
+public:
+    class Node : public Object {
+    public:
+        Node(SystemSchedulerPrivate *scheduler, System *system, uint32_t index) :
+                m_pScheduler(scheduler),
+                m_pSystem(system),
+                m_Index(index),
+                m_Predecessors(0),
+                m_Remaining(0),
+                m_Pool(system->threadPolicy() == System::Pool) {
+
+        }
+        /*!
+            Executes the system on the pool thread.
+        */
+        void processEvents() override {
+            m_pScheduler->run(m_Index);
+        }
+
+        SystemSchedulerPrivate *m_pScheduler;
+
+        System *m_pSystem;
+
+        uint32_t m_Index;
+
+        vector<uint32_t> m_Successors;
+
+        uint32_t m_Predecessors;
+
+        atomic<uint32_t> m_Remaining;
+
+        bool m_Pool;
+    };
+
+    SystemSchedulerPrivate() :
+            m_Done(0),
+            m_Pipelined(false),
+            m_Dirty(false) {
+
+    }
+
+    ~SystemSchedulerPrivate() {
+        clear();
+    }
+
+    void clear() {
+        for(auto it : m_Nodes) {
+            delete it;
+        }
+        m_Nodes.clear();
+    }
+
+    static bool overlaps(const System::TypeList &left, const System::TypeList &right) {
+        for(auto l : left) {
+            for(auto r : right) {
+                if(l->canCastTo(r->name()) || r->canCastTo(l->name())) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    static bool isDeclared(const System *system) {
+        return !system->reads().empty() || !system->writes().empty();
+    }
+    /*!
+        Returns true if the \a left and \a right systems can't be executed at the same time.
+    */
+    static bool conflicts(const System *left, const System *right) {
+        if(!isDeclared(left) || !isDeclared(right)) {
+            return true;
+        }
+        return overlaps(left->writes(), right->reads()) ||
+               overlaps(left->writes(), right->writes()) ||
+               overlaps(right->writes(), left->reads());
+    }
+    /*!
+        Returns true if the \a consumer system reads the results of the \a producer system and not vice versa.
+    */
+    static bool feeds(const System *producer, const System *consumer) {
+        if(!isDeclared(producer) || !isDeclared(consumer)) {
+            return false;
+        }
+        return overlaps(producer->writes(), consumer->reads()) && !overlaps(consumer->writes(), producer->reads());
+    }
+    /*!
+        Returns true if the \a first system must go before the \a second conflicting system in the pipelined mode.
+        The presentation reads the state of the previous frame before the simulation changes it.
+    */
+    bool presentsFirst(const System *first, const System *second) const {
+        return m_Pipelined && first->stage() == System::Presentation && second->stage() != System::Presentation;
+    }
+    /*!
+        Builds the dependency graph of the registered systems.
+        The conflicting systems are ordered producers first, otherwise in the registration order.
+        In the pipelined mode the presentation systems go before the conflicting simulation systems.
+    */
+    void build() {
+        PROFILE_FUNCTION();
+        clear();
+
+        vector<System *> systems(m_Systems.begin(), m_Systems.end());
+        uint32_t count = systems.size();
+
+        vector<vector<uint32_t>> after(count);
+        vector<uint32_t> incoming(count, 0);
+        for(uint32_t i = 0; i < count; i++) {
+            for(uint32_t j = i + 1; j < count; j++) {
+                if(conflicts(systems[i], systems[j])) {
+                    bool swap = feeds(systems[j], systems[i]);
+                    if(presentsFirst(systems[i], systems[j])) {
+                        swap = false;
+                    } else if(presentsFirst(systems[j], systems[i])) {
+                        swap = true;
+                    }
+                    if(swap) {
+                        after[j].push_back(i);
+                        incoming[i]++;
+                    } else {
+                        after[i].push_back(j);
+                        incoming[j]++;
+                    }
+                }
+            }
+        }
+
+        vector<uint32_t> order;
+        vector<bool> placed(count, false);
+        set<uint32_t> ready;
+        for(uint32_t i = 0; i < count; i++) {
+            if(incoming[i] == 0) {
+                ready.insert(i);
+            }
+        }
+        while(order.size() < count) {
+            if(ready.empty()) {
+                // The declarations form a cycle, the first remaining system in the registration order breaks it
+                uint32_t i = 0;
+                while(placed[i]) {
+                    i++;
+                }
+                Log(Log::WRN) << "Cyclic dependency of the systems, breaking at:" << systems[i]->name();
+                incoming[i] = 0;
+                ready.insert(i);
+            }
+            uint32_t i = *ready.begin();
+            ready.erase(ready.begin());
+
+            placed[i] = true;
+            order.push_back(i);
+            for(auto it : after[i]) {
+                if(!placed[it] && incoming[it] > 0 && --incoming[it] == 0) {
+                    ready.insert(it);
+                }
+            }
+        }
+
+        for(uint32_t i = 0; i < count; i++) {
+            m_Nodes.push_back(new Node(this, systems[order[i]], i));
+        }
+        for(uint32_t i = 0; i < count; i++) {
+            System *first = m_Nodes[i]->m_pSystem;
+            for(uint32_t j = i + 1; j < count; j++) {
+                System *second = m_Nodes[j]->m_pSystem;
+                if(conflicts(first, second)) {
+                    m_Nodes[i]->m_Successors.push_back(j);
+                    m_Nodes[j]->m_Predecessors++;
+                }
+            }
+        }
+
+        m_Dirty = false;
+    }
+    /*!
+        Sends the node with \a index to execution when all of its dependencies are done.
+    */
+    void schedule(uint32_t index) {
+        Node *node = m_Nodes[index];
+        if(node->m_Pool) {
+            m_ThreadPool.start(*node);
+        } else {
+            unique_lock<mutex> locker(m_Mutex);
+            m_Main.insert(index);
+            m_Condition.notify_all();
+        }
+    }
+    /*!
+        Executes the system of the node with \a index and releases the dependent nodes.
+    */
+    void run(uint32_t index) {
+        Node *node = m_Nodes[index];
+        node->m_pSystem->processEvents();
+
+        for(auto it : node->m_Successors) {
+            if(--m_Nodes[it]->m_Remaining == 0) {
+                schedule(it);
+            }
+        }
+
+        unique_lock<mutex> locker(m_Mutex);
+        m_Done++;
+        m_Condition.notify_all();
+    }
+
+    list<System *> m_Systems;
+
+    vector<Node *> m_Nodes;
+
+    set<uint32_t> m_Main;
+
+    mutex m_Mutex;
+
+    condition_variable m_Condition;
+
+    uint32_t m_Done;
+
+    bool m_Pipelined;
+
+    bool m_Dirty;
+
+    ThreadPool m_ThreadPool;
+};
+
+/*!
+    \class SystemScheduler
+    \brief Executes the game systems each frame according to their declared dependencies.
+    \inmodule Engine
+
+    The scheduler builds a dependency graph over the systems from the component types which they read and write,
+    see System::addRead() and System::addWrite().
+    The systems with no conflicting access run in parallel, the conflicting ones are ordered: the system which writes
+    the components goes before the systems which only read them, otherwise the registration order is used.
+    The systems with the System::Pool thread policy are executed in the thread pool as soon as their dependencies
+    are done, the System::Main ones are executed in the thread which calls execute().
+
+    The Engine owns a scheduler for its systems, see Engine::scheduler().
+*/
+SystemScheduler::SystemScheduler() :
+        p_ptr(new SystemSchedulerPrivate) {
+
+}
+
+SystemScheduler::~SystemScheduler() {
+    p_ptr->m_ThreadPool.waitForDone();
+
+    delete p_ptr;
+}
+/*!
+    Adds the \a system to the scheduler. The order of registration resolves the conflicts with no clear producer.
+    \note The scheduler doesn't take ownership of the \a system.
+*/
+void SystemScheduler::addSystem(System *system) {
+    PROFILE_FUNCTION();
+    if(system) {
+        p_ptr->m_Systems.push_back(system);
+        p_ptr->m_Dirty = true;
+    }
+}
+/*!
+    Returns the list of registered systems in the registration order.
+*/
+const list<System *> &SystemScheduler::systems() const {
+    return p_ptr->m_Systems;
+}
+/*!
+    Returns true if the \a system waits for the \a dependency to be done within the frame.
+*/
+bool SystemScheduler::dependsOn(System *system, System *dependency) const {
+    if(p_ptr->m_Dirty) {
+        p_ptr->build();
+    }
+
+    int32_t target = -1;
+    for(auto it : p_ptr->m_Nodes) {
+        if(it->m_pSystem == dependency) {
+            target = it->m_Index;
+        }
+    }
+    if(target < 0) {
+        return false;
+    }
+
+    list<uint32_t> queue = {static_cast<uint32_t>(target)};
+    while(!queue.empty()) {
+        SystemSchedulerPrivate::Node *node = p_ptr->m_Nodes[queue.front()];
+        queue.pop_front();
+        for(auto it : node->m_Successors) {
+            if(p_ptr->m_Nodes[it]->m_pSystem == system) {
+                return true;
+            }
+            queue.push_back(it);
+        }
+    }
+    return false;
+}
+/*!
+    Returns true if the presentation systems don't wait for the simulation systems.
+*/
+bool SystemScheduler::isPipelined() const {
+    return p_ptr->m_Pipelined;
+}
+/*!
+    Enables the \a pipelined execution.
+    The System::Presentation systems go before the conflicting System::Simulation ones, so they present the state
+    simulated by the previous frame and the simulation systems which write this state wait for them. The simulation
+    systems with no conflicting access run at the same time with the presentation. Together with the render thread
+    (see RenderSystem::setThreaded()) the drawing of the frame overlaps the simulation of the next one. This reduces
+    the frame time in exchange for one frame of latency.
+    Disabled by default.
+*/
+void SystemScheduler::setPipelined(bool pipelined) {
+    if(p_ptr->m_Pipelined != pipelined) {
+        p_ptr->m_Pipelined = pipelined;
+        p_ptr->m_Dirty = true;
+    }
+}
+/*!
+    Returns the max number of pool threads used to execute the systems.
+*/
+uint32_t SystemScheduler::maxThreads() const {
+    return p_ptr->m_ThreadPool.maxThreads();
+}
+/*!
+    Sets the max number of pool threads used to execute the systems to \a value.
+*/
+void SystemScheduler::setMaxThreads(uint32_t value) {
+    p_ptr->m_ThreadPool.setMaxThreads(value);
+}
+/*!
+    Executes all systems for the \a scene once and waits for them to be done.
+    \note Usually, this method calls internally and must not be called manually.
+*/
+void SystemScheduler::execute(Scene *scene) {
+    PROFILE_FUNCTION();
+    if(p_ptr->m_Dirty) {
+        p_ptr->build();
+    }
+
+    p_ptr->m_Done = 0;
+    for(auto it : p_ptr->m_Nodes) {
+        it->m_pSystem->setActiveScene(scene);
+        it->m_Remaining = it->m_Predecessors;
+    }
+    for(auto it : p_ptr->m_Nodes) {
+        if(it->m_Predecessors == 0) {
+            p_ptr->schedule(it->m_Index);
+        }
+    }
+
+    unique_lock<mutex> locker(p_ptr->m_Mutex);
+    while(true) {
+        p_ptr->m_Condition.wait(locker, [&]() { return !p_ptr->m_Main.empty() || p_ptr->m_Done == p_ptr->m_Nodes.size(); });
+        if(p_ptr->m_Main.empty()) {
+            break;
+        }
+        uint32_t index = *p_ptr->m_Main.begin();
+        p_ptr->m_Main.erase(p_ptr->m_Main.begin());
+
+        locker.unlock();
+        p_ptr->run(index);
+        locker.lock();
+    }
+    locker.unlock();
+
+    p_ptr->m_ThreadPool.waitForDone();
+}
@@ -0,0 +1,89 @@
+#include "tst_common.h"
+
+#include "resources/animationclip.h"
+
+#include <cfloat>
+
+AnimationTrack testTrack(const string &property, int32_t components, AnimationCurve::KeyFrame::Type type, float tangent) {
+    AnimationTrack track;
+    track.setPath("Bone");
+    track.setProperty(property);
+    track.setDuration(1000);
+
+    for(int32_t c = 0; c < components; c++) {
+        AnimationCurve curve;
+        for(int32_t k = 0; k < 3; k++) {
+            AnimationCurve::KeyFrame key;
+            key.m_Position = k * 0.5f;
+            key.m_Type = type;
+            key.m_Value = (k == 1) ? 1.0f + c : 0.0f;
+            key.m_LeftTangent = key.m_Value + tangent;
+            key.m_RightTangent = key.m_Value + tangent;
+            curve.m_Keys.push_back(key);
+        }
+        track.curves()[c] = curve;
+    }
+    return track;
+}
+
+float compressionError(AnimationClip &clip, AnimationClip &reference) {
+    float result = 0.0f;
+    for(auto &it : reference.compiledTracks()) {
+        const AnimationClip::CompiledTrack *compressed = clip.compiledTrack(it.hash);
+        if(compressed == nullptr) {
+            return FLT_MAX;
+        }
+        for(int32_t f = 0; f <= 100; f++) {
+            float position = static_cast<float>(f) / 100.0f;
+            float expected[4] = {0.0f};
+            float value[4] = {0.0f};
+            reference.sample(it, position, expected);
+            clip.sample(*compressed, position, value);
+            for(int32_t c = 0; c < it.components; c++) {
+                result = MAX(result, fabsf(expected[c] - value[c]));
+            }
+        }
+    }
+    return result;
+}
+
+class AnimationClipTest : public QObject {
+    Q_OBJECT
+private slots:
+
+void Animation_clip_compression() {
+    Engine system(nullptr, "");
+
+    AnimationClip reference;
+    reference.m_Tracks.push_back(testTrack("position", 3, AnimationCurve::KeyFrame::Linear, 0.0f));
+    reference.m_Tracks.push_back(testTrack("scale", 3, AnimationCurve::KeyFrame::Cubic, 0.5f));
+    reference.m_Tracks.push_back(testTrack("color", 4, AnimationCurve::KeyFrame::Cubic, 0.5f));
+    reference.compile();
+
+    AnimationClip clip;
+    clip.m_Tracks = reference.m_Tracks;
+    clip.compress();
+
+    QCOMPARE(clip.isCompressed(), true);
+    QCOMPARE((int)clip.compiledTracks().size(), 3);
+    QCOMPARE(clip.compiledTracks()[0].format, (int32_t)AnimationClip::Quantized);
+    QCOMPARE(clip.compiledTracks()[0].frames, 3);
+    QCOMPARE(clip.compiledTracks()[1].format, (int32_t)AnimationClip::Quantized);
+    QCOMPARE(clip.compiledTracks()[2].format, (int32_t)AnimationClip::Sampled);
+
+    auto color = clip.m_Tracks.rbegin();
+    QCOMPARE(color->curves().empty(), false);
+
+    QVERIFY(compressionError(clip, reference) < 0.005f);
+
+    AnimationClip loaded;
+    loaded.loadUserData(clip.saveUserData());
+
+    QCOMPARE(loaded.isCompressed(), true);
+    QCOMPARE((int)loaded.compiledTracks().size(), 3);
+    QVERIFY(compressionError(loaded, reference) < 0.005f);
+}
+
+} REGISTER(AnimationClipTest)
+
+#include "tst_animationclip.moc"
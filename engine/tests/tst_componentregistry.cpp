@@ -0,0 +1,105 @@
+#include "tst_common.h"
+
+#include "components/actor.h"
+#include "components/chunk.h"
+#include "components/component.h"
+#include "components/scene.h"
+
+#include "componentregistry.h"
+
+class RegistryComponent : public Component {
+public:
+    A_REGISTER(RegistryComponent, Component, Components);
+
+    A_NOPROPERTIES()
+    A_NOMETHODS()
+
+};
+
+class ComponentRegistryTest : public QObject {
+    Q_OBJECT
+private slots:
+
+void Component_registry() {
+    Engine system(nullptr, "");
+    RegistryComponent::registerClassFactory(&system);
+
+    ComponentRegistry::Pool &pool = ComponentRegistry::pool<RegistryComponent>();
+    QCOMPARE(pool.size(), 0U);
+
+    Scene *scene = Engine::objectCreate<Scene>("Scene");
+    Actor *actor = Engine::composeActor("RegistryComponent", "Actor", scene);
+    RegistryComponent *component = dynamic_cast<RegistryComponent *>(actor->component("RegistryComponent"));
+    QCOMPARE(component != nullptr, true);
+
+    QCOMPARE(pool.size(), 1U);
+    QCOMPARE(pool.at(0) == component, true);
+    QCOMPARE(pool.scene(0) == scene, true);
+    QCOMPARE(pool.system(0) == &system, true);
+    QCOMPARE(pool.isActive(0), true);
+
+    component->setEnabled(false);
+    QCOMPARE(pool.isEnabled(0), false);
+    component->setEnabled(true);
+
+    actor->setEnabled(false);
+    QCOMPARE(pool.isVisible(0), false);
+    actor->setEnabled(true);
+    QCOMPARE(pool.isVisible(0), true);
+
+    Actor *root = Engine::objectCreate<Actor>("Root");
+    actor->setParent(root);
+    QCOMPARE(pool.scene(0) == nullptr, true);
+    root->setParent(scene);
+    QCOMPARE(pool.scene(0) == scene, true);
+
+    delete component;
+    QCOMPARE(pool.size(), 0U);
+
+    delete root;
+    delete scene;
+}
+
+void Component_registry_deferred() {
+    Engine system(nullptr, "");
+    RegistryComponent::registerClassFactory(&system);
+
+    ComponentRegistry::Pool &pool = ComponentRegistry::pool<RegistryComponent>();
+    Scene *scene = Engine::objectCreate<Scene>("Scene");
+    Chunk *chunk = Engine::objectCreate<Chunk>("Chunk");
+
+    // The hierarchy built in the background stays out of the pools until commit
+    ComponentRegistry::Deferred deferred;
+    deferred.begin();
+    Actor *first = Engine::composeActor("RegistryComponent", "First", chunk);
+    Actor *second = Engine::composeActor("RegistryComponent", "Second", chunk);
+    delete second;
+    deferred.end();
+
+    // RegistryComponent and Transform of the first actor
+    QCOMPARE(pool.size(), 0U);
+    QCOMPARE(deferred.size(), 2U);
+
+    QCOMPARE(deferred.commit(1), false);
+    QCOMPARE(deferred.commit(1), true);
+    QCOMPARE(pool.size(), 1U);
+    QCOMPARE(pool.at(0) == first->component("RegistryComponent"), true);
+    QCOMPARE(pool.scene(0) == nullptr, true);
+
+    // Attaching the chunk updates the scene of the contained components
+    chunk->setParent(scene);
+    QCOMPARE(pool.scene(0) == scene, true);
+    QCOMPARE(first->scene() == scene, true);
+
+    chunk->setParent(nullptr);
+    QCOMPARE(pool.scene(0) == nullptr, true);
+
+    delete chunk;
+    QCOMPARE(pool.size(), 0U);
+
+    delete scene;
+}
+
+} REGISTER(ComponentRegistryTest)
+
+#include "tst_componentregistry.moc"
@@ -0,0 +1,77 @@
+#include "tst_common.h"
+
+#include "resources/mesh.h"
+#include "resources/material.h"
+
+#include "commandbuffer.h"
+#include "framepacket.h"
+
+class TestBuffer : public CommandBuffer {
+public:
+    void drawMesh(const Matrix4 &model, Mesh *, uint32_t sub, uint32_t, MaterialInstance *material) override {
+        m_Models.push_back(model);
+        m_Values.push_back(*static_cast<float *>(material->params()["value"].ptr));
+        m_Subs.push_back(sub);
+    }
+
+    void setGlobalValue(const char *name, const Variant &value) override {
+        m_Globals[name] = value;
+    }
+
+    vector<Matrix4> m_Models;
+
+    vector<float> m_Values;
+
+    vector<uint32_t> m_Subs;
+
+    map<string, Variant> m_Globals;
+
+};
+
+class FramePacketTest : public QObject {
+    Q_OBJECT
+private slots:
+
+void Frame_packet_replay() {
+    TestBuffer target;
+    FramePacket packet;
+
+    FrameRecorder recorder(&target);
+    recorder.setPacket(&packet);
+
+    Mesh mesh;
+    MaterialInstance instance(nullptr);
+    float value = 1.0f;
+    instance.setFloat("value", &value);
+
+    Matrix4 model;
+    model.translate(Vector3(1.0f, 2.0f, 3.0f));
+
+    recorder.setGlobalValue("time", 0.5f);
+    recorder.drawMesh(model, &mesh, 0, CommandBuffer::DEFAULT, &instance);
+    // Changes after the recording must not affect the packet
+    value = 2.0f;
+    recorder.drawMesh(Matrix4(), &mesh, 0, CommandBuffer::DEFAULT, &instance);
+
+    recorder.setViewProjection(model, Matrix4());
+    QCOMPARE(recorder.view() == model, true);
+    recorder.resetViewProjection();
+    QCOMPARE(recorder.view() == Matrix4(), true);
+
+    QCOMPARE(packet.size(), 5U);
+    QCOMPARE(target.m_Models.empty(), true);
+
+    packet.replay(target);
+    QCOMPARE(target.m_Models.size(), 2);
+    QCOMPARE(target.m_Models[0] == model, true);
+    QCOMPARE(target.m_Values[0], 1.0f);
+    QCOMPARE(target.m_Values[1], 2.0f);
+    QCOMPARE(target.m_Globals["time"].toFloat(), 0.5f);
+
+    packet.clear();
+    QCOMPARE(packet.size(), 0U);
+}
+
+} REGISTER(FramePacketTest)
+
+#include "tst_framepacket.moc"
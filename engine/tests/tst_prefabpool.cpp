@@ -0,0 +1,84 @@
+#include "tst_common.h"
+
+#include "components/actor.h"
+#include "components/transform.h"
+#include "components/component.h"
+#include "components/scene.h"
+
+#include "resources/prefab.h"
+
+#include "prefabpool.h"
+
+class PooledComponent : public Component {
+public:
+    A_REGISTER(PooledComponent, Component, Components);
+
+    A_NOPROPERTIES()
+    A_NOMETHODS()
+
+};
+
+class PrefabPoolTest : public QObject {
+    Q_OBJECT
+private slots:
+
+void Prefab_pool_reuse() {
+    Engine system(nullptr, "");
+    PooledComponent::registerClassFactory(&system);
+
+    Actor *prefab = Engine::composeActor("PooledComponent", "Prefab");
+    QCOMPARE(prefab != nullptr, true);
+
+    const Vector3 origin(1.0f, 2.0f, 3.0f);
+    prefab->transform()->setPosition(origin);
+
+    Prefab *fab = Engine::objectCreate<Prefab>("");
+    fab->setActor(prefab);
+
+    Scene *scene = Engine::objectCreate<Scene>("Scene");
+
+    PrefabPool pool(fab);
+
+    Actor *instance = pool.acquire(scene);
+    QCOMPARE(instance != nullptr, true);
+    QCOMPARE(instance->isInstance(), true);
+    QCOMPARE(instance->isEnabled(), false);
+    QCOMPARE(instance->parent() == scene, true);
+    QCOMPARE(pool.active(), 1U);
+
+    instance->setEnabled(true);
+    instance->transform()->setPosition(Vector3(10.0f));
+    delete instance->component("PooledComponent");
+
+    pool.release(instance);
+    QCOMPARE(instance->parent() == nullptr, true);
+    QCOMPARE(pool.active(), 0U);
+    QCOMPARE(pool.available(), 1U);
+
+    // The same instance is reused and restored to the prefab defaults
+    Actor *reused = pool.acquire(scene);
+    QCOMPARE(reused == instance, true);
+    QCOMPARE(reused->transform()->position(), origin);
+    QCOMPARE(reused->component("PooledComponent") != nullptr, true);
+    QCOMPARE(pool.size(), 1U);
+
+    pool.release(reused);
+
+    // Background instances are built from the prefab state at the reserve() call
+    PrefabPool background(fab, 2);
+    prefab->transform()->setPosition(Vector3(5.0f));
+    QTRY_COMPARE(background.available(), 2U);
+
+    Actor *copy = background.acquire(scene);
+    QCOMPARE(copy->isInstance(), true);
+    QCOMPARE(copy->clonedFrom(), prefab->uuid());
+    QCOMPARE(copy->transform()->position(), origin);
+
+    background.release(copy);
+
+    delete scene;
+}
+
+} REGISTER(PrefabPoolTest)
+
+#include "tst_prefabpool.moc"
@@ -0,0 +1,113 @@
+#include "tst_common.h"
+
+#include "components/transform.h"
+#include "components/camera.h"
+
+#include "system.h"
+#include "systemscheduler.h"
+
+#include <algorithm>
+#include <mutex>
+
+class TestSystem : public System {
+public:
+    TestSystem(const char *name, int policy, int stage, list<string> &log) :
+            m_pName(name),
+            m_Policy(policy),
+            m_Stage(stage),
+            m_Log(log) {
+
+    }
+
+    bool init() override {
+        return true;
+    }
+
+    const char *name() const override {
+        return m_pName;
+    }
+
+    void update(Scene *) override {
+        unique_lock<mutex> locker(m_Mutex);
+        m_Log.push_back(m_pName);
+    }
+
+    int threadPolicy() const override {
+        return m_Policy;
+    }
+
+    int stage() const override {
+        return m_Stage;
+    }
+
+    using System::addRead;
+    using System::addWrite;
+
+    const char *m_pName;
+
+    int m_Policy;
+
+    int m_Stage;
+
+    list<string> &m_Log;
+
+    static mutex m_Mutex;
+
+};
+
+mutex TestSystem::m_Mutex;
+
+class SystemSchedulerTest : public QObject {
+    Q_OBJECT
+private slots:
+
+void System_scheduler() {
+    list<string> log;
+
+    TestSystem render("Render", System::Main, System::Presentation, log);
+    render.addRead<Transform>();
+    TestSystem physics("Physics", System::Pool, System::Simulation, log);
+    physics.addWrite<Transform>();
+    TestSystem audio("Audio", System::Pool, System::Simulation, log);
+    audio.addRead<Camera>();
+    TestSystem script("Script", System::Pool, System::Simulation, log);
+
+    SystemScheduler scheduler;
+    scheduler.addSystem(&render);
+    scheduler.addSystem(&physics);
+    scheduler.addSystem(&audio);
+
+    // The producer goes first regardless of the registration order, independent systems don't wait each other
+    QCOMPARE(scheduler.dependsOn(&render, &physics), true);
+    QCOMPARE(scheduler.dependsOn(&physics, &render), false);
+    QCOMPARE(scheduler.dependsOn(&audio, &physics), false);
+    QCOMPARE(scheduler.dependsOn(&physics, &audio), false);
+
+    scheduler.execute(nullptr);
+    QCOMPARE(log.size(), 3);
+    QCOMPARE(distance(log.begin(), find(log.begin(), log.end(), "Physics")) <
+             distance(log.begin(), find(log.begin(), log.end(), "Render")), true);
+
+    // The system without declarations is exclusive
+    scheduler.addSystem(&script);
+    QCOMPARE(scheduler.dependsOn(&script, &audio), true);
+    QCOMPARE(scheduler.dependsOn(&script, &render), true);
+
+    // The presentation reads the previous frame state before the simulation writes it in the pipelined mode
+    scheduler.setPipelined(true);
+    QCOMPARE(scheduler.dependsOn(&render, &physics), false);
+    QCOMPARE(scheduler.dependsOn(&physics, &render), true);
+    QCOMPARE(scheduler.dependsOn(&script, &render), true);
+    QCOMPARE(scheduler.dependsOn(&script, &physics), true);
+    QCOMPARE(scheduler.dependsOn(&audio, &render), false);
+
+    log.clear();
+    scheduler.execute(nullptr);
+    QCOMPARE(log.size(), 4);
+    QCOMPARE(distance(log.begin(), find(log.begin(), log.end(), "Render")) <
+             distance(log.begin(), find(log.begin(), log.end(), "Physics")), true);
+}
+
+} REGISTER(SystemSchedulerTest)
+
+#include "tst_systemscheduler.moc"
@@ -38,6 +38,10 @@ public:
 private:
     void draw(CommandBuffer &buffer, uint32_t layer) override;
 
+    Mesh *batchMesh() const override;
+
+    MaterialInstance *batchMaterial() const override;
+
     void loadUserData(const VariantMap &data) override;
     VariantMap saveUserData() const override;
 
@@ -46,6 +50,8 @@ private:
     void composeComponent() override;
 
 private:
+    friend class ImagePrivate;
+
     ImagePrivate *p_ptr;
 };
 
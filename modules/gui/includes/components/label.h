@@ -51,6 +51,10 @@ public:
 private:
     void draw(CommandBuffer &buffer, uint32_t layer) override;
 
+    Mesh *batchMesh() const override;
+
+    MaterialInstance *batchMaterial() const override;
+
     void loadData(const VariantList &data) override;
     void loadUserData(const VariantMap &data) override;
     VariantMap saveUserData() const override;
@@ -62,6 +66,8 @@ private:
     void composeComponent() override;
 
 private:
+    friend class LabelPrivate;
+
     LabelPrivate *p_ptr;
 
 };
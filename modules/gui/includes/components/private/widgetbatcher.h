@@ -0,0 +1,76 @@
+#ifndef WIDGETBATCHER_H
+#define WIDGETBATCHER_H
+
+#include <amath.h>
+
+#include <resources/mesh.h>
+
+class Actor;
+class Widget;
+class MaterialInstance;
+class CommandBuffer;
+
+class WidgetBatcher {
+    struct Item {
+        Widget *widget;
+
+        Mesh *mesh;
+
+        MaterialInstance *material;
+
+        Matrix4 transform;
+
+        Vector4 rect;
+
+        uint32_t vertexOffset;
+
+        uint32_t vertexCount;
+
+        uint32_t indexOffset;
+
+        uint32_t indexCount;
+
+        uint32_t revision;
+    };
+
+    struct Batch {
+        vector<Item> items;
+
+        Lod lod;
+
+        Mesh *meshes[2];
+
+        Mesh *mesh;
+    };
+
+public:
+    WidgetBatcher();
+    ~WidgetBatcher();
+
+    void draw(CommandBuffer &buffer, Actor *root);
+
+    uint32_t batchesCount() const;
+
+protected:
+    void collect(Actor *actor, vector<Item> &items) const;
+
+    void assign(const Item &item, vector<vector<Item>> &batches, vector<Vector4> &rects) const;
+
+    bool update(Batch &batch, vector<Item> &items);
+
+    void rebuild(Batch &batch, vector<Item> &items);
+
+    void upload(Batch &batch);
+
+    static void writeItem(Lod &lod, const Item &item);
+
+    static bool isCompatible(const Item &left, const Item &right);
+
+private:
+    vector<Batch> m_Batches;
+
+    uint32_t m_Count;
+
+};
+
+#endif // WIDGETBATCHER_H
@@ -37,7 +37,14 @@ class RectTransform : public Transform {
     void subscribe(Widget *widget);
     void unsubscribe(Widget *widget);
 
+    void setParent(Object *parent, int32_t position = -1, bool force = false) override;
+
+protected:
+    void setDirty() override;
+
 private:
+    friend class RectTransformPrivate;
+
     RectTransformPrivate *p_ptr;
 };
 
@@ -6,6 +6,8 @@
 class WidgetPrivate;
 
 class RectTransform;
+class Mesh;
+class MaterialInstance;
 
 class Widget : public Renderable {
     A_REGISTER(Widget, Renderable, Components/UI)
@@ -36,11 +38,23 @@ protected:
 
     void actorParentChanged() override;
 
+    virtual Mesh *batchMesh() const;
+
+    virtual MaterialInstance *batchMaterial() const;
+
+    bool drawBatched(CommandBuffer &buffer, uint32_t layer);
+
+    void markDirty();
+
+    uint32_t revision() const;
+
 #ifdef NEXT_SHARED
     bool drawHandles(ObjectList &selected) override;
 #endif
 
 private:
+    friend class WidgetBatcher;
+
     WidgetPrivate *p_ptr;
 
 };
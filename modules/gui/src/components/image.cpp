@@ -63,6 +63,7 @@ public:
             if(m_pCustomMesh && m_pSprite) {
                 Vector2 size = t->size();
                 SpriteRender::composeMesh(m_pSprite, m_Hash, m_pCustomMesh, size, false, false, 100.0f);
+                m_pImage->markDirty();
             }
         }
     }
@@ -97,6 +98,10 @@ Image::~Image() {
     \internal
 */
 void Image::draw(CommandBuffer &buffer, uint32_t layer) {
+    if(drawBatched(buffer, layer)) {
+        return;
+    }
+
     Actor *a = actor();
     if(p_ptr->m_pCustomMesh) {
         if(layer & CommandBuffer::RAYCAST) {
@@ -109,6 +114,18 @@ void Image::draw(CommandBuffer &buffer, uint32_t layer) {
     }
 }
 
+/*!
+    \internal
+*/
+Mesh *Image::batchMesh() const {
+    return (p_ptr->m_pSprite) ? p_ptr->m_pCustomMesh : nullptr;
+}
+/*!
+    \internal
+*/
+MaterialInstance *Image::batchMaterial() const {
+    return (p_ptr->m_pCustomMaterial) ? p_ptr->m_pCustomMaterial : p_ptr->m_pMaterial;
+}
 /*!
     Returns an instantiated Material assigned to SpriteRender.
 */
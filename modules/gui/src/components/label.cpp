@@ -26,14 +26,19 @@ public:
         m_pLabel(label),
         m_pFont(nullptr),
         m_pMaterial(nullptr),
-        m_pMesh(Engine::objectCreate<Mesh>()),
+        m_pMesh(nullptr),
+        m_pDrawn(nullptr),
         m_Size(16),
         m_Alignment(Left),
         m_Kerning(true),
         m_Wrap(false) {
 
-        m_pMesh->makeDynamic();
-        m_pMesh->setFlags(Mesh::Uv0);
+        for(auto &it : m_pMeshes) {
+            it = Engine::objectCreate<Mesh>();
+            it->makeDynamic();
+            it->setFlags(Mesh::Uv0);
+        }
+        m_pMesh = m_pMeshes[0];
 
         Material *material = Engine::loadResource<Material>(".embedded/DefaultFont.mtl");
         if(material) {
@@ -57,7 +62,11 @@ public:
     void composeMesh() {
         RectTransform *t = dynamic_cast<RectTransform *>(m_pLabel->actor()->transform());
         if(t) {
-            TextRender::composeMesh(m_pFont, m_pMesh, m_Size, m_Text, m_Alignment, m_Kerning, m_Wrap, t->size());
+            // The render thread can still upload the mesh of the last recorded frame, so the other one is rewritten
+            Mesh *mesh = (m_pDrawn == m_pMeshes[0]) ? m_pMeshes[1] : m_pMeshes[0];
+            TextRender::composeMesh(m_pFont, mesh, m_Size, m_Text, m_Alignment, m_Kerning, m_Wrap, t->size());
+            m_pMesh = mesh;
+            m_pLabel->markDirty();
         }
     }
 
@@ -71,8 +80,12 @@ public:
 
     MaterialInstance *m_pMaterial;
 
+    Mesh *m_pMeshes[2];
+
     Mesh *m_pMesh;
 
+    Mesh *m_pDrawn;
+
     int32_t m_Size;
 
     int m_Alignment;
@@ -103,6 +116,14 @@ Label::~Label() {
     \internal
 */
 void Label::draw(CommandBuffer &buffer, uint32_t layer) {
+    if(p_ptr->m_pFont) {
+        p_ptr->m_pFont->commitGlyphs();
+    }
+
+    if(drawBatched(buffer, layer)) {
+        return;
+    }
+
     Actor *a = actor();
     if(p_ptr->m_pMesh && !p_ptr->m_Text.empty()) {
         if(layer & CommandBuffer::RAYCAST) {
@@ -110,8 +131,22 @@ void Label::draw(CommandBuffer &buffer, uint32_t layer) {
         }
         buffer.drawMesh(a->transform()->worldTransform(), p_ptr->m_pMesh, 0, layer, p_ptr->m_pMaterial);
         buffer.setColor(Vector4(1.0f));
+
+        p_ptr->m_pDrawn = p_ptr->m_pMesh;
     }
 }
+/*!
+    \internal
+*/
+Mesh *Label::batchMesh() const {
+    return (p_ptr->m_Text.empty()) ? nullptr : p_ptr->m_pMesh;
+}
+/*!
+    \internal
+*/
+MaterialInstance *Label::batchMaterial() const {
+    return p_ptr->m_pMaterial;
+}
 /*!
     Returns the text which will be drawn.
 */
@@ -122,8 +157,10 @@ string Label::text() const {
     Changes the \a text which will be drawn.
 */
 void Label::setText(const string &text) {
-    p_ptr->m_Text = text;
-    p_ptr->composeMesh();
+    if(p_ptr->m_Text != text) {
+        p_ptr->m_Text = text;
+        p_ptr->composeMesh();
+    }
 }
 /*!
     Returns the font which will be used to draw a text.
@@ -0,0 +1,272 @@
+#include "components/private/widgetbatcher.h"
+
+#include "components/widget.h"
+
+#include <components/actor.h>
+#include <components/transform.h>
+
+#include <resources/material.h>
+
+#include <commandbuffer.h>
+
+#include <cstring>
+
+/*!
+    \class WidgetBatcher
+    \brief Merges the widgets of the single UI tree into a few dynamic meshes.
+    \internal
+
+    Widgets which share the same material and material parameters (textures, colors) are placed into the same batch.
+    A widget may join an earlier batch only if it doesn't overlap anything drawn after that batch, so the visual draw order is preserved.
+    When the layout of a batch is the same as in the previous frame only the vertex ranges of the changed widgets are rewritten.
+*/
+
+WidgetBatcher::WidgetBatcher() :
+        m_Count(0) {
+
+}
+
+WidgetBatcher::~WidgetBatcher() {
+    for(auto &it : m_Batches) {
+        delete it.meshes[0];
+        delete it.meshes[1];
+    }
+}
+/*!
+    Collects all visible widgets under the \a root actor and draws them into the \a buffer using batches.
+*/
+void WidgetBatcher::draw(CommandBuffer &buffer, Actor *root) {
+    PROFILE_FUNCTION();
+
+    vector<Item> items;
+    collect(root, items);
+
+    vector<vector<Item>> groups;
+    vector<Vector4> rects;
+    for(auto &it : items) {
+        assign(it, groups, rects);
+    }
+
+    while(m_Batches.size() < groups.size()) {
+        Batch batch;
+        for(auto &it : batch.meshes) {
+            it = Engine::objectCreate<Mesh>();
+            it->makeDynamic();
+            it->setFlags(Mesh::Uv0);
+        }
+        batch.mesh = batch.meshes[0];
+
+        m_Batches.push_back(batch);
+    }
+
+    m_Count = groups.size();
+    for(uint32_t i = 0; i < m_Count; i++) {
+        Batch &batch = m_Batches[i];
+        if(!update(batch, groups[i])) {
+            rebuild(batch, groups[i]);
+        }
+
+        buffer.drawMesh(Matrix4(), batch.mesh, 0, CommandBuffer::UI, batch.items.front().material);
+    }
+    for(uint32_t i = m_Count; i < m_Batches.size(); i++) {
+        m_Batches[i].items.clear();
+    }
+}
+/*!
+    Returns the number of batches (draw calls) produced for the last frame.
+*/
+uint32_t WidgetBatcher::batchesCount() const {
+    return m_Count;
+}
+/*!
+    Walks the \a actor hierarchy in the drawing order and fills the \a items with the widgets geometry.
+*/
+void WidgetBatcher::collect(Actor *actor, vector<Item> &items) const {
+    for(auto it : actor->getChildren()) {
+        if(it->isComponent()) {
+            Widget *widget = dynamic_cast<Widget *>(it);
+            if(widget && widget->isEnabled()) {
+                Mesh *mesh = widget->batchMesh();
+                MaterialInstance *material = widget->batchMaterial();
+                Lod *lod = (mesh) ? mesh->lod(0) : nullptr;
+                if(material && lod && !lod->vertices().empty() && !lod->indices().empty()) {
+                    Item item;
+                    item.widget = widget;
+                    item.mesh = mesh;
+                    item.material = material;
+                    item.transform = actor->transform()->worldTransform();
+                    item.vertexOffset = 0;
+                    item.vertexCount = lod->vertices().size();
+                    item.indexOffset = 0;
+                    item.indexCount = lod->indices().size();
+                    item.revision = widget->revision();
+
+                    Vector3 min, max;
+                    (mesh->bound() * item.transform).box(min, max);
+                    item.rect = Vector4(min.x, min.y, max.x, max.y);
+
+                    items.push_back(item);
+                }
+            }
+        } else {
+            Actor *child = dynamic_cast<Actor *>(it);
+            if(child && child->isEnabled() && (child->layers() & CommandBuffer::UI)) {
+                collect(child, items);
+            }
+        }
+    }
+}
+/*!
+    Places the \a item to the latest compatible batch it can be moved to without breaking the draw order, or starts a new one.
+*/
+void WidgetBatcher::assign(const Item &item, vector<vector<Item>> &batches, vector<Vector4> &rects) const {
+    for(int32_t i = batches.size() - 1; i >= 0; i--) {
+        if(isCompatible(batches[i].front(), item)) {
+            Vector4 &rect = rects[i];
+            rect = Vector4(MIN(rect.x, item.rect.x), MIN(rect.y, item.rect.y),
+                           MAX(rect.z, item.rect.z), MAX(rect.w, item.rect.w));
+            batches[i].push_back(item);
+            return;
+        }
+
+        const Vector4 &rect = rects[i];
+        if(item.rect.x < rect.z && item.rect.z > rect.x &&
+           item.rect.y < rect.w && item.rect.w > rect.y) {
+            break;
+        }
+    }
+
+    batches.push_back({item});
+    rects.push_back(item.rect);
+}
+/*!
+    Rewrites only the changed widgets of the \a batch in place.
+    Returns false if the set of \a items differs from the previous frame and the batch must be rebuilt.
+*/
+bool WidgetBatcher::update(Batch &batch, vector<Item> &items) {
+    if(batch.items.size() != items.size()) {
+        return false;
+    }
+    for(size_t i = 0; i < items.size(); i++) {
+        const Item &last = batch.items[i];
+        const Item &item = items[i];
+        if(last.widget != item.widget || last.mesh != item.mesh ||
+           last.vertexCount != item.vertexCount || last.indexCount != item.indexCount) {
+            return false;
+        }
+    }
+
+    bool changed = false;
+    for(size_t i = 0; i < items.size(); i++) {
+        Item &last = batch.items[i];
+        Item &item = items[i];
+        item.vertexOffset = last.vertexOffset;
+        item.indexOffset = last.indexOffset;
+        if(last.revision != item.revision || last.transform != item.transform) {
+            writeItem(batch.lod, item);
+            changed = true;
+        }
+    }
+    batch.items.swap(items);
+
+    if(changed) {
+        upload(batch);
+    }
+    return true;
+}
+/*!
+    Fills the \a batch geometry from scratch using the \a items.
+*/
+void WidgetBatcher::rebuild(Batch &batch, vector<Item> &items) {
+    uint32_t vertices = 0;
+    uint32_t indices = 0;
+    for(auto &it : items) {
+        it.vertexOffset = vertices;
+        it.indexOffset = indices;
+        vertices += it.vertexCount;
+        indices += it.indexCount;
+    }
+
+    batch.lod.vertices().resize(vertices);
+    batch.lod.uv0().resize(vertices);
+    batch.lod.indices().resize(indices);
+    for(auto &it : items) {
+        writeItem(batch.lod, it);
+    }
+    batch.items.swap(items);
+
+    upload(batch);
+}
+/*!
+    Copies the \a batch geometry to the mesh which is not used by the last recorded frame.
+    The render thread can still upload the other one while replaying that frame.
+*/
+void WidgetBatcher::upload(Batch &batch) {
+    batch.mesh = (batch.mesh == batch.meshes[0]) ? batch.meshes[1] : batch.meshes[0];
+    batch.mesh->setLod(0, &batch.lod);
+}
+/*!
+    Writes the world space geometry of the \a item to its range in the \a lod.
+*/
+void WidgetBatcher::writeItem(Lod &lod, const Item &item) {
+    Lod *src = item.mesh->lod(0);
+
+    Vector3Vector &vertices = lod.vertices();
+    Vector2Vector &uv = lod.uv0();
+    const Vector3Vector &srcVertices = src->vertices();
+    const Vector2Vector &srcUv = src->uv0();
+    for(uint32_t i = 0; i < item.vertexCount; i++) {
+        vertices[item.vertexOffset + i] = item.transform * srcVertices[i];
+        uv[item.vertexOffset + i] = (i < srcUv.size()) ? srcUv[i] : Vector2();
+    }
+
+    IndexVector &indices = lod.indices();
+    const IndexVector &srcIndices = src->indices();
+    for(uint32_t i = 0; i < item.indexCount; i++) {
+        indices[item.indexOffset + i] = srcIndices[i] + item.vertexOffset;
+    }
+}
+/*!
+    Returns true if the \a left and \a right items can be drawn with the same material instance.
+*/
+bool WidgetBatcher::isCompatible(const Item &left, const Item &right) {
+    if(left.material == right.material) {
+        return true;
+    }
+    if(left.material->material() != right.material->material() ||
+       left.material->surfaceType() != right.material->surfaceType()) {
+        return false;
+    }
+
+    MaterialInstance::InfoMap &l = left.material->params();
+    MaterialInstance::InfoMap &r = right.material->params();
+    if(l.size() != r.size()) {
+        return false;
+    }
+    for(auto &it : l) {
+        auto param = r.find(it.first);
+        if(param == r.end() || param->second.type != it.second.type || param->second.count != it.second.count) {
+            return false;
+        }
+
+        size_t size = 0;
+        switch(it.second.type) {
+            case MetaType::INTEGER: size = sizeof(int32_t); break;
+            case MetaType::FLOAT:   size = sizeof(float); break;
+            case MetaType::VECTOR2: size = sizeof(Vector2); break;
+            case MetaType::VECTOR3: size = sizeof(Vector3); break;
+            case MetaType::VECTOR4: size = sizeof(Vector4); break;
+            case MetaType::MATRIX4: size = sizeof(Matrix4); break;
+            default: break;
+        }
+
+        if(it.second.ptr != param->second.ptr) {
+            // Textures are compared by the pointer, values are compared by the content
+            if(size == 0 || it.second.ptr == nullptr || param->second.ptr == nullptr ||
+               memcmp(it.second.ptr, param->second.ptr, size * it.second.count) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
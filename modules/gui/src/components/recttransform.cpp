@@ -2,14 +2,46 @@
 
 #include "components/widget.h"
 
+#include <algorithm>
+
+#define GRID_SIZE 16
+
+class RectLayout {
+public:
+    RectLayout() :
+        m_Structure(true),
+        m_Dirty(true),
+        m_Queried(false) {
+
+    }
+
+    vector<RectTransform *> m_Items;
+    vector<Vector4> m_Rects;
+    vector<vector<uint32_t>> m_Cells;
+    vector<uint8_t> m_Hovered;
+    Vector4 m_Bounds;
+    Vector2 m_Point;
+    bool m_Structure;
+    bool m_Dirty;
+    bool m_Queried;
+};
+
 class RectTransformPrivate {
 public:
-    RectTransformPrivate() :
+    explicit RectTransformPrivate(RectTransform *transform) :
         m_Size(1.0f),
         m_Pivot(0.0f),
         m_minAnchors(0.5f),
-        m_maxAnchors(0.5f) {
+        m_maxAnchors(0.5f),
+        m_pTransform(transform),
+        m_pLayout(nullptr),
+        m_Index(0),
+        m_RectDirty(true) {
+
+    }
 
+    ~RectTransformPrivate() {
+        delete m_pLayout;
     }
 
     void notify() {
@@ -18,19 +50,190 @@ public:
         }
     }
 
+    RectTransform *root() const {
+        RectTransform *result = m_pTransform;
+        RectTransform *parent = dynamic_cast<RectTransform *>(result->parentTransform());
+        while(parent) {
+            result = parent;
+            parent = dynamic_cast<RectTransform *>(result->parentTransform());
+        }
+        return result;
+    }
+    /*!
+        Marks the cached rect as outdated. In case of \a structure flag the whole layout of the root will be collected again.
+    */
+    void invalidate(bool structure) {
+        m_RectDirty = true;
+
+        RectTransform *r = root();
+        if(r->p_ptr && r->p_ptr->m_pLayout) {
+            RectLayout *layout = r->p_ptr->m_pLayout;
+            layout->m_Dirty = true;
+            layout->m_Queried = false;
+            if(structure || r == m_pTransform) {
+                layout->m_Structure = true;
+            }
+        }
+    }
+
+    Vector4 rect() const {
+        Vector3 pos = m_pTransform->worldPosition() + Vector3(m_Pivot, 0.0f);
+        return Vector4(pos.x, pos.y, pos.x + m_Size.x, pos.y + m_Size.y);
+    }
+    /*!
+        Returns the up to date layout of the hierarchy. Must be called for the root transform only.
+    */
+    RectLayout *layout() {
+        if(m_pLayout == nullptr) {
+            m_pLayout = new RectLayout;
+        }
+
+        if(m_pLayout->m_Structure) {
+            rebuild();
+        } else if(m_pLayout->m_Dirty) {
+            refresh();
+        }
+        return m_pLayout;
+    }
+
+    void collect(RectTransform *transform) {
+        RectTransformPrivate *ptr = transform->p_ptr;
+        ptr->m_Index = m_pLayout->m_Items.size();
+        ptr->m_RectDirty = false;
+
+        m_pLayout->m_Items.push_back(transform);
+        m_pLayout->m_Rects.push_back(ptr->rect());
+
+        for(auto it : transform->children()) {
+            RectTransform *child = dynamic_cast<RectTransform *>(it);
+            if(child) {
+                collect(child);
+            }
+        }
+    }
+
+    void rebuild() {
+        m_pLayout->m_Items.clear();
+        m_pLayout->m_Rects.clear();
+
+        collect(m_pTransform);
+
+        m_pLayout->m_Bounds = m_pLayout->m_Rects.front();
+        m_pLayout->m_Cells.assign(GRID_SIZE * GRID_SIZE, vector<uint32_t>());
+        for(uint32_t i = 0; i < m_pLayout->m_Items.size(); i++) {
+            insert(i);
+        }
+        m_pLayout->m_Hovered.assign(m_pLayout->m_Items.size(), 0);
+
+        m_pLayout->m_Structure = false;
+        m_pLayout->m_Dirty = false;
+        m_pLayout->m_Queried = false;
+    }
+    /*!
+        Updates the rects and grid cells only for the changed transforms.
+    */
+    void refresh() {
+        for(uint32_t i = 0; i < m_pLayout->m_Items.size(); i++) {
+            RectTransformPrivate *ptr = m_pLayout->m_Items[i]->p_ptr;
+            if(ptr->m_RectDirty) {
+                remove(i);
+                m_pLayout->m_Rects[i] = ptr->rect();
+                insert(i);
+                ptr->m_RectDirty = false;
+            }
+        }
+        m_pLayout->m_Dirty = false;
+        m_pLayout->m_Queried = false;
+    }
+
+    void cell(float x, float y, int32_t &cx, int32_t &cy) const {
+        const Vector4 &b = m_pLayout->m_Bounds;
+        float w = MAX(b.z - b.x, 1.0f) / GRID_SIZE;
+        float h = MAX(b.w - b.y, 1.0f) / GRID_SIZE;
+        cx = CLAMP(static_cast<int32_t>((x - b.x) / w), 0, GRID_SIZE - 1);
+        cy = CLAMP(static_cast<int32_t>((y - b.y) / h), 0, GRID_SIZE - 1);
+    }
+
+    void insert(uint32_t index) {
+        const Vector4 &r = m_pLayout->m_Rects[index];
+        int32_t x0, y0, x1, y1;
+        cell(r.x, r.y, x0, y0);
+        cell(r.z, r.w, x1, y1);
+        for(int32_t y = y0; y <= y1; y++) {
+            for(int32_t x = x0; x <= x1; x++) {
+                m_pLayout->m_Cells[y * GRID_SIZE + x].push_back(index);
+            }
+        }
+    }
+
+    void remove(uint32_t index) {
+        const Vector4 &r = m_pLayout->m_Rects[index];
+        int32_t x0, y0, x1, y1;
+        cell(r.x, r.y, x0, y0);
+        cell(r.z, r.w, x1, y1);
+        for(int32_t y = y0; y <= y1; y++) {
+            for(int32_t x = x0; x <= x1; x++) {
+                vector<uint32_t> &c = m_pLayout->m_Cells[y * GRID_SIZE + x];
+                c.erase(std::remove(c.begin(), c.end(), index), c.end());
+            }
+        }
+    }
+    /*!
+        Finds all rects under the point (\a x, \a y). The result is reused by all transforms until the point or layout is changed.
+    */
+    void query(float x, float y) {
+        Vector2 point(x, y);
+        if(m_pLayout->m_Queried && m_pLayout->m_Point == point) {
+            return;
+        }
+        std::fill(m_pLayout->m_Hovered.begin(), m_pLayout->m_Hovered.end(), 0);
+
+        int32_t cx, cy;
+        cell(x, y, cx, cy);
+        for(auto index : m_pLayout->m_Cells[cy * GRID_SIZE + cx]) {
+            const Vector4 &r = m_pLayout->m_Rects[index];
+            if(x > r.x && x < r.z && y > r.y && y < r.w) {
+                m_pLayout->m_Hovered[index] = 1;
+            }
+        }
+
+        m_pLayout->m_Point = point;
+        m_pLayout->m_Queried = true;
+    }
+
     Vector2 m_Size;
     Vector2 m_Pivot;
     Vector2 m_minAnchors;
     Vector2 m_maxAnchors;
     list<Widget *> m_Subscribers;
+
+    RectTransform *m_pTransform;
+
+    RectLayout *m_pLayout;
+
+    uint32_t m_Index;
+
+    bool m_RectDirty;
 };
 
+/*!
+    \class RectTransform
+    \brief Position, size, pivot and anchors of a UI element.
+    \inmodule Gui
+
+    The world rects of the whole RectTransform hierarchy are cached by the root transform in a flat array.
+    The cache is updated only when size, pivot, position or the parent of any transform in the hierarchy is changed.
+    Hover testing uses a uniform grid built over the cached rects.
+*/
+
 RectTransform::RectTransform() :
-    p_ptr(new RectTransformPrivate) {
+    p_ptr(new RectTransformPrivate(this)) {
 
 }
 
 RectTransform::~RectTransform() {
+    p_ptr->invalidate(true);
+
     list<Widget *> list = p_ptr->m_Subscribers;
     for(auto it : list) {
         it->setRectTransform(nullptr);
@@ -55,6 +258,7 @@ void RectTransform::setSize(const Vector2 &size) {
         }
 
         p_ptr->m_Size = size;
+        p_ptr->invalidate(false);
         p_ptr->notify();
     }
 }
@@ -65,6 +269,7 @@ Vector2 RectTransform::pivot() const {
 void RectTransform::setPivot(const Vector2 &pivot) {
     if(p_ptr->m_Pivot != pivot) {
         p_ptr->m_Pivot = pivot;
+        p_ptr->invalidate(false);
         p_ptr->notify();
     }
 }
@@ -86,11 +291,12 @@ void RectTransform::setMaxAnchors(const Vector2 &anchors) {
 bool RectTransform::isHovered(float x, float y) const {
     Actor *parent = actor();
     if(parent) {
-        Vector3 pos = worldPosition() + Vector3(p_ptr->m_Pivot, 0.0f);
-        if(x > pos.x && x < pos.x + p_ptr->m_Size.x &&
-           y > pos.y && y < pos.y + p_ptr->m_Size.y) {
-            return true;
-        }
+        RectTransformPrivate *root = p_ptr->root()->p_ptr;
+        RectLayout *layout = root->layout();
+        root->query(x, y);
+
+        uint32_t index = p_ptr->m_Index;
+        return (index < layout->m_Items.size() && layout->m_Items[index] == this && layout->m_Hovered[index]);
     }
     return false;
 }
@@ -102,3 +308,22 @@ void RectTransform::subscribe(Widget *widget) {
 void RectTransform::unsubscribe(Widget *widget) {
     p_ptr->m_Subscribers.remove(widget);
 }
+/*!
+    \internal
+*/
+void RectTransform::setParent(Object *parent, int32_t position, bool force) {
+    p_ptr->invalidate(true);
+
+    Transform::setParent(parent, position, force);
+
+    p_ptr->invalidate(true);
+}
+/*!
+    \internal
+*/
+void RectTransform::setDirty() {
+    if(p_ptr) {
+        p_ptr->invalidate(false);
+    }
+    Transform::setDirty();
+}
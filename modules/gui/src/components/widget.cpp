@@ -2,6 +2,8 @@
 
 #include "components/recttransform.h"
 
+#include "components/private/widgetbatcher.h"
+
 #include <components/actor.h>
 #include <components/transform.h>
 #include <components/camera.h>
@@ -10,16 +12,33 @@
 
 #include <commandbuffer.h>
 
+namespace {
+    const char *BATCHING("gui.batching");
+}
+
 class WidgetPrivate {
 public:
     WidgetPrivate() :
         m_pParent(nullptr),
-        m_pTransform(nullptr) {
+        m_pTransform(nullptr),
+        m_pBatcher(nullptr),
+        m_Revision(0) {
+
+    }
+
+    ~WidgetPrivate() {
+        delete m_pBatcher;
+    }
 
+    static bool isBatching() {
+        static bool batching = Engine::value(BATCHING, true).toBool();
+        return batching;
     }
 
     Widget *m_pParent;
     RectTransform *m_pTransform;
+    WidgetBatcher *m_pBatcher;
+    uint32_t m_Revision;
 };
 
 Widget::Widget() :
@@ -40,9 +59,6 @@ void Widget::update() {
 }
 
 void Widget::draw(CommandBuffer &buffer, uint32_t layer) {
-    A_UNUSED(buffer);
-    A_UNUSED(layer);
-
     if(p_ptr->m_pParent == nullptr && (layer == CommandBuffer::UI)) {
         Camera *camera = Camera::current();
         if(camera) {
@@ -52,6 +68,8 @@ void Widget::draw(CommandBuffer &buffer, uint32_t layer) {
             }
         }
     }
+
+    drawBatched(buffer, layer);
 }
 
 AABBox Widget::bound() const {
@@ -70,6 +88,56 @@ void Widget::boundChanged() {
 Widget *Widget::parentWidget() {
     return p_ptr->m_pParent;
 }
+/*!
+    Returns the mesh which should be merged into the UI batch.
+    Widgets without geometry return nullptr.
+*/
+Mesh *Widget::batchMesh() const {
+    return nullptr;
+}
+/*!
+    Returns the material instance which should be used to draw the batchMesh().
+*/
+MaterialInstance *Widget::batchMaterial() const {
+    return nullptr;
+}
+/*!
+    Returns true if this widget is drawn by the batcher of the root widget in the \a layer, so the own draw call must be skipped.
+    The root widget draws the whole batched tree into the \a buffer.
+*/
+bool Widget::drawBatched(CommandBuffer &buffer, uint32_t layer) {
+    if(layer != CommandBuffer::UI || !WidgetPrivate::isBatching()) {
+        return false;
+    }
+
+    Widget *root = this;
+    while(root->p_ptr->m_pParent) {
+        root = root->p_ptr->m_pParent;
+    }
+    if(!root->isEnabled()) {
+        return false;
+    }
+
+    if(root == this) {
+        if(p_ptr->m_pBatcher == nullptr) {
+            p_ptr->m_pBatcher = new WidgetBatcher;
+        }
+        p_ptr->m_pBatcher->draw(buffer, actor());
+    }
+    return true;
+}
+/*!
+    Marks the geometry of the widget as changed, so the batcher will rewrite it on the next frame.
+*/
+void Widget::markDirty() {
+    p_ptr->m_Revision++;
+}
+/*!
+    Returns the revision of the widget geometry which is increased on every markDirty() call.
+*/
+uint32_t Widget::revision() const {
+    return p_ptr->m_Revision;
+}
 /*!
     \internal
 */
@@ -29,6 +29,8 @@ GuiSystem::GuiSystem() :
     Switch::registerClassFactory(this);
 
     ProgressBar::registerClassFactory(this);
+
+    addRead<Widget>();
 }
 
 GuiSystem::~GuiSystem() {
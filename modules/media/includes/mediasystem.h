@@ -18,6 +18,8 @@ public:
 
     int threadPolicy() const;
 
+    int stage() const;
+
 protected:
     ALCdevice                  *m_pDevice;
     ALCcontext                 *m_pContext;
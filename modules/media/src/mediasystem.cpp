@@ -21,6 +21,9 @@ MediaSystem::MediaSystem() :
     AudioSource::registerClassFactory(this);
 
     AudioClip::registerClassFactory(this);
+
+    addRead<Camera>();
+    addRead<Transform>();
 }
 
 MediaSystem::~MediaSystem() {
@@ -72,3 +75,7 @@ void MediaSystem::update(Scene *) {
 int MediaSystem::threadPolicy() const {
     return Pool;
 }
+
+int MediaSystem::stage() const {
+    return Presentation;
+}
@@ -3,7 +3,15 @@
 
 #include <system.h>
 
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "components/collider.h"
+
 class Engine;
+class RigidBody;
 
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
@@ -24,7 +32,26 @@ public:
 
     int threadPolicy() const override;
 
+    float fixedStep() const;
+    void setFixedStep(float step);
+
+    void detachCollider(Collider *collider);
+
+    std::recursive_mutex &worldMutex();
+
 protected:
+    void start();
+    void stop();
+
+    void run();
+
+    void step();
+
+    void updateContacts(btDynamicsWorld *world);
+
+protected:
+    typedef std::chrono::steady_clock::time_point StepPoint;
+
     bool m_Inited;
 
     btDefaultCollisionConfiguration *m_pCollisionConfiguration;
@@ -36,6 +63,26 @@ protected:
     btSequentialImpulseConstraintSolver *m_pSolver;
 
     unordered_map<uint32_t, btDynamicsWorld *> m_Worlds;
+
+    vector<Collider *> m_Colliders;
+
+    vector<RigidBody *> m_Bodies;
+
+    Collider::ContactQueue m_Contacts;
+
+    Collider::ContactQueue m_Events;
+
+    std::thread m_Thread;
+
+    std::recursive_mutex m_Mutex;
+
+    std::atomic<bool> m_Running;
+
+    std::atomic<float> m_Step;
+
+    StepPoint m_StepTime;
+
+    StepPoint m_FrameStepTime;
 };
 
 #endif // BULLETSYSTEM_H
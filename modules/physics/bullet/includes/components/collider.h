@@ -5,6 +5,8 @@
 
 #include <btBulletDynamicsCommon.h>
 
+#include <mutex>
+
 class Collider : public Component {
     A_REGISTER(Collider, Component, General)
 
@@ -15,6 +17,21 @@ class Collider : public Component {
         A_SIGNAL(Collider::exited)
     )
 
+public:
+    enum ContactState {
+        Entered = 0,
+        Stay,
+        Exited
+    };
+
+    struct Contact {
+        Collider *collider;
+
+        int32_t state;
+    };
+
+    typedef vector<Contact> ContactQueue;
+
 public:
     Collider();
     ~Collider() override;
@@ -35,11 +52,19 @@ public:
 protected:
     virtual void createCollider();
 
+    virtual void destroyCollider();
+
+    void detachCollider();
+
+    std::recursive_mutex &worldMutex() const;
+
     void dirtyContacts();
 
-    void cleanContacts();
+    void cleanContacts(ContactQueue &queue);
+
+    void setContact(Collider *other, ContactQueue &queue);
 
-    void setContact(Collider *other);
+    void emitContact(int32_t state);
 
 protected:
     friend class BulletSystem;
@@ -52,7 +52,27 @@ protected:
 
     void createCollider() override;
 
+    void destroyCollider() override;
+
+    void swapBuffers();
+
+    void publish();
+
+    void interpolate(float factor);
+
+    void syncMotion();
+
 protected:
+    friend class BulletSystem;
+
+    btTransform m_Motion;
+
+    btTransform m_Previous;
+    btTransform m_Current;
+
+    btTransform m_From;
+    btTransform m_To;
+
     float m_Mass;
 
     list<VolumeCollider *> m_Colliders;
@@ -61,6 +81,8 @@ protected:
     int32_t m_LockRotation;
 
     bool m_Kinematic;
+
+    bool m_Settled;
 };
 
 #endif // RIGIDBODY_H
@@ -34,7 +34,7 @@ public:
 protected:
     void createCollider() override;
 
-    void update() override;
+    void destroyCollider() override;
 
 private:
     void loadUserData(const VariantMap &data) override;
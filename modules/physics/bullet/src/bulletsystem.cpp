@@ -3,15 +3,18 @@
 #include <assert.h>
 
 #include <cstring>
+#include <algorithm>
 
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
 
 #include <log.h>
 #include <timer.h>
+#include <componentregistry.h>
 
 #include <components/scene.h>
 #include <components/actor.h>
+#include <components/transform.h>
 
 #include "components/rigidbody.h"
 #include "components/collider.h"
@@ -21,13 +24,20 @@
 
 #include "resources/physicmaterial.h"
 
+#define FIXED_STEP (1.0f / 60.0f)
+#define MAX_STEPS 4
+
+using namespace std::chrono;
+
 BulletSystem::BulletSystem(Engine *engine) :
         System(),
         m_Inited(false),
         m_pCollisionConfiguration(nullptr),
         m_pDispatcher(nullptr),
         m_pOverlappingPairCache(nullptr),
-        m_pSolver(nullptr) {
+        m_pSolver(nullptr),
+        m_Running(false),
+        m_Step(FIXED_STEP) {
     PROFILE_FUNCTION();
 
     Collider::registerClassFactory(this);
@@ -40,11 +50,18 @@ BulletSystem::BulletSystem(Engine *engine) :
     CapsuleCollider::registerClassFactory(this);
 
     PhysicMaterial::registerClassFactory(engine->resourceSystem());
+
+    // Bodies move the transforms, the contact receivers can modify the colliders
+    addRead<Transform>();
+    addWrite<Transform>();
+    addWrite<Collider>();
 }
 
 BulletSystem::~BulletSystem() {
     PROFILE_FUNCTION();
 
+    stop();
+
     for(auto &it : m_Worlds) {
         delete it.second;
     }
@@ -87,51 +104,230 @@ const char *BulletSystem::name() const {
     return "Bullet Physics";
 }
 
+/*!
+    Synchronizes the scene with the physics thread.
+    New colliders are attached to the world, poses of the bodies are interpolated between the two last simulation steps
+    and the contact signals collected by the physics thread are emitted.
+*/
 void BulletSystem::update(Scene *scene) {
     PROFILE_FUNCTION();
 
-    if(Engine::isGameMode()) {
-        btDynamicsWorld *world = nullptr;
-        auto it = m_Worlds.find(scene->uuid());
-        if(it == m_Worlds.end()) {
-            world = new btDiscreteDynamicsWorld(m_pDispatcher, m_pOverlappingPairCache, m_pSolver, m_pCollisionConfiguration);
-            m_Worlds[scene->uuid()] = world;
-        } else {
-            world = it->second;
+    if(!Engine::isGameMode()) {
+        stop();
+        return;
+    }
+
+    {
+        // Never wait for the running simulation step, the last published poses will be used instead
+        unique_lock<recursive_mutex> locker(m_Mutex, try_to_lock);
+        if(locker.owns_lock()) {
+            btDynamicsWorld *world = nullptr;
+            auto it = m_Worlds.find(scene->uuid());
+            if(it == m_Worlds.end()) {
+                world = new btDiscreteDynamicsWorld(m_pDispatcher, m_pOverlappingPairCache, m_pSolver, m_pCollisionConfiguration);
+                m_Worlds[scene->uuid()] = world;
+            } else {
+                world = it->second;
+            }
+
+            ComponentRegistry::Pool &pool = ComponentRegistry::pool<Collider>();
+            for(uint32_t i = 0; i < pool.size(); i++) {
+                // The colliders of the other systems are updated by their owners
+                if(pool.system(i) != this) {
+                    continue;
+                }
+                Collider *collider = static_cast<Collider *>(pool.at(i));
+                if(collider->world() == nullptr && pool.scene(i) == scene) {
+                    collider->setWorld(world);
+                    m_Colliders.push_back(collider);
+
+                    RigidBody *body = dynamic_cast<RigidBody *>(collider);
+                    if(body) {
+                        m_Bodies.push_back(body);
+                    }
+                }
+
+                collider->update();
+            }
+
+            for(auto it : m_Bodies) {
+                it->publish();
+            }
+
+            m_Events.insert(m_Events.end(), m_Contacts.begin(), m_Contacts.end());
+            m_Contacts.clear();
+
+            m_FrameStepTime = m_StepTime;
         }
+    }
 
-        for(auto &it : m_ObjectList) {
-            Collider *body = static_cast<Collider *>(it);
-            body->dirtyContacts();
+    start();
+
+    float factor = duration<float>(steady_clock::now() - m_FrameStepTime).count() / m_Step;
+    factor = CLAMP(factor, 0.0f, 1.0f);
+    for(auto it : m_Bodies) {
+        it->interpolate(factor);
+    }
+
+    // Colliders can be destroyed by the signal receivers, detachCollider() will reset the dead entries
+    for(size_t i = 0; i < m_Events.size(); i++) {
+        Collider::Contact contact = m_Events[i];
+        if(contact.collider) {
+            contact.collider->emitContact(contact.state);
         }
+    }
+    m_Events.clear();
+}
 
-        for(int i = 0; i < m_pDispatcher->getNumManifolds(); i++) {
-            btPersistentManifold *contact = m_pDispatcher->getManifoldByIndexInternal(i);
+int BulletSystem::threadPolicy() const {
+    return Main;
+}
+/*!
+    Returns the duration (in seconds) of a single simulation step.
+*/
+float BulletSystem::fixedStep() const {
+    return m_Step;
+}
+/*!
+    Sets the duration (in seconds) of a single simulation \a step.
+    The physics thread will be executed with the frequency 1/step regardless of the frame rate.
+*/
+void BulletSystem::setFixedStep(float step) {
+    if(step > 0.0f) {
+        m_Step = step;
+    }
+}
+/*!
+    \internal
+    Unregisters the \a collider from the physics thread and removes it from the world.
+*/
+void BulletSystem::detachCollider(Collider *collider) {
+    unique_lock<recursive_mutex> locker(m_Mutex);
+
+    m_Colliders.erase(std::remove(m_Colliders.begin(), m_Colliders.end(), collider), m_Colliders.end());
+    m_Bodies.erase(std::remove(m_Bodies.begin(), m_Bodies.end(), collider), m_Bodies.end());
+
+    m_Contacts.erase(std::remove_if(m_Contacts.begin(), m_Contacts.end(), [collider](const Collider::Contact &contact) {
+        return contact.collider == collider;
+    }), m_Contacts.end());
+
+    for(auto &it : m_Events) {
+        if(it.collider == collider) {
+            it.collider = nullptr;
+        }
+    }
 
-            const btCollisionObject *a = static_cast<const btCollisionObject*>(contact->getBody0());
-            const btCollisionObject *b = static_cast<const btCollisionObject*>(contact->getBody1());
+    collider->destroyCollider();
+}
+/*!
+    \internal
+    Returns the mutex which guards the physics worlds against the physics thread.
+*/
+recursive_mutex &BulletSystem::worldMutex() {
+    return m_Mutex;
+}
 
-            Collider *colliderA = reinterpret_cast<Collider *>(a->getUserPointer());
-            Collider *colliderB = reinterpret_cast<Collider *>(b->getUserPointer());
+void BulletSystem::start() {
+    if(!m_Running) {
+        m_Running = true;
+        m_StepTime = m_FrameStepTime = steady_clock::now();
+        m_Thread = thread(&BulletSystem::run, this);
+    }
+}
 
-            colliderA->setContact(colliderB);
-            colliderB->setContact(colliderA);
+void BulletSystem::stop() {
+    if(m_Running) {
+        m_Running = false;
+        if(m_Thread.joinable()) {
+            m_Thread.join();
+        }
+    }
+}
+/*!
+    \internal
+    The physics thread loop. Simulates all worlds with the fixed step, up to MAX_STEPS steps to catch up after a hitch.
+*/
+void BulletSystem::run() {
+    StepPoint next = steady_clock::now();
+    while(m_Running) {
+        steady_clock::duration interval = duration_cast<steady_clock::duration>(duration<float>(m_Step.load()));
+
+        int32_t steps = 0;
+        while(m_Running && steady_clock::now() >= next && steps < MAX_STEPS) {
+            step();
+            next += interval;
+            steps++;
         }
 
-        for(auto &it : m_ObjectList) {
-            Collider *body = static_cast<Collider *>(it);
-            if(body->world() == nullptr && body->actor()->scene() == scene) {
-                body->setWorld(world);
-            }
+        StepPoint current = steady_clock::now();
+        if(next < current) {
+            // Drop the remaining time instead of falling into the spiral of death
+            next = current;
+        }
+        this_thread::sleep_until(next);
+    }
+}
+/*!
+    \internal
+    Executes a single simulation step for all worlds and collects the contacts. Called by the physics thread.
+*/
+void BulletSystem::step() {
+    PROFILE_FUNCTION();
+
+    unique_lock<recursive_mutex> locker(m_Mutex);
 
-            body->update();
-            body->cleanContacts();
+    float scale = Timer::scale();
+    if(scale > 0.0f) {
+        for(auto &it : m_Worlds) {
+            it.second->stepSimulation(m_Step * scale, 0);
         }
+    }
 
-        world->stepSimulation(Timer::deltaTime(), 4);
+    for(auto it : m_Bodies) {
+        it->swapBuffers();
     }
+
+    for(auto it : m_Colliders) {
+        it->dirtyContacts();
+    }
+
+    for(auto &it : m_Worlds) {
+        updateContacts(it.second);
+    }
+
+    for(auto it : m_Colliders) {
+        it->cleanContacts(m_Contacts);
+    }
+
+    m_StepTime = steady_clock::now();
 }
+/*!
+    \internal
+    Collects the contacts for the \a world from the collision manifolds and the trigger volumes.
+*/
+void BulletSystem::updateContacts(btDynamicsWorld *world) {
+    btDispatcher *dispatcher = world->getDispatcher();
+    for(int i = 0; i < dispatcher->getNumManifolds(); i++) {
+        btPersistentManifold *contact = dispatcher->getManifoldByIndexInternal(i);
+
+        const btCollisionObject *a = static_cast<const btCollisionObject*>(contact->getBody0());
+        const btCollisionObject *b = static_cast<const btCollisionObject*>(contact->getBody1());
+
+        Collider *colliderA = reinterpret_cast<Collider *>(a->getUserPointer());
+        Collider *colliderB = reinterpret_cast<Collider *>(b->getUserPointer());
+
+        colliderA->setContact(colliderB, m_Contacts);
+        colliderB->setContact(colliderA, m_Contacts);
+    }
 
-int BulletSystem::threadPolicy() const {
-    return Pool;
+    btCollisionObjectArray &objects = world->getCollisionObjectArray();
+    for(int i = 0; i < objects.size(); i++) {
+        btGhostObject *ghost = btGhostObject::upcast(objects[i]);
+        if(ghost) {
+            Collider *collider = reinterpret_cast<Collider *>(ghost->getUserPointer());
+            for(int32_t p = 0; p < ghost->getNumOverlappingObjects(); p++) {
+                collider->setContact(reinterpret_cast<Collider *>(ghost->getOverlappingObject(p)->getUserPointer()), m_Contacts);
+            }
+        }
+    }
 }
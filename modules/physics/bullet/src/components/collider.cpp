@@ -1,5 +1,7 @@
 #include "components/collider.h"
 
+#include "bulletsystem.h"
+
 /// \todo Temporary
 #include <components/transform.h>
 #include <components/actor.h>
@@ -39,23 +41,60 @@ void Collider::setWorld(btDynamicsWorld *world) {
 void Collider::createCollider() {
 
 }
+/*!
+    \internal
+    Removes the collision object from the world.
+    The physics thread is guaranteed to be stopped at the moment of call.
+*/
+void Collider::destroyCollider() {
+
+}
+/*!
+    \internal
+    Unregisters the collider from the physics thread and removes the collision object from the world.
+    Must be called from the destructor of each class which implements destroyCollider().
+*/
+void Collider::detachCollider() {
+    if(m_pWorld) {
+        BulletSystem *bullet = dynamic_cast<BulletSystem *>(system());
+        if(bullet) {
+            bullet->detachCollider(this);
+        } else {
+            destroyCollider();
+        }
+        m_pWorld = nullptr;
+    }
+}
 
 void Collider::destroyShape() {
     delete m_pCollisionShape;
     m_pCollisionShape = nullptr;
 }
 
+/*!
+    \internal
+    Returns the mutex which guards the physics world against the physics thread.
+*/
+std::recursive_mutex &Collider::worldMutex() const {
+    BulletSystem *bullet = dynamic_cast<BulletSystem *>(system());
+    if(bullet) {
+        return bullet->worldMutex();
+    }
+    static std::recursive_mutex local;
+    return local;
+}
+
 void Collider::dirtyContacts() {
     for(auto &it : m_Collisions) {
         it.second = true;
     }
 }
 
-void Collider::cleanContacts() {
+void Collider::cleanContacts(ContactQueue &queue) {
     auto it = m_Collisions.begin();
     while(it != m_Collisions.end()) {
         if(it->second == true) {
-            emitSignal(_SIGNAL(exited()));
+            queue.push_back({this, Exited});
             it = m_Collisions.erase(it);
             m_pCollisionObject->activate(true);
         } else {
@@ -64,18 +103,25 @@ void Collider::cleanContacts() {
     }
 }
 
-void Collider::setContact(Collider *other) {
-    bool result = true;
-    for(auto &it : m_Collisions) {
-        if(it.first == other->uuid()) {
-            emitSignal(_SIGNAL(stay()));
-            it.second = false;
-            result = false;
-            break;
-        }
-    }
-    if(result) {
-        emitSignal(_SIGNAL(entered()));
+void Collider::setContact(Collider *other, ContactQueue &queue) {
+    auto it = m_Collisions.find(other->uuid());
+    if(it != m_Collisions.end()) {
+        queue.push_back({this, Stay});
+        it->second = false;
+    } else {
+        queue.push_back({this, Entered});
         m_Collisions[other->uuid()] = false;
     }
 }
+/*!
+    \internal
+    Emits the contact signal for the \a state which was queued by the physics thread.
+*/
+void Collider::emitContact(int32_t state) {
+    switch(state) {
+        case Entered: emitSignal(_SIGNAL(entered())); break;
+        case Stay: emitSignal(_SIGNAL(stay())); break;
+        case Exited: emitSignal(_SIGNAL(exited())); break;
+        default: break;
+    }
+}
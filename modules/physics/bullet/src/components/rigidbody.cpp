@@ -13,17 +13,25 @@ RigidBody::RigidBody() :
         m_Mass(1.0f),
         m_LockPosition(0),
         m_LockRotation(0),
-        m_Kinematic(false) {
+        m_Kinematic(false),
+        m_Settled(false) {
 
     m_pCollisionShape = new btCompoundShape;
+
+    m_Motion.setIdentity();
+    m_Previous.setIdentity();
+    m_Current.setIdentity();
+    m_From.setIdentity();
+    m_To.setIdentity();
 }
 
 RigidBody::~RigidBody() {
-    if(m_pWorld) {
-        m_pWorld->removeRigidBody(static_cast<btRigidBody *>(m_pCollisionObject));
-    }
+    detachCollider();
 }
-
+/*!
+    \internal
+    Called from the main thread while the physics thread is locked.
+*/
 void RigidBody::update() {
     for(auto it : m_Colliders) {
         if(it->isDirty()) {
@@ -48,13 +56,9 @@ void RigidBody::update() {
     }
 
     if(m_pCollisionObject && m_Kinematic) {
-        Transform *t = actor()->transform();
-
-        Quaternion &q = t->worldQuaternion();
-        Vector3 &p = t->worldPosition();
+        syncMotion();
 
-        static_cast<btRigidBody *>(m_pCollisionObject)->setWorldTransform(btTransform(btQuaternion(q.x, q.y, q.z, q.w),
-                                                                                      btVector3(p.x, p.y, p.z)));
+        static_cast<btRigidBody *>(m_pCollisionObject)->setWorldTransform(m_Motion);
     }
 }
 
@@ -63,6 +67,8 @@ float RigidBody::mass() const {
 }
 
 void RigidBody::setMass(float mass) {
+    unique_lock<recursive_mutex> locker(worldMutex());
+
     m_Mass = mass;
     if(m_pCollisionObject) {
         btVector3 localInertia(0, 0, 0);
@@ -82,11 +88,15 @@ void RigidBody::setKinematic(bool kinematic) {
 }
 
 void RigidBody::applyForce(const Vector3 &force, const Vector3 &point) {
+    unique_lock<recursive_mutex> locker(worldMutex());
+
     static_cast<btRigidBody *>(m_pCollisionObject)->applyForce(btVector3(force.x, force.y, force.z),
                                                                btVector3(point.x, point.y, point.z));
 }
 
 void RigidBody::applyImpulse(const Vector3 &impulse, const Vector3 &point) {
+    unique_lock<recursive_mutex> locker(worldMutex());
+
     m_pCollisionObject->activate(true);
     static_cast<btRigidBody *>(m_pCollisionObject)->applyImpulse(btVector3(impulse.x, impulse.y, impulse.z),
                                                                  btVector3(point.x, point.y, point.z));
@@ -97,6 +107,8 @@ int RigidBody::lockPosition() const {
 }
 
 void RigidBody::setLockPosition(int flags) {
+    unique_lock<recursive_mutex> locker(worldMutex());
+
     m_LockPosition = flags;
     if(m_pCollisionObject) {
         btRigidBody *body = static_cast<btRigidBody *>(m_pCollisionObject);
@@ -111,6 +123,8 @@ int RigidBody::lockRotation() const {
 }
 
 void RigidBody::setLockRotation(int flags) {
+    unique_lock<recursive_mutex> locker(worldMutex());
+
     m_LockRotation = flags;
     if(m_pCollisionObject) {
         btRigidBody *body = static_cast<btRigidBody *>(m_pCollisionObject);
@@ -120,32 +134,57 @@ void RigidBody::setLockRotation(int flags) {
     }
 }
 
+/*!
+    \internal
+    Called by the physics thread, returns the last known transform of the body.
+*/
 void RigidBody::getWorldTransform(btTransform &worldTrans) const {
-    Actor *a = actor();
-    if(a) {
-        Transform *t = a->transform();
-        const Quaternion &q = t->worldQuaternion();
-        Vector3 p = t->worldPosition();
-        worldTrans.setRotation(btQuaternion(q.x, q.y, q.z, q.w));
-        worldTrans.setOrigin(btVector3(p.x, p.y, p.z));
+    worldTrans = m_Motion;
+}
+/*!
+    \internal
+    Called by the physics thread, the result will be picked up by the main thread on the next frame.
+*/
+void RigidBody::setWorldTransform(const btTransform &worldTrans) {
+    m_Motion = worldTrans;
+}
+/*!
+    \internal
+    Rotates transform buffers after the simulation step. Called by the physics thread.
+*/
+void RigidBody::swapBuffers() {
+    m_Previous = m_Current;
+    m_Current = m_Motion;
+}
+/*!
+    \internal
+    Copies the two last simulated transforms to be used by the main thread without locking.
+*/
+void RigidBody::publish() {
+    if(!(m_From == m_Previous) || !(m_To == m_Current)) {
+        m_From = m_Previous;
+        m_To = m_Current;
+        m_Settled = false;
     }
 }
+/*!
+    \internal
+    Writes the transform between the two last simulated steps to the Actor.
+    The \a factor 0.0 corresponds to the previous step and 1.0 to the latest one.
+*/
+void RigidBody::interpolate(float factor) {
+    if(m_Settled || m_Kinematic) {
+        return;
+    }
 
-void RigidBody::setWorldTransform(const btTransform &worldTrans) {
     Actor *a = actor();
     if(a) {
         Transform *t = a->transform();
-        btQuaternion q = worldTrans.getRotation();
-
-        Quaternion rot;
-        rot.x = q.getX();
-        rot.y = q.getY();
-        rot.z = q.getZ();
-        rot.w = q.getW();
 
-        t->setQuaternion(rot);
+        btQuaternion q = m_From.getRotation().slerp(m_To.getRotation(), factor);
+        t->setQuaternion(Quaternion(q.getX(), q.getY(), q.getZ(), q.getW()));
 
-        btVector3 p = worldTrans.getOrigin();
+        btVector3 p = m_From.getOrigin().lerp(m_To.getOrigin(), factor);
         Vector3 position(p.x(), p.y(), p.z());
 
         Transform *parent = t->parentTransform();
@@ -155,6 +194,21 @@ void RigidBody::setWorldTransform(const btTransform &worldTrans) {
             t->setPosition(position);
         }
     }
+    m_Settled = (m_From == m_To);
+}
+/*!
+    \internal
+    Reads the current transform of the Actor to be used by the physics thread.
+*/
+void RigidBody::syncMotion() {
+    Actor *a = actor();
+    if(a) {
+        Transform *t = a->transform();
+        const Quaternion &q = t->worldQuaternion();
+        Vector3 p = t->worldPosition();
+        m_Motion.setRotation(btQuaternion(q.x, q.y, q.z, q.w));
+        m_Motion.setOrigin(btVector3(p.x, p.y, p.z));
+    }
 }
 
 void RigidBody::createCollider() {
@@ -179,6 +233,10 @@ void RigidBody::createCollider() {
         }
     }
 
+    syncMotion();
+    m_Previous = m_Current = m_From = m_To = m_Motion;
+    m_Settled = true;
+
     btRigidBody *body = new btRigidBody(m_Mass, this, m_pCollisionShape);
     m_pCollisionObject = body;
 
@@ -199,3 +257,9 @@ void RigidBody::createCollider() {
         m_pWorld->addRigidBody(static_cast<btRigidBody *>(m_pCollisionObject));
     }
 }
+
+void RigidBody::destroyCollider() {
+    if(m_pWorld && m_pCollisionObject) {
+        m_pWorld->removeRigidBody(static_cast<btRigidBody *>(m_pCollisionObject));
+    }
+}
@@ -20,18 +20,7 @@ VolumeCollider::VolumeCollider() :
 }
 
 VolumeCollider::~VolumeCollider() {
-    if(m_pWorld && m_pCollisionObject) {
-        m_pWorld->removeCollisionObject(m_pCollisionObject);
-    }
-}
-
-void VolumeCollider::update() {
-    if(m_pCollisionObject) {
-        btPairCachingGhostObject *ghost = static_cast<btPairCachingGhostObject *>(m_pCollisionObject);
-        for(int32_t i = 0; i < ghost->getOverlappingPairs().size(); i++) {
-            setContact(reinterpret_cast<Collider *>(ghost->getOverlappingPairs().at(i)->getUserPointer()));
-        }
-    }
+    detachCollider();
 }
 
 bool VolumeCollider::trigger() const {
@@ -93,6 +82,12 @@ void VolumeCollider::createCollider() {
         }
     }
 }
+
+void VolumeCollider::destroyCollider() {
+    if(m_pWorld && m_pCollisionObject) {
+        m_pWorld->removeCollisionObject(m_pCollisionObject);
+    }
+}
 /*!
     \internal
 */
@@ -56,7 +56,9 @@ public:
     Texture *texture(const char *name) const override;
 
 protected:
-    void putUniforms(uint32_t program, MaterialInstance *instance);
+    void putUniforms(uint32_t program, MaterialInstance *instance, float extent = -1.0f);
+
+    float screenExtent(const Matrix4 &model, Mesh *mesh) const;
 
 protected:
     Matrix4 m_View;
@@ -67,6 +69,8 @@ protected:
 
     Vector4 m_Color;
 
+    Vector4 m_Viewport;
+
     VariantMap m_Uniforms;
 
     Material::TextureMap m_Textures;
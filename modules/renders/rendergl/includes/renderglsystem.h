@@ -24,6 +24,11 @@ public:
     vector<uint8_t> renderOffscreen(Scene *scene, int width, int height) override;
 #endif
 
+protected:
+    void beginFrame(Pipeline *pipeline) override;
+
+    void endFrame(Pipeline *pipeline) override;
+
 private:
     Engine *m_pEngine;
 };
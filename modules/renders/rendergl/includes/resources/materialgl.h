@@ -29,6 +29,8 @@ class MaterialGL : public Material {
     typedef unordered_map<uint32_t, uint32_t> ObjectMap;
 
 public:
+    ~MaterialGL();
+
     void loadUserData(const VariantMap &data) override;
 
     uint32_t bind(uint32_t layer, uint16_t vertex);
@@ -37,22 +39,52 @@ public:
 
     TextureMap textures() const { return m_Textures; }
 
+    static void warmUp(uint32_t budget);
+
+    static void loadShaderLibrary();
+
 protected:
     void switchState(ResourceState state) override;
 
-    uint32_t buildShader(uint16_t type, const string &src = string());
+    void clearPrograms();
+
+    uint32_t getShader(uint16_t type);
+
+    static uint32_t buildShader(uint16_t type, const string &src = string());
+
+    uint32_t buildProgram(uint16_t vertex, uint16_t fragment);
+
+    static uint32_t loadProgramBinary(const string &path, uint32_t key, uint32_t size);
+
+    static void saveProgramBinary(uint32_t program, const string &path, uint32_t key, uint32_t size);
 
-    uint32_t buildProgram(uint32_t vertex, uint32_t fragment);
+    static string cachePath(uint32_t key);
 
-    bool checkShader(uint32_t shader, const string &path, bool link = false);
+    static bool buildLibraryProgram(uint32_t vertex, uint32_t fragment);
+
+    void setupProgram(uint32_t program);
+
+    bool buildNextVariant();
+
+    static bool checkShader(uint32_t shader, const string &path, bool link = false);
 
     MaterialInstance *createInstance(SurfaceType type = SurfaceType::Static) override;
 
 private:
     ObjectMap m_Programs;
 
+    ObjectMap m_Shaders;
+
     map<uint16_t, string> m_ShaderSources;
 
+    static list<MaterialGL *> s_WarmUp;
+
+    static vector<pair<uint16_t, string>> s_LibraryShaders;
+
+    static list<pair<uint32_t, uint32_t>> s_LibraryPrograms;
+
+    static ObjectMap s_LibraryObjects;
+
 };
 
 #endif // MATERIALGL_H
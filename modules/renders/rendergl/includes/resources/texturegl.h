@@ -13,9 +13,14 @@ class TextureGL : public Texture {
 
 public:
     TextureGL();
+    ~TextureGL();
 
     uint32_t nativeHandle();
 
+    void requestDetail(float extent);
+
+    static void updateStreaming();
+
 private:
     void switchState(ResourceState state) override;
 
@@ -25,10 +30,33 @@ private:
     void destroyTexture();
 
     bool uploadTexture(const Sides *sides, uint32_t imageIndex, uint32_t target, uint32_t internal, uint32_t format, uint32_t type);
+    void uploadRegions(const Sides *sides, const Regions &regions);
+
     bool uploadTextureCubemap(const Sides *sides, uint32_t target, uint32_t internal, uint32_t format, uint32_t type);
 
+    void startStreaming(const Sides *sides);
+    void stopStreaming();
+
+    void uploadLevel(int32_t level);
+    void dropLevels(int32_t level);
+
+    uint32_t levelSize(int32_t level);
+
     uint32_t m_ID;
 
+    uint32_t m_Internal;
+    uint32_t m_Format;
+    uint32_t m_Type;
+
+    int32_t m_Levels;
+    int32_t m_Base;
+    int32_t m_Resident;
+    int32_t m_Requested;
+
+    uint32_t m_UsedFrame;
+
+    bool m_Streamed;
+
 };
 
 #endif // TEXTUREGL_H
@@ -10,6 +10,8 @@
 #include <log.h>
 #include <timer.h>
 
+#include <cfloat>
+
 #define MODEL_UNIFORM   0
 #define VIEW_UNIFORM    1
 #define PROJ_UNIFORM    2
@@ -43,7 +45,12 @@ void CommandBufferGL::clearRenderTarget(bool clearColor, const Vector4 &color, b
     glClear(flags);
 }
 
-void CommandBufferGL::putUniforms(uint32_t program, MaterialInstance *instance) {
+/*!
+    Binds the common uniforms and textures of material \a instance to the shader \a program.
+    Textures which are streamed receive the request for the mip level required for the geometry covering \a extent pixels on the screen.
+    Negative \a extent means that the draw call doesn't affect the streaming.
+*/
+void CommandBufferGL::putUniforms(uint32_t program, MaterialInstance *instance, float extent) {
     int32_t location;
 
     glUniformMatrix4fv(VIEW_UNIFORM, 1, GL_FALSE, m_View.mat);
@@ -105,12 +112,40 @@ void CommandBufferGL::putUniforms(uint32_t program, MaterialInstance *instance)
             if(tex->isCubemap()) {
                 texture = GL_TEXTURE_CUBE_MAP;
             }
-            glBindTexture(texture, static_cast<TextureGL *>(tex)->nativeHandle());
+            TextureGL *t = static_cast<TextureGL *>(tex);
+            glBindTexture(texture, t->nativeHandle());
+            if(extent >= 0.0f) {
+                t->requestDetail(extent);
+            }
         }
         i++;
     }
 }
 
+/*!
+    Returns the size in pixels of the screen area covered by the bound of \a mesh with \a model transform.
+*/
+float CommandBufferGL::screenExtent(const Matrix4 &model, Mesh *mesh) const {
+    Vector3 min, max;
+    (mesh->bound() * model).box(min, max);
+
+    Matrix4 vp = m_Projection * m_View;
+
+    Vector2 low(FLT_MAX);
+    Vector2 high(-FLT_MAX);
+    for(int32_t i = 0; i < 8; i++) {
+        Vector4 p = vp * Vector4((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f);
+        if(p.w <= 0.0f) {
+            return FLT_MAX; // The bound intersects the camera plane
+        }
+        Vector2 ndc(p.x / p.w, p.y / p.w);
+        low = Vector2(MIN(low.x, ndc.x), MIN(low.y, ndc.y));
+        high = Vector2(MAX(high.x, ndc.x), MAX(high.y, ndc.y));
+    }
+
+    return MAX((high.x - low.x) * m_Viewport.z, (high.y - low.y) * m_Viewport.w) * 0.5f;
+}
+
 void CommandBufferGL::drawMesh(const Matrix4 &model, Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance *material) {
     PROFILE_FUNCTION();
     A_UNUSED(sub);
@@ -130,7 +165,11 @@ void CommandBufferGL::drawMesh(const Matrix4 &model, Mesh *mesh, uint32_t sub, u
 
             glUniformMatrix4fv(MODEL_UNIFORM, 1, GL_FALSE, model.mat);
 
-            putUniforms(program, material);
+            float extent = -1.0f;
+            if(layer & (CommandBuffer::DEFAULT | CommandBuffer::TRANSLUCENT | CommandBuffer::UI)) {
+                extent = screenExtent(model, mesh);
+            }
+            putUniforms(program, material, extent);
 
             m->bindVao(this, lod);
 
@@ -180,7 +219,12 @@ void CommandBufferGL::drawMeshInstanced(const Matrix4 *models, uint32_t count, M
             glBindBuffer(GL_ARRAY_BUFFER, m->instance());
             glBufferData(GL_ARRAY_BUFFER, count * sizeof(Matrix4), models, GL_DYNAMIC_DRAW);
 
-            putUniforms(program, material);
+            // Instances may be spread over the whole screen, so the full detail is requested
+            float extent = -1.0f;
+            if(layer & (CommandBuffer::DEFAULT | CommandBuffer::TRANSLUCENT | CommandBuffer::UI)) {
+                extent = FLT_MAX;
+            }
+            putUniforms(program, material, extent);
 
             m->bindVao(this, lod);
 
@@ -245,6 +289,7 @@ void CommandBufferGL::setGlobalTexture(const char *name, Texture *value) {
 
 void CommandBufferGL::setViewport(int32_t x, int32_t y, int32_t width, int32_t height) {
     glViewport(x, y, width, height);
+    m_Viewport = Vector4(x, y, width, height);
     setGlobalValue("camera.screen", Vector4(1.0f / (float)width, 1.0f / (float)height, width, height));
 }
 
@@ -9,6 +9,7 @@
 
 #include "resources/texturegl.h"
 #include "resources/rendertargetgl.h"
+#include "resources/materialgl.h"
 
 #include "commandbuffergl.h"
 
@@ -16,6 +17,8 @@
 
 #define MAX_RESOLUTION 8192
 
+#define WARMUP_BUDGET 2 // milliseconds per frame
+
 void _CheckGLError(const char* file, int line) {
     GLenum err ( glGetError() );
 
@@ -98,6 +101,10 @@ bool RenderGLSystem::init() {
 
     CommandBufferGL::setInited();
 
+    MaterialGL::loadShaderLibrary();
+
+    syncSettings();
+
     return true;
 }
 /*!
@@ -106,16 +113,29 @@ bool RenderGLSystem::init() {
 void RenderGLSystem::update(Scene *scene) {
     PROFILE_FUNCTION();
 
-    Camera *camera = Camera::current();
-    if(camera && CommandBufferGL::isInited()) {
-        int32_t target;
-        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
-
-        Pipeline *pipe = camera->pipeline();
-        static_cast<RenderTargetGL *>(pipe->defaultTarget())->setNativeHandle(target);
+    if(CommandBufferGL::isInited()) {
         RenderSystem::update(scene);
     }
 }
+/*!
+    Binds the default framebuffer of the current context to the \a pipeline.
+*/
+void RenderGLSystem::beginFrame(Pipeline *pipeline) {
+    int32_t target;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+
+    static_cast<RenderTargetGL *>(pipeline->defaultTarget())->setNativeHandle(target);
+}
+/*!
+    Uploads the streamed textures and compiles the pending shaders within the frame budget.
+*/
+void RenderGLSystem::endFrame(Pipeline *pipeline) {
+    A_UNUSED(pipeline);
+
+    TextureGL::updateStreaming();
+
+    MaterialGL::warmUp(WARMUP_BUDGET);
+}
 
 #if defined(NEXT_SHARED)
 #include "editor/rhiwrapper.h"
@@ -6,8 +6,82 @@
 #include "resources/text.h"
 #include "resources/texturegl.h"
 
+#include <systems/resourcesystem.h>
+
 #include <file.h>
 #include <log.h>
+#include <bson.h>
+
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+#define CACHE_DIR "ShaderCache"
+#define CACHE_MAGIC 0x43485354 // TSHC
+#define CACHE_VERSION 1
+
+namespace {
+    const char *SHADER_CACHE("render.shaderCache");
+    const char *SHADER_WARMUP("render.shaderWarmUp");
+
+    const char *SHADER_LIBRARY("ShaderLibrary");
+}
+
+struct ProgramBinaryHeader {
+    uint32_t magic;
+
+    uint32_t version;
+
+    uint32_t driver;
+
+    uint32_t key;
+
+    uint32_t size;
+
+    uint32_t format;
+
+    uint32_t length;
+};
+
+static hash<string> hash_str;
+
+list<MaterialGL *> MaterialGL::s_WarmUp;
+
+vector<pair<uint16_t, string>> MaterialGL::s_LibraryShaders;
+list<pair<uint32_t, uint32_t>> MaterialGL::s_LibraryPrograms;
+MaterialGL::ObjectMap MaterialGL::s_LibraryObjects;
+/*!
+    Returns the hash of the current driver. Binary programs are valid only for the same GPU, vendor and driver version.
+    Returns 0 when the driver doesn't support program binaries.
+*/
+static uint32_t driverHash() {
+    static uint32_t result = 0;
+    static bool checked = false;
+    if(!checked) {
+        checked = true;
+
+        int32_t formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if(formats > 0 && Engine::value(SHADER_CACHE, true).toBool()) {
+            string driver;
+            for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+                const char *str = reinterpret_cast<const char *>(glGetString(name));
+                if(str) {
+                    driver += str;
+                }
+            }
+            result = static_cast<uint32_t>(hash_str(driver));
+            result = MAX(result, 1U);
+
+            Engine::file()->mkdir(CACHE_DIR);
+        }
+    }
+    return result;
+}
+
+MaterialGL::~MaterialGL() {
+    s_WarmUp.remove(this);
+}
 
 void MaterialGL::loadUserData(const VariantMap &data) {
     Material::loadUserData(data);
@@ -54,50 +128,158 @@ void MaterialGL::loadUserData(const VariantMap &data) {
     }
 
     switchState(ToBeUpdated);
-}
 
+    if(Engine::value(SHADER_WARMUP, false).toBool() &&
+       std::find(s_WarmUp.begin(), s_WarmUp.end(), this) == s_WarmUp.end()) {
+        s_WarmUp.push_back(this);
+    }
+}
+/*!
+    Returns the program for the \a type which is a product of the vertex and fragment shader types.
+    Programs are linked on demand only for the requested variants.
+*/
 uint32_t MaterialGL::getProgram(uint16_t type) {
     switch(state()) {
         case Unloading: {
-            for(auto it : m_Programs) {
-                glDeleteProgram(it.second);
-            }
-            m_Programs.clear();
+            clearPrograms();
 
             switchState(ToBeDeleted);
         } break;
         case ToBeUpdated: {
-            for(auto it : m_Programs) {
-                glDeleteProgram(it.second);
-            }
-            m_Programs.clear();
-
-            for(uint16_t v = Static; v < LastVertex; v++) {
-                auto itv = m_ShaderSources.find(v);
-                if(itv != m_ShaderSources.end()) {
-                    for(uint16_t f = Default; f < LastFragment; f++) {
-                        auto itf = m_ShaderSources.find(f);
-                        if(itf != m_ShaderSources.end()) {
-                            uint32_t vertex = buildShader(itv->first, itv->second);
-                            uint32_t fragment = buildShader(itf->first, itf->second);
-                            uint32_t index = v * f;
-                            m_Programs[index] = buildProgram(vertex, fragment);
-                        }
-                    }
-                }
-            }
+            clearPrograms();
 
             switchState(Ready);
         } break;
         default: break;
     }
 
+    if(state() != Ready) {
+        return 0;
+    }
+
     auto it = m_Programs.find(type);
     if(it != m_Programs.end()) {
         return it->second;
     }
+
+    for(uint16_t f = Default; f < LastFragment; f++) {
+        uint16_t v = type / f;
+        if(type % f == 0 && v >= Static && v < LastVertex) {
+            uint32_t program = 0;
+            if(m_ShaderSources.find(v) != m_ShaderSources.end() && m_ShaderSources.find(f) != m_ShaderSources.end()) {
+                program = buildProgram(v, f);
+            }
+            // Failed variants are stored as well to avoid the recompilation on each bind
+            m_Programs[type] = program;
+            return program;
+        }
+    }
     return 0;
 }
+/*!
+    Time-sliced warm up of the materials which were queued during the loading.
+    Links the missing program variants until the \a budget (in milliseconds) is exhausted.
+    \note Must be called from the render thread.
+*/
+void MaterialGL::warmUp(uint32_t budget) {
+    PROFILE_FUNCTION();
+
+    auto start = std::chrono::steady_clock::now();
+    auto expired = [&]() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        return (elapsed.count() >= budget);
+    };
+
+    while(!s_WarmUp.empty()) {
+        MaterialGL *material = s_WarmUp.front();
+        if(!material->buildNextVariant()) {
+            s_WarmUp.pop_front();
+        }
+
+        if(expired()) {
+            return;
+        }
+    }
+
+    while(!s_LibraryPrograms.empty()) {
+        auto it = s_LibraryPrograms.front();
+        s_LibraryPrograms.pop_front();
+
+        bool linked = buildLibraryProgram(it.first, it.second);
+        if(s_LibraryPrograms.empty()) {
+            for(auto shader : s_LibraryObjects) {
+                glDeleteShader(shader.second);
+            }
+            s_LibraryObjects.clear();
+            s_LibraryShaders.clear();
+        }
+
+        if(linked && expired()) {
+            return;
+        }
+    }
+}
+/*!
+    Reads the shader library produced by the asset builder and queues all listed programs for the warm up.
+    Library programs are linked in the background only to fill the program binary cache, so the materials loaded later skip the compilation.
+    \note Must be called from the render thread.
+*/
+void MaterialGL::loadShaderLibrary() {
+    PROFILE_FUNCTION();
+
+    if(!Engine::value(SHADER_WARMUP, false).toBool() || driverHash() == 0) {
+        return;
+    }
+
+    ResourceSystem::DictionaryMap &indices = static_cast<ResourceSystem *>(Engine::resourceSystem())->indices();
+    auto index = indices.find(SHADER_LIBRARY);
+    if(index == indices.end()) {
+        return;
+    }
+
+    File *file = Engine::file();
+    const string &uuid = index->second.second;
+    if(!file->exists(uuid.c_str())) {
+        return;
+    }
+
+    VariantMap library;
+    _FILE *fp = file->fopen(uuid.c_str(), "r");
+    if(fp) {
+        ByteArray data;
+        data.resize(file->fsize(fp));
+        file->fread(&data[0], data.size(), 1, fp);
+        file->fclose(fp);
+
+        library = Bson::load(data).toMap();
+    }
+
+    auto shaders = library.find("Shaders");
+    auto programs = library.find("Programs");
+    if(shaders == library.end() || programs == library.end()) {
+        return;
+    }
+
+    s_LibraryShaders.clear();
+    for(auto &it : shaders->second.toList()) {
+        s_LibraryShaders.push_back(pair<uint16_t, string>(0, it.toString()));
+    }
+
+    for(auto &it : programs->second.toList()) {
+        VariantList program = it.toList();
+        if(program.size() < 5) {
+            continue;
+        }
+        auto field = std::next(program.begin(), 3);
+        uint32_t vertex = field->toInt();
+        uint32_t fragment = (++field)->toInt();
+        if(vertex < s_LibraryShaders.size() && fragment < s_LibraryShaders.size()) {
+            s_LibraryShaders[vertex].first = Static;
+            s_LibraryShaders[fragment].first = Default;
+            s_LibraryPrograms.push_back(pair<uint32_t, uint32_t>(vertex, fragment));
+        }
+    }
+}
 
 void MaterialGL::switchState(ResourceState state) {
     setState(state);
@@ -181,47 +363,258 @@ uint32_t MaterialGL::buildShader(uint16_t type, const string &src) {
     return shader;
 }
 
-uint32_t MaterialGL::buildProgram(uint32_t vertex, uint32_t fragment) {
-    uint32_t result = glCreateProgram();
-    if(result) {
-        glAttachShader(result, vertex);
-        glAttachShader(result, fragment);
-        glLinkProgram(result);
-        glDetachShader(result, vertex);
-        glDetachShader(result, fragment);
-
-        checkShader(result, "", true);
-
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-
-        glUseProgram(result);
-        uint8_t t = 0;
-        for(auto &it : m_Textures) {
-            int32_t location = glGetUniformLocation(result, it.first.c_str());
-            if(location > -1) {
-                glUniform1i(location, t);
+/*!
+    Releases all linked programs and compiled shader objects.
+*/
+void MaterialGL::clearPrograms() {
+    for(auto it : m_Programs) {
+        glDeleteProgram(it.second);
+    }
+    m_Programs.clear();
+
+    for(auto it : m_Shaders) {
+        glDeleteShader(it.second);
+    }
+    m_Shaders.clear();
+}
+/*!
+    Returns the shader object for the \a type. Each source is compiled only once and shared between all variants.
+*/
+uint32_t MaterialGL::getShader(uint16_t type) {
+    auto it = m_Shaders.find(type);
+    if(it != m_Shaders.end()) {
+        return it->second;
+    }
+
+    uint32_t result = 0;
+    auto src = m_ShaderSources.find(type);
+    if(src != m_ShaderSources.end()) {
+        result = buildShader(type, src->second);
+    }
+    m_Shaders[type] = result;
+    return result;
+}
+/*!
+    Links the program for the \a vertex and \a fragment shader types.
+    The program binary cache is checked first, the shaders are compiled from the sources only in case of cache miss.
+*/
+uint32_t MaterialGL::buildProgram(uint16_t vertex, uint16_t fragment) {
+    PROFILE_FUNCTION();
+
+    const string &vertexSource = m_ShaderSources[vertex];
+    const string &fragmentSource = m_ShaderSources[fragment];
+
+    uint32_t size = vertexSource.size() + fragmentSource.size();
+    uint32_t key = static_cast<uint32_t>(hash_str(vertexSource + fragmentSource));
+
+    string path;
+    uint32_t result = 0;
+    if(driverHash()) {
+        path = cachePath(key);
+
+        result = loadProgramBinary(path, key, size);
+    }
+
+    if(result == 0) {
+        uint32_t vs = getShader(vertex);
+        uint32_t fs = getShader(fragment);
+
+        result = glCreateProgram();
+        if(result) {
+            if(!path.empty()) {
+                glProgramParameteri(result, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+
+            glAttachShader(result, vs);
+            glAttachShader(result, fs);
+            glLinkProgram(result);
+            glDetachShader(result, vs);
+            glDetachShader(result, fs);
+
+            if(checkShader(result, "", true) && !path.empty()) {
+                saveProgramBinary(result, path, key, size);
             }
-            t++;
         }
+    }
+
+    if(result) {
+        setupProgram(result);
+    }
+
+    return result;
+}
+/*!
+    Links the library program for the \a vertex and \a fragment source indices and stores its binary in the cache.
+    Shader objects are shared between all library programs.
+    Returns false if the program is already cached and nothing was linked.
+*/
+bool MaterialGL::buildLibraryProgram(uint32_t vertex, uint32_t fragment) {
+    const string &vertexSource = s_LibraryShaders[vertex].second;
+    const string &fragmentSource = s_LibraryShaders[fragment].second;
+
+    uint32_t size = vertexSource.size() + fragmentSource.size();
+    uint32_t key = static_cast<uint32_t>(hash_str(vertexSource + fragmentSource));
+
+    string path = cachePath(key);
+    if(Engine::file()->exists(path.c_str())) {
+        return false;
+    }
+
+    uint32_t shaders[2] = {0, 0};
+    uint32_t indices[2] = {vertex, fragment};
+    for(int i = 0; i < 2; i++) {
+        auto it = s_LibraryObjects.find(indices[i]);
+        if(it == s_LibraryObjects.end()) {
+            const pair<uint16_t, string> &shader = s_LibraryShaders[indices[i]];
+            it = s_LibraryObjects.insert({indices[i], buildShader(shader.first, shader.second)}).first;
+        }
+        shaders[i] = it->second;
+    }
+
+    uint32_t program = glCreateProgram();
+    if(program) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        glAttachShader(program, shaders[0]);
+        glAttachShader(program, shaders[1]);
+        glLinkProgram(program);
+        glDetachShader(program, shaders[0]);
+        glDetachShader(program, shaders[1]);
+
+        if(checkShader(program, "", true)) {
+            saveProgramBinary(program, path, key, size);
+        }
+        glDeleteProgram(program);
+    }
+    return true;
+}
+/*!
+    Returns the path to the program binary cache entry for the \a key.
+*/
+string MaterialGL::cachePath(uint32_t key) {
+    char name[32];
+    sprintf(name, "/%08x.bin", key);
+    return string(CACHE_DIR) + name;
+}
+/*!
+    Creates the program from the binary stored by the \a path.
+    Returns 0 if the cache entry doesn't exist, doesn't match the \a key and \a size of the sources or was rejected by the driver.
+*/
+uint32_t MaterialGL::loadProgramBinary(const string &path, uint32_t key, uint32_t size) {
+    File *file = Engine::file();
+    if(!file->exists(path.c_str())) {
+        return 0;
+    }
 
-        for(auto &it : m_Uniforms) {
-            int32_t location = glGetUniformLocation(result, it.first.c_str());
-            if(location > -1) {
-                switch(it.second.type()) {
-                    case MetaType::VECTOR4: {
-                        glUniform4fv(location, 1, it.second.toVector4().v);
-                    } break;
-                    default: {
-                        glUniform1f(location, it.second.toFloat());
-                    } break;
+    uint32_t result = 0;
+    _FILE *fp = file->fopen(path.c_str(), "r");
+    if(fp) {
+        ProgramBinaryHeader header;
+        if(file->fread(&header, sizeof(header), 1, fp) == 1 &&
+           header.magic == CACHE_MAGIC && header.version == CACHE_VERSION &&
+           header.driver == driverHash() && header.key == key && header.size == size) {
+
+            ByteArray data;
+            data.resize(header.length);
+            if(header.length && file->fread(&data[0], header.length, 1, fp) == 1) {
+                result = glCreateProgram();
+                glProgramBinary(result, header.format, &data[0], header.length);
+
+                int32_t value = 0;
+                glGetProgramiv(result, GL_LINK_STATUS, &value);
+                if(value != GL_TRUE) {
+                    // Driver was updated or the cache is corrupted, fallback to the sources
+                    glDeleteProgram(result);
+                    result = 0;
                 }
             }
         }
+        file->fclose(fp);
     }
-
     return result;
 }
+/*!
+    Stores the binary of the linked \a program by the \a path.
+*/
+void MaterialGL::saveProgramBinary(uint32_t program, const string &path, uint32_t key, uint32_t size) {
+    int32_t length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) {
+        return;
+    }
+
+    ByteArray data;
+    data.resize(length);
+
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, &data[0]);
+
+    ProgramBinaryHeader header = {CACHE_MAGIC, CACHE_VERSION, driverHash(), key, size, format, static_cast<uint32_t>(length)};
+
+    File *file = Engine::file();
+    _FILE *fp = file->fopen(path.c_str(), "w");
+    if(fp) {
+        file->fwrite(&header, sizeof(header), 1, fp);
+        file->fwrite(&data[0], data.size(), 1, fp);
+        file->fclose(fp);
+    }
+}
+/*!
+    Binds texture units and default uniform values for the linked \a program.
+*/
+void MaterialGL::setupProgram(uint32_t program) {
+    glUseProgram(program);
+    uint8_t t = 0;
+    for(auto &it : m_Textures) {
+        int32_t location = glGetUniformLocation(program, it.first.c_str());
+        if(location > -1) {
+            glUniform1i(location, t);
+        }
+        t++;
+    }
+
+    for(auto &it : m_Uniforms) {
+        int32_t location = glGetUniformLocation(program, it.first.c_str());
+        if(location > -1) {
+            switch(it.second.type()) {
+                case MetaType::VECTOR4: {
+                    glUniform4fv(location, 1, it.second.toVector4().v);
+                } break;
+                default: {
+                    glUniform1f(location, it.second.toFloat());
+                } break;
+            }
+        }
+    }
+}
+/*!
+    Links the next missing program variant.
+    Returns false when all variants are linked and there is nothing to do.
+*/
+bool MaterialGL::buildNextVariant() {
+    for(uint16_t v = Static; v < LastVertex; v++) {
+        if(m_ShaderSources.find(v) == m_ShaderSources.end()) {
+            continue;
+        }
+        for(uint16_t f = Default; f < LastFragment; f++) {
+            if(m_ShaderSources.find(f) == m_ShaderSources.end()) {
+                continue;
+            }
+            if(m_Programs.find(v * f) == m_Programs.end()) {
+                getProgram(v * f);
+                return (state() == Ready);
+            }
+        }
+    }
+
+    // All variants are linked, shader objects are not needed anymore
+    for(auto it : m_Shaders) {
+        glDeleteShader(it.second);
+    }
+    m_Shaders.clear();
+
+    return false;
+}
 
 bool MaterialGL::checkShader(uint32_t shader, const string &path, bool link) {
     int value   = 0;
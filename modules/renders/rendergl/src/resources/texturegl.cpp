@@ -1,16 +1,66 @@
 #include "resources/texturegl.h"
 
 #include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <mutex>
+
+#include <engine.h>
 
 #include "agl.h"
 
 #define DATA    "Data"
 
+#define STREAM_BASE_SIZE    64
+#define MEGABYTE            (1024 * 1024)
+
+namespace {
+    const char *TEXTURE_STREAMING("render.textureStreaming");
+    const char *TEXTURE_BUDGET("render.textureBudget");
+    const char *TEXTURE_UPLOAD("render.textureUploadLimit");
+
+    list<TextureGL *> s_Streamed;
+    // The textures can be destroyed by the main thread while the render thread updates the streaming
+    mutex s_StreamedMutex;
+
+    uint32_t s_Frame = 0;
+
+    uint32_t s_Buffer = 0;
+}
+
+/*!
+    \class TextureGL
+    \brief OpenGL implementation of the Texture resource.
+    \internal
+
+    Mipmapped 2D textures are streamed: at first only the mip levels which are not bigger than STREAM_BASE_SIZE are uploaded.
+    Each draw call reports the screen size of the geometry which uses the texture, more detailed levels are uploaded
+    one by one through a pixel buffer object with respect to the per frame upload limit ("render.textureUploadLimit", megabytes).
+    When the video memory budget ("render.textureBudget", megabytes) is exceeded the detailed levels of the least recently used textures are dropped.
+    The streaming can be disabled with "render.textureStreaming" setting.
+*/
+
 TextureGL::TextureGL() :
-        m_ID(0) {
+        m_ID(0),
+        m_Internal(0),
+        m_Format(0),
+        m_Type(0),
+        m_Levels(0),
+        m_Base(0),
+        m_Resident(0),
+        m_Requested(0),
+        m_UsedFrame(0),
+        m_Streamed(false) {
 
 }
 
+TextureGL::~TextureGL() {
+    unique_lock<mutex> locker(s_StreamedMutex);
+    if(m_Streamed) {
+        s_Streamed.remove(this);
+    }
+}
+
 uint32_t TextureGL::nativeHandle() {
     switch(state()) {
         case Unloading: {
@@ -26,6 +76,98 @@ uint32_t TextureGL::nativeHandle() {
 
     return m_ID;
 }
+/*!
+    Requests the mip level which provides enough texels for the geometry covering \a extent pixels on the screen.
+    Must be called after nativeHandle() for each draw call which uses the texture.
+*/
+void TextureGL::requestDetail(float extent) {
+    if(!m_Streamed) {
+        return;
+    }
+
+    float texels = MAX(width(), height());
+    int32_t level = 0;
+    if(extent < texels) {
+        level = (extent > 1.0f) ? static_cast<int32_t>(log2f(texels / extent)) : m_Levels - 1;
+    }
+    level = CLAMP(level, 0, m_Levels - 1);
+
+    m_Requested = (m_UsedFrame == s_Frame) ? MIN(m_Requested, level) : level;
+    m_UsedFrame = s_Frame;
+}
+/*!
+    Uploads the requested mip levels and drops the unused ones according to the video memory budget.
+    Must be called once per frame after all draw calls.
+*/
+void TextureGL::updateStreaming() {
+    PROFILE_FUNCTION();
+
+    uint32_t frame = s_Frame;
+    s_Frame++;
+
+    unique_lock<mutex> locker(s_StreamedMutex);
+    if(s_Streamed.empty()) {
+        return;
+    }
+
+    uint64_t budget = static_cast<uint64_t>(Engine::value(TEXTURE_BUDGET, 512).toInt()) * MEGABYTE;
+    int64_t upload = static_cast<int64_t>(Engine::value(TEXTURE_UPLOAD, 4).toInt()) * MEGABYTE;
+
+    // Most recently used textures are served first and dropped last
+    vector<TextureGL *> textures(s_Streamed.begin(), s_Streamed.end());
+    std::stable_sort(textures.begin(), textures.end(), [](const TextureGL *left, const TextureGL *right) {
+        return left->m_UsedFrame > right->m_UsedFrame;
+    });
+
+    uint64_t total = 0;
+    for(auto it : textures) {
+        for(int32_t i = it->m_Resident; i < it->m_Levels; i++) {
+            total += it->levelSize(i);
+        }
+    }
+
+    for(auto it = textures.rbegin(); it != textures.rend() && total > budget; ++it) {
+        TextureGL *texture = *it;
+        int32_t level = texture->m_Resident;
+        while(level < texture->m_Base && total > budget) {
+            total -= texture->levelSize(level);
+            level++;
+        }
+        if(level != texture->m_Resident) {
+            texture->dropLevels(level);
+        }
+    }
+
+    bool first = true;
+    for(auto it : textures) {
+        if(it->m_UsedFrame != frame) {
+            break;
+        }
+        if(it->state() != Ready) {
+            continue;
+        }
+        while(it->m_Resident > it->m_Requested && upload > 0) {
+            uint32_t bytes = it->levelSize(it->m_Resident - 1);
+            // At least one level per frame is uploaded even if it's bigger than the limit
+            if((bytes > upload && !first) || total + bytes > budget) {
+                break;
+            }
+            it->uploadLevel(it->m_Resident - 1);
+            it->m_Resident--;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, it->m_Resident);
+
+            total += bytes;
+            upload -= bytes;
+            first = false;
+        }
+        if(upload <= 0) {
+            break;
+        }
+    }
+    if(!first) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
 
 void TextureGL::switchState(ResourceState state) {
     setState(state);
@@ -55,6 +197,16 @@ void TextureGL::updateTexture() {
 
     Texture::Sides *sides = getSides();
 
+    Texture::Regions &regions = dirtyRegions();
+    if(!regions.empty()) {
+        if(target == GL_TEXTURE_2D && !isCompressed() && !sides->empty() && !m_Streamed) {
+            uploadRegions(sides, regions);
+            regions.clear();
+            return;
+        }
+        regions.clear();
+    }
+
     bool mipmap = (sides->empty()) ? false : (sides->at(0).size() > 1);
 
     int32_t min = (mipmap) ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST;
@@ -124,12 +276,33 @@ void TextureGL::updateTexture() {
         default: break;
     }
 
+    if(isCompressed()) {
+        switch(compress()) {
+    #ifndef THUNDER_MOBILE
+            case DXT1: internal = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+            case DXT5: internal = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+    #endif
+            case ETC2: internal = GL_COMPRESSED_RGBA8_ETC2_EAC; break;
+            default: break;
+        }
+    }
+
+    m_Internal = internal;
+    m_Format = glformat;
+    m_Type = type;
+
+    stopStreaming();
+
     switch(target) {
         case GL_TEXTURE_CUBE_MAP: {
             uploadTextureCubemap(sides, target, internal, glformat, type);
         } break;
         default: {
-            uploadTexture(sides, 0, target, internal, glformat, type);
+            if(mipmap && Engine::value(TEXTURE_STREAMING, true).toBool()) {
+                startStreaming(sides);
+            } else {
+                uploadTexture(sides, 0, target, internal, glformat, type);
+            }
         } break;
     }
 
@@ -141,6 +314,12 @@ void TextureGL::updateTexture() {
 }
 
 void TextureGL::destroyTexture() {
+    if(m_Streamed) {
+        unique_lock<mutex> locker(s_StreamedMutex);
+        s_Streamed.remove(this);
+        m_Streamed = false;
+    }
+
     if(m_ID) {
         glDeleteTextures(1, &m_ID);
         CheckGLError();
@@ -188,6 +367,39 @@ bool TextureGL::uploadTexture(const Sides *sides, uint32_t imageIndex, uint32_t
     return true;
 }
 
+void TextureGL::uploadRegions(const Sides *sides, const Regions &regions) {
+    uint32_t glformat = GL_RGBA;
+    uint32_t type = GL_UNSIGNED_BYTE;
+
+    switch(format()) {
+        case R8: glformat = GL_RED; break;
+        case RGB8: glformat = GL_RGB; break;
+        case RGB16Float:
+        case R11G11B10Float: {
+            glformat = GL_RGB;
+            type = GL_FLOAT;
+        } break;
+        case RGBA32Float: type = GL_FLOAT; break;
+        default: break;
+    }
+
+    GLint alignment = -1;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width());
+
+    const int8_t *data = &(sides->at(0)[0])[0];
+    int32_t pixel = size(1, 1);
+    for(auto &it : regions) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, it.x, it.y, it.width, it.height, glformat, type,
+                        &data[(it.y * width() + it.x) * pixel]);
+        CheckGLError();
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+}
+
 bool TextureGL::uploadTextureCubemap(const Sides *sides, uint32_t target, uint32_t internal, uint32_t format, uint32_t type) {
     // loop through cubemap faces and load them as 2D textures
     for(uint32_t n = 0; n < 6; n++) {
@@ -199,3 +411,115 @@ bool TextureGL::uploadTextureCubemap(const Sides *sides, uint32_t target, uint32
     }
     return true;
 }
+
+/*!
+    Uploads only the low detail mip levels of the bound 2D texture, the rest levels will be uploaded on demand.
+*/
+void TextureGL::startStreaming(const Sides *sides) {
+    m_Levels = sides->at(0).size();
+    m_Base = m_Levels - 1;
+    for(int32_t i = 0; i < m_Levels; i++) {
+        if(MAX(width() >> i, height() >> i) <= STREAM_BASE_SIZE) {
+            m_Base = i;
+            break;
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_Base);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1);
+
+    for(int32_t i = m_Base; i < m_Levels; i++) {
+        uploadLevel(i);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_ID);
+
+    m_Resident = m_Base;
+    m_Requested = m_Base;
+    m_UsedFrame = s_Frame;
+
+    unique_lock<mutex> locker(s_StreamedMutex);
+    m_Streamed = true;
+    s_Streamed.push_back(this);
+}
+/*!
+    Restores the full mip chain parameters for the bound texture which is not streamed anymore.
+*/
+void TextureGL::stopStreaming() {
+    if(m_Streamed) {
+        {
+            unique_lock<mutex> locker(s_StreamedMutex);
+            s_Streamed.remove(this);
+            m_Streamed = false;
+        }
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+    }
+}
+/*!
+    Uploads the mip \a level through the shared pixel buffer object.
+    The texture stays bound after the call.
+*/
+void TextureGL::uploadLevel(int32_t level) {
+    const ByteArray &data = getSides()->at(0)[level];
+    int32_t w = width() >> level;
+    int32_t h = height() >> level;
+
+    if(s_Buffer == 0) {
+        glGenBuffers(1, &s_Buffer);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_ID);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_Buffer);
+    // Orphan the previous storage to not wait for the pending transfer
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, data.size(), nullptr, GL_STREAM_DRAW);
+    void *ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, data.size(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(ptr) {
+        memcpy(ptr, &data[0], data.size());
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        if(isCompressed()) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, m_Internal, w, h, 0, data.size(), nullptr);
+        } else {
+            GLint alignment = -1;
+            if(!isDwordAligned()) {
+                glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            }
+            glTexImage2D(GL_TEXTURE_2D, level, m_Internal, w, h, 0, m_Format, m_Type, nullptr);
+            if(alignment != -1) {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+            }
+        }
+        CheckGLError();
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+/*!
+    Releases the video memory of all resident mip levels which are more detailed than \a level.
+*/
+void TextureGL::dropLevels(int32_t level) {
+    glBindTexture(GL_TEXTURE_2D, m_ID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    for(int32_t i = m_Resident; i < level; i++) {
+        if(isCompressed()) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, m_Internal, 0, 0, 0, 0, nullptr);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, i, m_Internal, 0, 0, 0, m_Format, m_Type, nullptr);
+        }
+    }
+    CheckGLError();
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_Resident = level;
+}
+/*!
+    Returns the size of mip \a level in bytes.
+*/
+uint32_t TextureGL::levelSize(int32_t level) {
+    Sides *sides = getSides();
+    if(sides->empty() || level >= static_cast<int32_t>(sides->at(0).size())) {
+        return 0;
+    }
+    return sides->at(0)[level].size();
+}
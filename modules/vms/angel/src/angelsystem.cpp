@@ -3,6 +3,7 @@
 #include <assert.h>
 
 #include <log.h>
+#include <componentregistry.h>
 
 #include <angelscript.h>
 
@@ -65,6 +66,9 @@ AngelSystem::AngelSystem(Engine *engine) :
     AngelBehaviour::registerClassFactory(this);
 
     AngelScript::registerClassFactory(engine->resourceSystem());
+
+    // Scripts have access to any component of the scene
+    addWrite<Component>();
 }
 
 AngelSystem::~AngelSystem() {
@@ -113,17 +117,20 @@ void AngelSystem::update(Scene *scene) {
     PROFILE_FUNCTION();
 
     if(Engine::isGameMode()) {
-        for(auto it : m_ObjectList) {
-            AngelBehaviour *component = static_cast<AngelBehaviour *>(it);
-            asIScriptObject *object = component->scriptObject();
-            if(component->isEnabled() && component->actor() && component->actor()->scene() == scene) {
+        ComponentRegistry::Pool &pool = ComponentRegistry::pool<AngelBehaviour>();
+        for(uint32_t i = 0; i < pool.size(); i++) {
+            if(pool.isEnabled(i) && pool.scene(i) == scene) {
+                AngelBehaviour *component = static_cast<AngelBehaviour *>(pool.at(i));
+                asIScriptObject *object = component->scriptObject();
                 if(!component->isStarted()) {
                     execute(object, component->scriptStart());
                     component->setStarted(true);
                 }
                 execute(object, component->scriptUpdate());
+                if(object) {
+                    object->Release();
+                }
             }
-            object->Release();
         }
     }
 }
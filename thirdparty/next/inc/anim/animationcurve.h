@@ -30,9 +30,12 @@ public:
     typedef vector<KeyFrame> Keys;
 
     float value(float pos);
+    float value(float pos, uint32_t &cursor) const;
 
     void frames(int32_t &b, int32_t &e, float pos);
 
+    uint32_t find(float pos, uint32_t hint) const;
+
     Keys m_Keys;
 };
 
@@ -5,7 +5,11 @@
 
 #include <global.h>
 
+#include "memorypool.h"
+
 class NEXT_LIBRARY_EXPORT Event {
+    A_POOLED()
+
 public:
     enum Type {
         Invalid                 = 0,
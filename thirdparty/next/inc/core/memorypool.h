@@ -0,0 +1,35 @@
+#ifndef MEMORYPOOL_H
+#define MEMORYPOOL_H
+
+#include <cstddef>
+#include <stdint.h>
+
+#include <global.h>
+
+#define A_POOLED() \
+public: \
+    static void *operator new(size_t size) { \
+        return MemoryPool::allocate(size); \
+    } \
+    static void operator delete(void *pointer, size_t size) { \
+        MemoryPool::deallocate(pointer, size); \
+    } \
+    static void *operator new(size_t, void *where) { \
+        return where; \
+    } \
+    static void operator delete(void *, void *) { \
+    }
+
+class NEXT_LIBRARY_EXPORT MemoryPool {
+public:
+    static void                *allocate                    (size_t size);
+
+    static void                 deallocate                  (void *pointer, size_t size);
+
+    static size_t               reservedSize                ();
+
+    static size_t               usedSize                    ();
+
+};
+
+#endif // MEMORYPOOL_H
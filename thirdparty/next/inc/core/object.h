@@ -32,6 +32,7 @@
 
 #include "metaobject.h"
 #include "event.h"
+#include "memorypool.h"
 
 #ifndef Q_QDOC
 #define A_REGISTER(Class, Super, Group) \
@@ -75,6 +76,9 @@ class NEXT_LIBRARY_EXPORT Object {
     A_METHODS(
         A_SIGNAL(Object::destroyed)
     )
+
+    A_POOLED()
+
 public:
     struct Link {
         Link();
@@ -213,6 +217,7 @@ protected:
 private:
     friend class ObjectTest;
     friend class ThreadPoolPrivate;
+    friend class ObjectPrivate;
     friend class ObjectSystem;
 
 private:
@@ -6,6 +6,7 @@
 #include <string>
 #include <memory>
 #include <thread>
+#include <mutex>
 
 #include "object.h"
 
@@ -52,6 +53,11 @@ public:
     static Variant                      toVariant               (const Object *object, bool force = false);
     static Object                      *toObject                (const Variant &variant, Object *root = nullptr);
 
+    static ByteArray                    toBinary                (const Variant &variant);
+    static Variant                      fromBinary              (const ByteArray &data);
+    static Object                      *binaryToObject          (const ByteArray &data, Object *root = nullptr);
+    static bool                         isBinary                (const ByteArray &data);
+
     static uint32_t                     generateUUID            ();
 
     static void                         replaceUUID             (Object *object, uint32_t uuid);
@@ -84,6 +90,7 @@ protected:
 
     Object                             *m_SuspendObject;
 
+    recursive_mutex                     m_Mutex;
 
     thread::id                          m_threadId;
 
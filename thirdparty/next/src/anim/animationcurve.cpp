@@ -1,5 +1,7 @@
 #include "anim/animationcurve.h"
 
+#include <algorithm>
+
 AnimationCurve::KeyFrame::KeyFrame() :
     m_Type(Cubic),
     m_Position(0.0f),
@@ -15,23 +17,28 @@ bool AnimationCurve::KeyFrame::operator ==(const KeyFrame &left) {
 }
 
 float AnimationCurve::value(float pos) {
+    uint32_t cursor = 0;
+    return value(pos, cursor);
+}
+/*!
+    Returns the curve value at \a pos.
+    The \a cursor contains the index of the key used in the previous evaluation and will be updated with the new one.
+    In case of playback in the forward direction the required key will be found in constant time.
+*/
+float AnimationCurve::value(float pos, uint32_t &cursor) const {
     float result = (m_Keys.empty()) ? 0.0f : m_Keys.front().m_Value;
     if(m_Keys.size() >= 2) {
-        AnimationCurve::KeyFrame a;
-        AnimationCurve::KeyFrame b;
+        uint32_t index = find(pos, cursor);
+        cursor = index;
 
-        for(auto i = m_Keys.begin(); i != m_Keys.end(); i++) {
-            if(pos == i->m_Position) {
-                return i->m_Value;
-            }
-            if(pos >= i->m_Position) {
-                a = (*i);
-            }
-            if(pos <= i->m_Position) {
-                b = (*i);
-                break;
-            }
+        const AnimationCurve::KeyFrame &a = m_Keys[index];
+        if(pos <= a.m_Position) {
+            return a.m_Value;
+        }
+        if(index + 1 >= m_Keys.size()) {
+            return a.m_Value;
         }
+        const AnimationCurve::KeyFrame &b = m_Keys[index + 1];
 
         float factor = (pos - a.m_Position) / (b.m_Position - a.m_Position);
         switch(a.m_Type) {
@@ -52,18 +59,47 @@ float AnimationCurve::value(float pos) {
 void AnimationCurve::frames(int32_t &b, int32_t &e, float pos) {
     b = e = -1;
     if(m_Keys.size() >= 2) {
-        for(uint32_t i = 0; i < m_Keys.size(); i++) {
-            if(pos == m_Keys[i].m_Position) {
-                b = e = i;
-                return;
-            }
-            if(pos >= m_Keys[i].m_Position) {
-                b = i;
-            }
-            if(pos <= m_Keys[i].m_Position) {
-                e = i;
-                break;
+        uint32_t index = find(pos, 0);
+        if(pos < m_Keys[index].m_Position) {
+            // Before the first key only the end key is valid
+            e = index;
+            return;
+        }
+        if(pos == m_Keys[index].m_Position) {
+            while(index > 0 && m_Keys[index - 1].m_Position == pos) {
+                index--;
             }
+            b = e = index;
+            return;
+        }
+        if(index + 1 < m_Keys.size()) {
+            b = index;
+            e = index + 1;
+        } else {
+            b = index;
+        }
+    }
+}
+/*!
+    Returns the index of the last key with position less than or equal to \a pos.
+    The \a hint is checked first, in case of miss the binary search will be used.
+*/
+uint32_t AnimationCurve::find(float pos, uint32_t hint) const {
+    uint32_t size = m_Keys.size();
+    if(hint < size && m_Keys[hint].m_Position <= pos) {
+        if(hint + 1 >= size || pos < m_Keys[hint + 1].m_Position) {
+            return hint;
+        }
+        if(hint + 2 >= size || pos < m_Keys[hint + 2].m_Position) {
+            return hint + 1;
         }
     }
+
+    auto it = std::upper_bound(m_Keys.begin(), m_Keys.end(), pos, [](float p, const KeyFrame &key) {
+        return p < key.m_Position;
+    });
+    if(it == m_Keys.begin()) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::distance(m_Keys.begin(), it) - 1);
 }
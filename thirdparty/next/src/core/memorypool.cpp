@@ -0,0 +1,143 @@
+#include "core/memorypool.h"
+
+#include <new>
+#include <mutex>
+#include <atomic>
+
+#define GRANULARITY 16
+#define MAX_SIZE    1024
+#define CHUNK_SIZE  16384
+
+using namespace std;
+
+namespace {
+    struct FreeNode {
+        FreeNode *next;
+    };
+
+    struct SizeClass {
+        SizeClass() :
+            m_pFree(nullptr) {
+
+        }
+
+        mutex m_Mutex;
+
+        FreeNode *m_pFree;
+    };
+
+    struct PoolData {
+        PoolData() :
+            m_Reserved(0),
+            m_Used(0) {
+
+        }
+
+        SizeClass m_Classes[MAX_SIZE / GRANULARITY];
+
+        atomic<size_t> m_Reserved;
+
+        atomic<size_t> m_Used;
+    };
+
+    // Never destroyed, objects can be released after the static objects on the application exit
+    PoolData &pool() {
+        static PoolData *data = new PoolData;
+        return *data;
+    }
+}
+
+/*!
+    \class MemoryPool
+    \brief The MemoryPool class provides the fast allocation of the small objects.
+    \since Next 1.0
+    \inmodule Core
+
+    Allocations are grouped by size classes with 16 bytes step up to 1024 bytes.
+    Each size class keeps the list of released blocks and reuses them for the next allocations of the same size,
+    new memory is requested from the system by chunks, so spawning and destroying the objects don't touch the heap
+    after the warm up. Bigger allocations are forwarded to the global allocator.
+
+    The memory of the size classes is never returned to the system.
+
+    Classes can use the pool by adding A_POOLED() macro to the declaration; Object and Event are allocated in the pool
+    by default, so all the objects created by ObjectSystem and all the posted events go through it.
+
+    \note All methods are thread safe.
+*/
+/*!
+    \macro A_POOLED()
+    \relates MemoryPool
+
+    Declares the class specific new and delete operators which allocate the instances in the MemoryPool.
+*/
+/*!
+    Returns a pointer to the memory block with at least \a size bytes.
+*/
+void *MemoryPool::allocate(size_t size) {
+    if(size == 0 || size > MAX_SIZE) {
+        return ::operator new(size);
+    }
+
+    PoolData &data = pool();
+    size_t index = (size - 1) / GRANULARITY;
+    SizeClass &sizeClass = data.m_Classes[index];
+
+    data.m_Used += (index + 1) * GRANULARITY;
+
+    lock_guard<mutex> locker(sizeClass.m_Mutex);
+    if(sizeClass.m_pFree == nullptr) {
+        size_t block = (index + 1) * GRANULARITY;
+        size_t count = CHUNK_SIZE / block;
+        count = (count < 16) ? 16 : count;
+
+        uint8_t *chunk = static_cast<uint8_t *>(::operator new(block * count));
+        data.m_Reserved += block * count;
+
+        for(size_t i = 0; i < count; i++) {
+            FreeNode *node = reinterpret_cast<FreeNode *>(chunk + block * i);
+            node->next = sizeClass.m_pFree;
+            sizeClass.m_pFree = node;
+        }
+    }
+
+    FreeNode *result = sizeClass.m_pFree;
+    sizeClass.m_pFree = result->next;
+    return result;
+}
+/*!
+    Releases the memory block at \a pointer which was allocated with \a size bytes.
+*/
+void MemoryPool::deallocate(void *pointer, size_t size) {
+    if(pointer == nullptr) {
+        return;
+    }
+    if(size == 0 || size > MAX_SIZE) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    PoolData &data = pool();
+    size_t index = (size - 1) / GRANULARITY;
+    SizeClass &sizeClass = data.m_Classes[index];
+
+    data.m_Used -= (index + 1) * GRANULARITY;
+
+    FreeNode *node = static_cast<FreeNode *>(pointer);
+
+    lock_guard<mutex> locker(sizeClass.m_Mutex);
+    node->next = sizeClass.m_pFree;
+    sizeClass.m_pFree = node;
+}
+/*!
+    Returns the number of bytes requested by the pool from the system.
+*/
+size_t MemoryPool::reservedSize() {
+    return pool().m_Reserved;
+}
+/*!
+    Returns the number of bytes currently allocated from the pool.
+*/
+size_t MemoryPool::usedSize() {
+    return pool().m_Used;
+}
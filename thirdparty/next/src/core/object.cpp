@@ -2,6 +2,9 @@
 #include "core/uri.h"
 
 #include <mutex>
+#include <unordered_map>
+
+#define WIDE_NODE       16
 
 /*!
     \module Core
@@ -41,14 +44,98 @@ Object::Link::Link() :
 }
 
 class ObjectPrivate {
+    A_POOLED()
+
 public:
     ObjectPrivate() :
         m_pParent(nullptr),
         m_pCurrentSender(nullptr),
         m_pSystem(nullptr),
         m_UUID(0),
-        m_Cloned(0) {
+        m_Cloned(0),
+        m_NameHash(hashName("", 0)),
+        m_pChildIndex(nullptr) {
+
+    }
+
+    ~ObjectPrivate() {
+        delete m_pChildIndex;
+    }
+    /*!
+        Returns FNV-1a hash of the \a size symbols of the name starting from \a data.
+    */
+    static size_t hashName(const char *data, size_t size) {
+        uint64_t result = 14695981039346656037ULL;
+        for(size_t i = 0; i < size; i++) {
+            result ^= static_cast<uint8_t>(data[i]);
+            result *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(result);
+    }
+
+    bool isNamed(size_t hash, const string &path, size_t start, size_t size) const {
+        return m_NameHash == hash && m_sName.size() == size && m_sName.compare(0, size, path, start, size) == 0;
+    }
+
+    void invalidateIndex() {
+        lock_guard<mutex> locker(m_Mutex);
+        delete m_pChildIndex;
+        m_pChildIndex = nullptr;
+    }
+    /*!
+        Returns the children with the name \a hash in the order of the children list.
+        The index is built only for the wide nodes; returns nullptr for the small ones.
+        Lookups may run on several threads, so the index is built under the object mutex.
+    */
+    const Object::ObjectList *indexedChildren(size_t hash) {
+        if(m_mChildren.size() < WIDE_NODE) {
+            return nullptr;
+        }
+        lock_guard<mutex> locker(m_Mutex);
+        if(m_pChildIndex == nullptr) {
+            m_pChildIndex = new ChildIndex;
+            for(auto it : m_mChildren) {
+                (*m_pChildIndex)[it->p_ptr->m_NameHash].push_back(it);
+            }
+        }
+        static const Object::ObjectList empty;
+        auto it = m_pChildIndex->find(hash);
+        return (it != m_pChildIndex->end()) ? &(it->second) : &empty;
+    }
+    /*!
+        Resolves the \a path starting from \a start position relative to the \a object.
+    */
+    static Object *resolve(Object *object, const string &path, size_t start) {
+        ObjectPrivate *ptr = object->p_ptr;
+
+        size_t index = path.find('/', start);
+        size_t size = (index == string::npos) ? path.size() - start : index - start;
+        size_t hash = hashName(path.data() + start, size);
+
+        if(ptr->isNamed(hash, path, start, size) && index != string::npos) {
+            start = index + 1;
+            index = path.find('/', start);
+            size = (index == string::npos) ? path.size() - start : index - start;
+            hash = hashName(path.data() + start, size);
+        }
 
+        const Object::ObjectList *children = ptr->indexedChildren(hash);
+        if(children == nullptr) {
+            children = &ptr->m_mChildren;
+        }
+        for(auto it : *children) {
+            if(it->p_ptr->isNamed(hash, path, start, size)) {
+                if(index != string::npos) {
+                    Object *o = resolve(it, path, index + 1);
+                    if(o) {
+                        return o;
+                    }
+                } else {
+                    return it;
+                }
+            }
+        }
+        return nullptr;
     }
 
     bool isLinkExist(const Object::Link &link) const {
@@ -88,6 +175,11 @@ public:
 
     uint32_t m_UUID;
     uint32_t m_Cloned;
+
+    size_t m_NameHash;
+
+    typedef unordered_map<size_t, Object::ObjectList> ChildIndex;
+    ChildIndex *m_pChildIndex;
 };
 
 
@@ -401,7 +493,11 @@ Object *Object::clone(Object *parent) {
     ObjectList list;
     ObjectPrivate::enumObjects(this, list);
 
-    std::list<pair<Object *, Object *>> array;
+    vector<pair<Object *, Object *>> array;
+    array.reserve(list.size());
+
+    unordered_map<const Object *, Object *> clones;
+    clones.reserve(list.size());
 
     for(auto it : list) {
         const MetaObject *meta = it->metaObject();
@@ -413,41 +509,42 @@ Object *Object::clone(Object *parent) {
             result->p_ptr->m_Cloned = it->p_ptr->m_UUID;
         }
 
+        // Parents are always enumerated before their children
         Object *p = parent;
-        for(auto item : array) {
-            uint32_t uuid = (it->parent()->clonedFrom() != 0) ? it->parent()->clonedFrom() : it->parent()->uuid();
-            if(item.second->clonedFrom() == uuid) {
-                p = item.second;
-                break;
-            }
+        auto clone = clones.find(it->parent());
+        if(clone != clones.end()) {
+            p = clone->second;
         }
-        result->setParent(p);
         result->setSystem(it->p_ptr->m_pSystem);
+        result->setParent(p);
         result->setName(it->name());
 
+        clones[it] = result;
         array.push_back(pair<Object *, Object *>(it, result));
     }
 
-    for(auto it : array) {
+    for(auto &it : array) {
         const MetaObject *meta = it.first->metaObject();
+        const MetaObject *target = it.second->metaObject();
 
         for(int i = 0; i < meta->propertyCount(); i++) {
             MetaProperty rp = meta->property(i);
-            MetaProperty lp = it.second->metaObject()->property(i);
             Variant data = rp.read(it.first);
             if(rp.type().flags() & MetaType::BASE_OBJECT) {
                 Object *ro = *(reinterpret_cast<Object **>(data.data()));
 
-                for(auto item : array) {
-                    if(item.first == ro) {
-                        ro = item.second;
-                        break;
-                    }
+                auto clone = clones.find(ro);
+                if(clone != clones.end()) {
+                    ro = clone->second;
                 }
 
                 data = Variant(data.userType(), &ro);
             }
-            lp.write(it.second, data);
+            if(target == meta) {
+                rp.write(it.second, data);
+            } else {
+                target->property(i).write(it.second, data);
+            }
         }
     }
 
@@ -663,7 +760,7 @@ const Object::LinkList &Object::getReceivers() const {
 Object *Object::find(const string &path) {
     PROFILE_FUNCTION();
 
-    unsigned int start = 0;
+    size_t start = 0;
 
     if(path[0] == '/') {
         if(p_ptr->m_pParent) {
@@ -673,29 +770,7 @@ Object *Object::find(const string &path) {
         }
     }
 
-    int index = path.find('/', start);
-    string first = path.substr(start, index - start);
-
-    if(first == p_ptr->m_sName) {
-        start = index + 1;
-        index = path.find('/', start);
-        first = path.substr(start, index - start);
-    }
-
-    for(const auto &it : p_ptr->m_mChildren) {
-        if(it->p_ptr->m_sName == first) {
-            if(index > -1) {
-                Object *o = it->find(path.substr(index + 1));
-                if(o) {
-                    return o;
-                }
-            } else {
-                return it;
-            }
-        }
-    }
-
-    return nullptr;
+    return ObjectPrivate::resolve(this, path, start);
 }
 /*!
     Makes the object a child of \a parent at given \a position.
@@ -728,6 +803,10 @@ void Object::setName(const string &name) {
     PROFILE_FUNCTION();
     if(!name.empty()) {
         p_ptr->m_sName = name;
+        p_ptr->m_NameHash = ObjectPrivate::hashName(name.data(), name.size());
+        if(p_ptr->m_pParent) {
+            p_ptr->m_pParent->p_ptr->invalidateIndex();
+        }
     }
 }
 /*!
@@ -741,6 +820,7 @@ void Object::addChild(Object *child, int32_t position) {
         } else {
             p_ptr->m_mChildren.insert(next(p_ptr->m_mChildren.begin(), position), child);
         }
+        p_ptr->invalidateIndex();
     }
 }
 /*!
@@ -752,6 +832,7 @@ void Object::removeChild(Object *child) {
     while(it != p_ptr->m_mChildren.end()) {
         if(*it == child) {
             p_ptr->m_mChildren.erase(it);
+            p_ptr->invalidateIndex();
             return;
         }
         it++;
@@ -8,9 +8,17 @@
 
 #include "math/amath.h"
 
+#include <cstring>
+
+#define BINARY_MAGIC    0x4E435354 // TSCN
+#define BINARY_VERSION  1
+#define EXTERNAL        0xFFFFFFFF
+
 static ObjectSystem::FactoryMap s_Factories;
 static ObjectSystem::GroupMap   s_Groups;
 
+static mutex s_UUIDMutex;
+
 /*!
     \class ObjectSystem
     \brief The ObjectSystem responds for object management.
@@ -94,6 +102,7 @@ void ObjectSystem::processEvents() {
 
     Object::processEvents();
 
+    lock_guard<recursive_mutex> locker(m_Mutex);
     auto it = m_ObjectList.begin();
     while(it != m_ObjectList.end()) {
         Object *o = *it;
@@ -182,7 +191,10 @@ ObjectSystem::FactoryPair *ObjectSystem::metaFactory(const string &uri) {
     PROFILE_FUNCTION();
     FactoryMap::iterator it = s_Factories.find(uri);
     if(it == s_Factories.end()) {
-        it  = s_Factories.find(s_Groups[uri]);
+        auto group = s_Groups.find(uri);
+        if(group != s_Groups.end()) {
+            it = s_Factories.find(group->second);
+        }
     }
     if(it != s_Factories.end()) {
         return &((*it).second);
@@ -190,6 +202,327 @@ ObjectSystem::FactoryPair *ObjectSystem::metaFactory(const string &uri) {
     return nullptr;
 }
 
+namespace {
+    class BinaryWriter {
+    public:
+        void write(const void *data, uint32_t size) {
+            size_t offset = m_Data.size();
+            m_Data.resize(offset + size);
+            if(size) {
+                memcpy(&m_Data[offset], data, size);
+            }
+        }
+
+        void writeUInt(uint32_t value) {
+            write(&value, sizeof(uint32_t));
+        }
+
+        void writeString(const string &value) {
+            writeUInt(static_cast<uint32_t>(value.size()));
+            write(value.data(), static_cast<uint32_t>(value.size()));
+        }
+
+        void writeBlob(const ByteArray &value) {
+            writeUInt(static_cast<uint32_t>(value.size()));
+            write(value.data(), static_cast<uint32_t>(value.size()));
+        }
+
+        void writeValue(const Variant &value) {
+            uint8_t type = static_cast<uint8_t>(value.type());
+            switch(value.type()) {
+                case MetaType::INVALID: {
+                    write(&type, 1);
+                } break;
+                case MetaType::BOOLEAN: {
+                    write(&type, 1);
+                    uint8_t data = value.toBool() ? 1 : 0;
+                    write(&data, 1);
+                } break;
+                case MetaType::INTEGER: {
+                    write(&type, 1);
+                    int32_t data = value.toInt();
+                    write(&data, sizeof(int32_t));
+                } break;
+                case MetaType::FLOAT: {
+                    write(&type, 1);
+                    float data = value.toFloat();
+                    write(&data, sizeof(float));
+                } break;
+                case MetaType::STRING: {
+                    write(&type, 1);
+                    writeString(value.toString());
+                } break;
+                case MetaType::VECTOR2: {
+                    write(&type, 1);
+                    Vector2 data = value.value<Vector2>();
+                    write(&data, sizeof(Vector2));
+                } break;
+                case MetaType::VECTOR3: {
+                    write(&type, 1);
+                    Vector3 data = value.value<Vector3>();
+                    write(&data, sizeof(Vector3));
+                } break;
+                case MetaType::VECTOR4: {
+                    write(&type, 1);
+                    Vector4 data = value.value<Vector4>();
+                    write(&data, sizeof(Vector4));
+                } break;
+                case MetaType::QUATERNION: {
+                    write(&type, 1);
+                    Quaternion data = value.value<Quaternion>();
+                    write(&data, sizeof(Quaternion));
+                } break;
+                case MetaType::MATRIX3: {
+                    write(&type, 1);
+                    Matrix3 data = value.value<Matrix3>();
+                    write(&data, sizeof(Matrix3));
+                } break;
+                case MetaType::MATRIX4: {
+                    write(&type, 1);
+                    Matrix4 data = value.value<Matrix4>();
+                    write(&data, sizeof(Matrix4));
+                } break;
+                default: { // Containers and other types are stored in BSON
+                    type = MetaType::VARIANTLIST;
+                    write(&type, 1);
+                    writeBlob(Bson::save(VariantList({value})));
+                } break;
+            }
+        }
+
+        ByteArray m_Data;
+    };
+
+    class BinaryReader {
+    public:
+        explicit BinaryReader(const ByteArray &data) :
+                m_Data(data),
+                m_Offset(0),
+                m_Valid(true) {
+
+        }
+
+        bool read(void *data, uint32_t size) {
+            if(!m_Valid || m_Offset + size > m_Data.size()) {
+                m_Valid = false;
+                return false;
+            }
+            if(size) {
+                memcpy(data, &m_Data[m_Offset], size);
+            }
+            m_Offset += size;
+            return true;
+        }
+
+        uint32_t readUInt() {
+            uint32_t result = 0;
+            read(&result, sizeof(uint32_t));
+            return result;
+        }
+
+        string readString() {
+            uint32_t size = readUInt();
+            if(!m_Valid || m_Offset + size > m_Data.size()) {
+                m_Valid = false;
+                return string();
+            }
+            string result(reinterpret_cast<const char *>(m_Data.data()) + m_Offset, size);
+            m_Offset += size;
+            return result;
+        }
+
+        ByteArray readBlob() {
+            uint32_t size = readUInt();
+            if(!m_Valid || m_Offset + size > m_Data.size()) {
+                m_Valid = false;
+                return ByteArray();
+            }
+            ByteArray result(m_Data.begin() + m_Offset, m_Data.begin() + m_Offset + size);
+            m_Offset += size;
+            return result;
+        }
+
+        template<typename T>
+        Variant readRaw() {
+            T data;
+            read(&data, sizeof(T));
+            return data;
+        }
+
+        Variant readValue() {
+            uint8_t type = MetaType::INVALID;
+            read(&type, 1);
+            switch(type) {
+                case MetaType::BOOLEAN: {
+                    uint8_t data = 0;
+                    read(&data, 1);
+                    return (data != 0);
+                }
+                case MetaType::INTEGER: {
+                    int32_t data = 0;
+                    read(&data, sizeof(int32_t));
+                    return data;
+                }
+                case MetaType::FLOAT: return readRaw<float>();
+                case MetaType::STRING: return readString();
+                case MetaType::VECTOR2: return readRaw<Vector2>();
+                case MetaType::VECTOR3: return readRaw<Vector3>();
+                case MetaType::VECTOR4: return readRaw<Vector4>();
+                case MetaType::QUATERNION: return readRaw<Quaternion>();
+                case MetaType::MATRIX3: return readRaw<Matrix3>();
+                case MetaType::MATRIX4: return readRaw<Matrix4>();
+                case MetaType::VARIANTLIST: {
+                    VariantList list = Bson::load(readBlob()).toList();
+                    if(!list.empty()) {
+                        return list.front();
+                    }
+                } break;
+                case MetaType::INVALID: break;
+                default: m_Valid = false; break;
+            }
+            return Variant();
+        }
+
+        const ByteArray &m_Data;
+
+        size_t m_Offset;
+
+        bool m_Valid;
+    };
+
+    struct BinaryType {
+        string name;
+
+        vector<string> properties;
+    };
+
+    struct BinaryLink {
+        uint32_t sender;
+
+        string signal;
+
+        uint32_t receiver;
+
+        string method;
+    };
+
+    struct BinaryObject {
+        uint32_t type;
+
+        uint32_t uuid;
+
+        uint32_t parent;
+
+        uint32_t parentUuid;
+
+        string name;
+
+        vector<Variant> properties;
+
+        vector<BinaryLink> links;
+
+        VariantMap user;
+    };
+
+    struct BinaryScene {
+        vector<BinaryType> types;
+
+        vector<BinaryObject> objects;
+    };
+
+    bool parseBinary(const ByteArray &data, BinaryScene &scene) {
+        PROFILE_FUNCTION();
+        BinaryReader reader(data);
+        if(reader.readUInt() != BINARY_MAGIC || reader.readUInt() != BINARY_VERSION) {
+            return false;
+        }
+
+        uint32_t count = reader.readUInt();
+        if(count > data.size()) {
+            return false;
+        }
+        scene.types.resize(count);
+        for(auto &type : scene.types) {
+            type.name = reader.readString();
+            uint32_t properties = reader.readUInt();
+            if(!reader.m_Valid || properties > data.size()) {
+                return false;
+            }
+            type.properties.resize(properties);
+            for(auto &property : type.properties) {
+                property = reader.readString();
+            }
+        }
+
+        count = reader.readUInt();
+        if(count > data.size()) {
+            return false;
+        }
+        scene.objects.resize(count);
+        for(uint32_t i = 0; i < count && reader.m_Valid; i++) {
+            BinaryObject &object = scene.objects[i];
+            object.type = reader.readUInt();
+            object.uuid = reader.readUInt();
+            object.parent = reader.readUInt();
+            object.parentUuid = reader.readUInt();
+            object.name = reader.readString();
+            // Parents are always stored before their children
+            if(object.type >= scene.types.size() || (object.parent != EXTERNAL && object.parent >= i)) {
+                return false;
+            }
+
+            object.properties.resize(scene.types[object.type].properties.size());
+            for(auto &property : object.properties) {
+                property = reader.readValue();
+            }
+
+            uint32_t links = reader.readUInt();
+            if(!reader.m_Valid || links > data.size()) {
+                return false;
+            }
+            object.links.resize(links);
+            for(auto &link : object.links) {
+                link.sender = reader.readUInt();
+                link.signal = reader.readString();
+                link.receiver = reader.readUInt();
+                link.method = reader.readString();
+            }
+
+            object.user = Bson::load(reader.readBlob(), MetaType::VARIANTMAP).toMap();
+        }
+
+        return reader.m_Valid;
+    }
+
+    VariantList toFields(const BinaryScene &scene, const BinaryObject &object) {
+        const BinaryType &type = scene.types[object.type];
+
+        VariantList result;
+        result.push_back(type.name);
+        result.push_back(static_cast<int32_t>(object.uuid));
+        result.push_back(static_cast<int32_t>(object.parentUuid));
+        result.push_back(object.name);
+
+        VariantMap properties;
+        for(size_t p = 0; p < object.properties.size(); p++) {
+            if(object.properties[p].isValid()) {
+                properties[type.properties[p]] = object.properties[p];
+            }
+        }
+        result.push_back(properties);
+
+        VariantList links;
+        for(auto &link : object.links) {
+            links.push_back(VariantList({static_cast<int32_t>(link.sender), link.signal,
+                                         static_cast<int32_t>(link.receiver), link.method}));
+        }
+        result.push_back(links);
+        result.push_back(object.user);
+
+        return result;
+    }
+}
+
 typedef list<const Object *> ObjectArray;
 void enumObjects(const Object *object, ObjectArray &list) {
     PROFILE_FUNCTION();
@@ -365,11 +698,275 @@ Object *ObjectSystem::toObject(const Variant &variant, Object *root) {
 
     return result;
 }
+/*!
+    Returns the compact binary representation of the objects \a variant produced by toVariant() or loaded from JSON.
+    The binary data contains the table of the object types with the property names in MetaObject order, each object
+    refers to its parent by index and stores the property values in the order of its type.
+    The result can be loaded with binaryToObject() or converted back to Variant with fromBinary() to keep the JSON
+    representation for editing.
+*/
+ByteArray ObjectSystem::toBinary(const Variant &variant) {
+    PROFILE_FUNCTION();
+    VariantList objects = variant.toList();
+
+    vector<BinaryType> types;
+    unordered_map<string, uint32_t> typeIndices;
+    vector<unordered_map<string, uint32_t>> propertyIndices;
+    unordered_map<uint32_t, uint32_t> objectIndices;
+
+    vector<const VariantList *> records;
+    vector<uint32_t> recordTypes;
+
+    // Build the type table
+    for(auto &it : objects) {
+        const VariantList *o = reinterpret_cast<const VariantList *>(it.data());
+        if(it.type() != MetaType::VARIANTLIST || o == nullptr || o->size() < 7) {
+            continue;
+        }
+        auto i = o->begin();
+        string type = i->toString();
+
+        auto t = typeIndices.find(type);
+        uint32_t index;
+        if(t == typeIndices.end()) {
+            index = static_cast<uint32_t>(types.size());
+            typeIndices[type] = index;
+            types.push_back({type, {}});
+            propertyIndices.push_back({});
+
+            FactoryPair *factory = metaFactory(type);
+            if(factory && factory->first) {
+                const MetaObject *meta = factory->first;
+                for(int p = 0; p < meta->propertyCount(); p++) {
+                    MetaProperty property = meta->property(p);
+                    if(property.isValid()) {
+                        propertyIndices.back()[property.name()] = static_cast<uint32_t>(types.back().properties.size());
+                        types.back().properties.push_back(property.name());
+                    }
+                }
+            }
+        } else {
+            index = t->second;
+        }
+
+        // Keep the properties which are unknown for the type
+        const VariantMap &properties = *reinterpret_cast<const VariantMap *>(std::next(i, 4)->data());
+        for(auto &property : properties) {
+            if(propertyIndices[index].find(property.first) == propertyIndices[index].end()) {
+                propertyIndices[index][property.first] = static_cast<uint32_t>(types[index].properties.size());
+                types[index].properties.push_back(property.first);
+            }
+        }
+
+        objectIndices[static_cast<uint32_t>(std::next(i, 1)->toInt())] = static_cast<uint32_t>(records.size());
+        records.push_back(o);
+        recordTypes.push_back(index);
+    }
+
+    BinaryWriter writer;
+    writer.writeUInt(BINARY_MAGIC);
+    writer.writeUInt(BINARY_VERSION);
+
+    writer.writeUInt(static_cast<uint32_t>(types.size()));
+    for(auto &type : types) {
+        writer.writeString(type.name);
+        writer.writeUInt(static_cast<uint32_t>(type.properties.size()));
+        for(auto &property : type.properties) {
+            writer.writeString(property);
+        }
+    }
+
+    writer.writeUInt(static_cast<uint32_t>(records.size()));
+    for(size_t r = 0; r < records.size(); r++) {
+        auto i = records[r]->begin();
+        i++;
+        uint32_t uuid = static_cast<uint32_t>(i->toInt());
+        i++;
+        uint32_t parentUuid = static_cast<uint32_t>(i->toInt());
+        i++;
+        string name = i->toString();
+        i++;
+
+        uint32_t parent = EXTERNAL;
+        auto p = objectIndices.find(parentUuid);
+        if(p != objectIndices.end() && p->second < r) {
+            parent = p->second;
+        }
+
+        writer.writeUInt(recordTypes[r]);
+        writer.writeUInt(uuid);
+        writer.writeUInt(parent);
+        writer.writeUInt(parentUuid);
+        writer.writeString(name);
+
+        const VariantMap &properties = *reinterpret_cast<const VariantMap *>(i->data());
+        for(auto &property : types[recordTypes[r]].properties) {
+            auto v = properties.find(property);
+            writer.writeValue((v != properties.end() && v->second.type() < MetaType::USERTYPE) ? v->second : Variant());
+        }
+        i++;
+
+        vector<const VariantList *> links;
+        for(auto &link : *reinterpret_cast<const VariantList *>(i->data())) {
+            const VariantList *l = reinterpret_cast<const VariantList *>(link.data());
+            if(link.type() == MetaType::VARIANTLIST && l && l->size() == 4) {
+                links.push_back(l);
+            }
+        }
+        writer.writeUInt(static_cast<uint32_t>(links.size()));
+        for(auto link : links) {
+            auto l = link->begin();
+            writer.writeUInt(static_cast<uint32_t>((l++)->toInt()));
+            writer.writeString((l++)->toString());
+            writer.writeUInt(static_cast<uint32_t>((l++)->toInt()));
+            writer.writeString(l->toString());
+        }
+        i++;
+
+        writer.writeBlob(Bson::save(i->toMap()));
+    }
+
+    return writer.m_Data;
+}
+/*!
+    Returns Variant based representation of the binary \a data produced by toBinary().
+    The result has the same layout as toVariant() and can be saved to JSON.
+*/
+Variant ObjectSystem::fromBinary(const ByteArray &data) {
+    PROFILE_FUNCTION();
+    BinaryScene scene;
+    if(!parseBinary(data, scene)) {
+        return Variant();
+    }
+
+    VariantList result;
+    for(auto &it : scene.objects) {
+        result.push_back(toFields(scene, it));
+    }
+    return result;
+}
+/*!
+    Returns object deserialized from the binary \a data produced by toBinary().
+    Works like toObject() but creates the objects directly by the resolved types, attaches them to the parents by index
+    and writes the properties by MetaProperty without the lookup by name.
+    Objects with unknown types are restored as Invalid objects to keep all fields.
+*/
+Object *ObjectSystem::binaryToObject(const ByteArray &data, Object *root) {
+    PROFILE_FUNCTION();
+    BinaryScene scene;
+    if(!parseBinary(data, scene)) {
+        return nullptr;
+    }
+
+    // Resolve the types and properties once
+    vector<FactoryPair *> factories(scene.types.size(), nullptr);
+    vector<vector<MetaProperty>> properties(scene.types.size());
+    for(size_t t = 0; t < scene.types.size(); t++) {
+        FactoryPair *factory = metaFactory(scene.types[t].name);
+        if(factory && factory->first && factory->second) {
+            factories[t] = factory;
+            const MetaObject *meta = factory->first;
+            for(auto &it : scene.types[t].properties) {
+                int index = meta->indexOfProperty(it.c_str());
+                properties[t].push_back((index > -1) ? meta->property(index) : MetaProperty(nullptr));
+            }
+        }
+    }
+
+    Object *result = nullptr;
+
+    // Create all declared objects
+    vector<Object *> array(scene.objects.size(), nullptr);
+    unordered_map<uint32_t, Object *> uuids;
+    for(size_t o = 0; o < scene.objects.size(); o++) {
+        BinaryObject &it = scene.objects[o];
+
+        Object *parent = root;
+        if(it.parent != EXTERNAL) {
+            parent = array[it.parent];
+        } else if(root) {
+            Object *obj = findObject(it.parentUuid, root);
+            if(obj) {
+                parent = obj;
+            }
+        }
+
+        Object *object = nullptr;
+        FactoryPair *factory = factories[it.type];
+        if(factory) {
+            object = factory->second->instantiateObject(factory->first, parent);
+            object->setType(scene.types[it.type].name);
+            object->setName(it.name);
+        } else {
+            // Create a dummy object to keep all fields
+            Invalid *invalid = new Invalid();
+            invalid->loadData(toFields(scene, it));
+            object = invalid;
+            if(parent) {
+                object->setSystem(parent->system());
+            }
+            object->setName(it.name);
+            object->setParent(parent);
+        }
+        object->setUUID(it.uuid);
+        array[o] = object;
+        uuids[it.uuid] = object;
+
+        // Load user data
+        object->loadObjectData(it.user);
+
+        if(result == nullptr && object->parent() == root) {
+            result = object;
+        }
+    }
+
+    for(size_t o = 0; o < scene.objects.size(); o++) {
+        BinaryObject &it = scene.objects[o];
+        Object *object = array[o];
+
+        // Load base properties
+        bool direct = (factories[it.type] && object->metaObject() == factories[it.type]->first);
+        for(size_t p = 0; p < it.properties.size(); p++) {
+            const Variant &value = it.properties[p];
+            if(!value.isValid()) {
+                continue;
+            }
+            if(direct && properties[it.type][p].isValid()) {
+                properties[it.type][p].write(object, value);
+            } else {
+                object->setProperty(scene.types[it.type].properties[p].c_str(), value);
+            }
+        }
+        // Restore connections
+        for(auto &link : it.links) {
+            auto sender = uuids.find(link.sender);
+            auto receiver = uuids.find(link.receiver);
+            connect((sender != uuids.end()) ? sender->second : nullptr, link.signal.c_str(),
+                    (receiver != uuids.end()) ? receiver->second : nullptr, link.method.c_str());
+        }
+        // Load user data
+        object->loadUserData(it.user);
+    }
+
+    return result;
+}
+/*!
+    Returns true if \a data contains the binary representation produced by toBinary().
+*/
+bool ObjectSystem::isBinary(const ByteArray &data) {
+    uint32_t magic = 0;
+    if(data.size() >= sizeof(uint32_t) * 2) {
+        memcpy(&magic, data.data(), sizeof(uint32_t));
+    }
+    return magic == BINARY_MAGIC;
+}
 /*!
     Returns the new unique ID based on random number generator.
+    \note This method is thread safe.
 */
 uint32_t ObjectSystem::generateUUID() {
     PROFILE_FUNCTION();
+    lock_guard<mutex> locker(s_UUIDMutex);
     return dist(mt);
 }
 /*!
@@ -414,10 +1011,12 @@ Object *ObjectSystem::findObject(uint32_t uuid, Object *root) {
     return nullptr;
 }
 /*!
-    Adds an \a object to main pull of objects in ObjectSystem
+    Adds an \a object to main pull of objects in ObjectSystem.
+    Objects can be created and destroyed from any thread, the pull is guarded by mutex.
 */
 void ObjectSystem::addObject(Object *object) {
     PROFILE_FUNCTION();
+    lock_guard<recursive_mutex> locker(m_Mutex);
     m_ObjectList.push_back(object);
 }
 /*!
@@ -425,6 +1024,7 @@ void ObjectSystem::addObject(Object *object) {
 */
 void ObjectSystem::removeObject(Object *object) {
     PROFILE_FUNCTION();
+    lock_guard<recursive_mutex> locker(m_Mutex);
     if(m_SuspendObject == nullptr) {
         m_ObjectList.remove(object);
     }
@@ -56,6 +56,40 @@ void Property_animation() {
     QCOMPARE(object.getVector(), Vector2(0.5, 1.0f));
 }
 
+void Curve_cursor() {
+    AnimationCurve curve;
+    for(int i = 0; i < 5; i++) {
+        AnimationCurve::KeyFrame key;
+        key.m_Value = i * 2.0f;
+        key.m_Position = i * 0.25f;
+        key.m_Type = AnimationCurve::KeyFrame::Linear;
+        curve.m_Keys.push_back(key);
+    }
+
+    uint32_t cursor = 0;
+    QCOMPARE(curve.value(0.125f, cursor), 1.0f);
+    QCOMPARE(cursor, 0U);
+    QCOMPARE(curve.value(0.625f, cursor), 5.0f);
+    QCOMPARE(cursor, 2U);
+    QCOMPARE(curve.value(0.1f, cursor), curve.value(0.1f));
+    QCOMPARE(curve.value(2.0f, cursor), 8.0f);
+
+    int32_t b, e;
+    curve.frames(b, e, 0.5f);
+    QCOMPARE(b, 2);
+    QCOMPARE(e, 2);
+    curve.frames(b, e, 0.6f);
+    QCOMPARE(b, 2);
+    QCOMPARE(e, 3);
+    // Out of range positions keep only the nearest key
+    curve.frames(b, e, -0.1f);
+    QCOMPARE(b, -1);
+    QCOMPARE(e, 0);
+    curve.frames(b, e, 2.0f);
+    QCOMPARE(b, 4);
+    QCOMPARE(e, -1);
+}
+
 } REGISTER(AnimationTest)
 
 #include "tst_animation.moc"
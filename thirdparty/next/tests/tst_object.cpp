@@ -173,6 +173,47 @@ void Find_object() {
     }
 }
 
+void Find_object_updates() {
+    Object root;
+    root.setName("Root");
+
+    // Wide node uses the child index
+    vector<Object *> children;
+    for(int i = 0; i < 32; i++) {
+        Object *child = new Object;
+        child->setName(string("Child") + to_string(i));
+        child->setParent(&root);
+        children.push_back(child);
+    }
+    Object *leaf = new Object;
+    leaf->setName("Leaf");
+    leaf->setParent(children[20]);
+
+    QCOMPARE(root.find("Child20/Leaf"), leaf);
+    QCOMPARE(root.find("/Root/Child20/Leaf"), leaf);
+    QCOMPARE(root.find("Child5"), children[5]);
+
+    // Lookups must follow the renaming
+    children[20]->setName("Renamed");
+    QCOMPARE(root.find("Child20/Leaf") == nullptr, true);
+    QCOMPARE(root.find("Renamed/Leaf"), leaf);
+
+    // and the reparenting
+    leaf->setParent(children[5]);
+    QCOMPARE(root.find("Renamed/Leaf") == nullptr, true);
+    QCOMPARE(root.find("Child5/Leaf"), leaf);
+
+    // Same named siblings are searched in order
+    Object *other = new Object;
+    other->setName("Leaf");
+    other->setParent(children[6]);
+    children[6]->setName("Child5");
+    QCOMPARE(root.find("Child5/Leaf"), leaf);
+
+    delete leaf;
+    QCOMPARE(root.find("Child5/Leaf"), other);
+}
+
 void Clone_object() {
     ObjectSystem objectSystem;
     TestObject::registerClassFactory(&objectSystem);
@@ -200,6 +241,39 @@ void Clone_object() {
     delete obj1;
 }
 
+void Clone_references() {
+    ObjectSystem objectSystem;
+    TestObject::registerClassFactory(&objectSystem);
+
+    TestObject external;
+
+    TestObject *obj1 = ObjectSystem::objectCreate<TestObject>("Root");
+    TestObject *obj2 = ObjectSystem::objectCreate<TestObject>("Child", obj1);
+    TestObject *obj3 = ObjectSystem::objectCreate<TestObject>("Leaf", obj2);
+
+    obj1->setResource(obj3);
+    obj2->setResource(&external);
+
+    TestObject *clone = dynamic_cast<TestObject *>(obj1->clone());
+    QCOMPARE((clone != nullptr), true);
+
+    TestObject *child = dynamic_cast<TestObject *>(clone->getChildren().front());
+    QCOMPARE((child != nullptr), true);
+    QCOMPARE(child->parent() == clone, true);
+    QCOMPARE(child->clonedFrom(), obj2->uuid());
+
+    TestObject *leaf = dynamic_cast<TestObject *>(child->getChildren().front());
+    QCOMPARE((leaf != nullptr), true);
+    QCOMPARE(leaf->parent() == child, true);
+
+    // References inside the hierarchy are remapped to the cloned objects
+    QCOMPARE(clone->getResource() == leaf, true);
+    QCOMPARE(child->getResource() == &external, true);
+
+    delete clone;
+    delete obj1;
+}
+
 } REGISTER(ObjectTest)
 
 #include "tst_object.moc"
@@ -4,6 +4,7 @@
 
 #include "json.h"
 #include "bson.h"
+#include "memorypool.h"
 
 class SecondObject : public TestObject {
     A_REGISTER(SecondObject, TestObject, Test)
@@ -119,6 +120,69 @@ void Serialize_Desirialize_Object() {
     delete obj1;
 }
 
+void Binary_Serialize_Object() {
+    ObjectSystem objectSystem;
+    TestObject::registerClassFactory(&objectSystem);
+
+    TestObject *obj1 = ObjectSystem::objectCreate<TestObject>("MainObject");
+    TestObject *obj2 = ObjectSystem::objectCreate<TestObject>("TestComponent2", obj1);
+    TestObject *obj3 = ObjectSystem::objectCreate<TestObject>("TestComponent3", obj2);
+
+    obj1->setVector(Vector2(10.0f, 20.0f));
+    obj3->setVector(Vector2(-1.0f, 5.0f));
+
+    QCOMPARE(Object::connect(obj1, _SIGNAL(signal(int)), obj2, _SLOT(setSlot(int))), true);
+    QCOMPARE(Object::connect(obj2, _SIGNAL(signal(int)), obj3, _SLOT(setSlot(int))), true);
+
+    Variant variant = ObjectSystem::toVariant(obj1);
+    ByteArray bytes = ObjectSystem::toBinary(variant);
+    QCOMPARE(ObjectSystem::isBinary(bytes), true);
+    QCOMPARE(ObjectSystem::isBinary(Bson::save(variant)), false);
+
+    // The binary data converts back to the same representation as JSON
+    QCOMPARE((Json::save(ObjectSystem::fromBinary(bytes)) == Json::save(variant)), true);
+
+    Object *result = ObjectSystem::binaryToObject(bytes);
+    QCOMPARE((result != nullptr), true);
+    QCOMPARE(compare(*obj1, *result), true);
+    QCOMPARE((obj1->uuid() == result->uuid()), true);
+    QCOMPARE((result->getReceivers().size() == obj1->getReceivers().size()), true);
+
+    TestObject *leaf = dynamic_cast<TestObject *>(result->find("TestComponent2/TestComponent3"));
+    QCOMPARE((leaf != nullptr), true);
+    QCOMPARE((leaf->getVector() == obj3->getVector()), true);
+
+    // Truncated data must be rejected
+    bytes.resize(bytes.size() / 2);
+    QCOMPARE((ObjectSystem::binaryToObject(bytes) == nullptr), true);
+
+    delete result;
+    delete obj1;
+}
+
+void Spawn_Despawn_Benchmark() {
+    ObjectSystem objectSystem;
+    TestObject::registerClassFactory(&objectSystem);
+
+    const int count = 10000;
+    vector<Object *> objects(count);
+
+    QBENCHMARK {
+        for(int i = 0; i < count; i++) {
+            objects[i] = ObjectSystem::objectCreate<TestObject>();
+            objects[i]->deleteLater();
+        }
+        objectSystem.processEvents();
+    }
+
+    // Released blocks are reused, so the pool doesn't grow after the first iteration
+    size_t reserved = MemoryPool::reservedSize();
+    for(int i = 0; i < count; i++) {
+        delete ObjectSystem::objectCreate<TestObject>();
+    }
+    QCOMPARE(MemoryPool::reservedSize(), reserved);
+}
+
 } REGISTER(ObjectSystemTest)
 
 #include "tst_objectsystem.moc"
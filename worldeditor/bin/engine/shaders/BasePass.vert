@@ -66,22 +66,55 @@ Vertex staticMesh(vec3 v, vec3 t, vec3 n, mat3 r) {
 #endif
 
 #ifdef TYPE_SKINNED
+// skinParams: x - palette row, y - 1.0 if bones are packed as dual quaternions
 Vertex skinnedMesh(vec3 v, vec3 t, vec3 n, vec4 bones, vec4 weights) {
     Vertex result;
     result.v = vec3( 0.0 );
     result.t = vec3( 0.0 );
     result.n = vec3( 0.0 );
 
+    int y = int(skinParams.x);
+
+    if(skinParams.y > 0.5) {
+        vec4 real = vec4( 0.0 );
+        vec4 dual = vec4( 0.0 );
+        vec4 pivot = texelFetch(skinMatrices, ivec2(int(bones.x) * 2, y), 0);
+        for(int i = 0; i < 4; i++) {
+            if(weights.x > 0.0) {
+                int x = int(bones.x) * 2; // index
+
+                vec4 r = texelFetch(skinMatrices, ivec2(x,     y), 0);
+                vec4 d = texelFetch(skinMatrices, ivec2(x + 1, y), 0);
+
+                float w = (dot(pivot, r) < 0.0) ? -weights.x : weights.x;
+                real += r * w;
+                dual += d * w;
+
+                bones = bones.yzwx;
+                weights = weights.yzwx;
+            }
+        }
+        float len = length(real);
+        real /= len;
+        dual /= len;
+
+        vec3 pos = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+
+        result.v = v + 2.0 * cross(real.xyz, cross(real.xyz, v) + real.w * v) + pos;
+        result.n = n + 2.0 * cross(real.xyz, cross(real.xyz, n) + real.w * n);
+        result.t = t + 2.0 * cross(real.xyz, cross(real.xyz, t) + real.w * t);
+
+        return result;
+    }
+
     vec4 finalVector = vec4( 0.0 );
     for(int i = 0; i < 4; i++) {
         if(weights.x > 0.0) {
-            float width = 1.0 / 512.0;
             int x = int(bones.x) * 3; // index
-            int y = 0;
 
-            vec4 m1 = texture(skinMatrices, vec2(x,     y) * width);
-            vec4 m2 = texture(skinMatrices, vec2(x + 1, y) * width);
-            vec4 m3 = texture(skinMatrices, vec2(x + 2, y) * width);
+            vec4 m1 = texelFetch(skinMatrices, ivec2(x,     y), 0);
+            vec4 m2 = texelFetch(skinMatrices, ivec2(x + 1, y), 0);
+            vec4 m3 = texelFetch(skinMatrices, ivec2(x + 2, y), 0);
 
             mat4 m44 = mat4(vec4(m1.xyz, 0.0),
                             vec4(m2.xyz, 0.0),
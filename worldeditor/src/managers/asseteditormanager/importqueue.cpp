@@ -21,6 +21,7 @@ ImportQueue::ImportQueue(Engine *engine, QWidget *parent) :
 
     AssetManager *manager = AssetManager::instance();
     connect(manager, &AssetManager::importStarted, this, &ImportQueue::onStarted);
+    connect(manager, &AssetManager::importProgress, this, &ImportQueue::onProgress);
     connect(manager, &AssetManager::imported, this, &ImportQueue::onProcessed);
 
     connect(manager, &AssetManager::importFinished, this, &ImportQueue::onImportFinished);
@@ -38,12 +39,15 @@ ImportQueue::~ImportQueue() {
 }
 
 void ImportQueue::onProcessed(const QString &path, const QString &type) {
-    ui->progressBar->setValue(ui->progressBar->value() + 1);
-
     QString guid = QString::fromStdString(AssetManager::instance()->pathToGuid(path.toStdString()));
     m_UpdateQueue[guid] = type;
 }
 
+void ImportQueue::onProgress(int processed, int count) {
+    ui->progressBar->setMaximum(count);
+    ui->progressBar->setValue(processed);
+}
+
 void ImportQueue::onStarted(int count, const QString &action) {
     show();
     ui->progressBar->setValue(0);
@@ -72,6 +76,7 @@ void ImportQueue::onImportFinished() {
 
 void ImportQueue::keyPressEvent(QKeyEvent *e) {
     if(e->key() == Qt::Key_Escape) {
+        AssetManager::instance()->cancelImport();
         e->ignore();
     }
 }